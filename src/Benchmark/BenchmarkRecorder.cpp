@@ -0,0 +1,139 @@
+#include "BenchmarkRecorder.hpp"
+
+#include <Utility/OpenGlHeaders.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <string_view>
+
+namespace {
+
+constexpr std::array<std::string_view, BenchmarkRecorder::PHASE_COUNT> PHASE_NAMES{"update", "submit", "execute",
+                                                                                    "finish"};
+
+double millisecondsBetween(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Nearest rank percentile of sorted values
+double percentile(const std::vector<double> &sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    const auto rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+std::string escape(std::string_view text) {
+    std::string escaped;
+    for (const char character : text) {
+        if (character == '"' || character == '\\') {
+            escaped += '\\';
+        }
+        if (static_cast<unsigned char>(character) >= 0x20) {
+            escaped += character;
+        }
+    }
+    return escaped;
+}
+
+std::string glString(GLenum name) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    const auto *string = reinterpret_cast<const char *>(glGetString(name));
+    return string == nullptr ? "unknown" : string;
+}
+
+// {"mean": ..., "p50": ..., "p95": ..., "p99": ..., "max": ...} of the values
+std::string summarize(std::vector<double> values) {
+    std::ranges::sort(values);
+
+    double sum = 0.0;
+    for (const double value : values) {
+        sum += value;
+    }
+    const double mean = values.empty() ? 0.0 : sum / static_cast<double>(values.size());
+
+    return std::format(R"({{"mean": {:.4f}, "p50": {:.4f}, "p95": {:.4f}, "p99": {:.4f}, "max": {:.4f}}})",
+                       mean,
+                       percentile(values, 0.50),
+                       percentile(values, 0.95),
+                       percentile(values, 0.99),
+                       values.empty() ? 0.0 : values.back());
+}
+
+} // namespace
+
+BenchmarkRecorder::BenchmarkRecorder(size_t frames) {
+    m_frames.reserve(frames);
+}
+
+void BenchmarkRecorder::beginFrame() {
+    m_current    = {};
+    m_frameStart = Clock::now();
+    m_phaseStart = m_frameStart;
+}
+
+void BenchmarkRecorder::endPhase(Phase phase) {
+    const Clock::time_point now = Clock::now();
+    m_current.phases.at(phase) += millisecondsBetween(m_phaseStart, now);
+    m_phaseStart = now;
+}
+
+void BenchmarkRecorder::endFrame(const RenderQueue::Stats &stats) {
+    m_current.milliseconds = millisecondsBetween(m_frameStart, Clock::now());
+    m_current.stats        = stats;
+    m_frames.push_back(m_current);
+}
+
+void BenchmarkRecorder::writeReport(const std::filesystem::path &path, const Info &info) const {
+    auto collect = [this](const std::function<double(const Frame &)> &value) {
+        std::vector<double> values;
+        values.reserve(m_frames.size());
+        for (const auto &frame : m_frames) {
+            values.push_back(value(frame));
+        }
+        return values;
+    };
+
+    std::string phases;
+    for (size_t i = 0; i < PHASE_COUNT; i++) {
+        phases += std::format(R"({}"{}": {})",
+                              i == 0 ? "" : ", ",
+                              PHASE_NAMES.at(i),
+                              summarize(collect([i](const Frame &frame) { return frame.phases.at(i); })));
+    }
+
+    auto count = [&](size_t RenderQueue::Stats::*member) {
+        return summarize(collect([member](const Frame &frame) { return static_cast<double>(frame.stats.*member); }));
+    };
+
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error(std::format("BenchmarkRecorder::writeReport | Failed to open {}", path.string()));
+    }
+
+    file << "{\n";
+    file << std::format(R"(  "cameraPath": "{}",)", escape(info.cameraPath)) << '\n';
+    file << std::format(R"(  "frames": {},)", m_frames.size()) << '\n';
+    file << std::format(R"(  "resolution": [{}, {}],)", info.width, info.height) << '\n';
+    file << std::format(R"(  "vertexFormat": "{}",)", info.vertexFormat) << '\n';
+    file << std::format(R"(  "instances": {},)", info.instances) << '\n';
+    file << std::format(R"(  "instancing": {},)", info.instancing) << '\n';
+    file << std::format(R"(  "renderer": "{}",)", escape(glString(GL_RENDERER))) << '\n';
+    file << std::format(R"(  "version": "{}",)", escape(glString(GL_VERSION))) << '\n';
+    file << std::format(R"(  "frameTimeMs": {},)", summarize(collect([](const Frame &frame) {
+                            return frame.milliseconds;
+                        })))
+         << '\n';
+    file << std::format(R"(  "phaseCpuMs": {{{}}},)", phases) << '\n';
+    file << std::format(R"(  "draws": {},)", count(&RenderQueue::Stats::draws)) << '\n';
+    file << std::format(R"(  "instancesDrawn": {},)", count(&RenderQueue::Stats::instances)) << '\n';
+    file << std::format(R"(  "triangles": {},)", count(&RenderQueue::Stats::triangles)) << '\n';
+    file << std::format(R"(  "programSwitches": {},)", count(&RenderQueue::Stats::programSwitches)) << '\n';
+    file << std::format(R"(  "textureBinds": {})", count(&RenderQueue::Stats::textureBinds)) << '\n';
+    file << "}\n";
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <Render/RenderQueue.hpp>
+
+// Collects per frame timings and draw counts of a benchmark run and writes them out as a JSON report.
+//
+// A frame is split into phases, every call to endPhase() charges the time since the previous mark to that phase.
+class BenchmarkRecorder {
+    public:
+    enum Phase {
+        UPDATE_PHASE,  // asset streaming and the scene graph
+        SUBMIT_PHASE,  // LOD selection and queueing the draws
+        EXECUTE_PHASE, // culling, sorting and issuing the draws
+        FINISH_PHASE,  // waiting for the GPU and the optional frame dump
+        PHASE_COUNT
+    };
+
+    // Run parameters written to the report as they are
+    struct Info {
+        std::string cameraPath;
+        int         width;
+        int         height;
+        std::string vertexFormat;
+        size_t      instances;
+        bool        instancing;
+    };
+
+    explicit BenchmarkRecorder(size_t frames);
+
+    void beginFrame();
+    void endPhase(Phase phase);
+    void endFrame(const RenderQueue::Stats &stats);
+
+    [[nodiscard]] size_t recordedFrames() const noexcept { return m_frames.size(); }
+
+    // Frame time percentiles, CPU time per phase and draw counts, along with the GL implementation that produced them
+    void writeReport(const std::filesystem::path &path, const Info &info) const;
+
+    private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Frame {
+        double                          milliseconds = 0.0;
+        std::array<double, PHASE_COUNT> phases{};
+        RenderQueue::Stats              stats;
+    };
+
+    std::vector<Frame> m_frames;
+    Frame              m_current;
+    Clock::time_point  m_frameStart;
+    Clock::time_point  m_phaseStart;
+};
@@ -0,0 +1,233 @@
+#include "Benchmarks.hpp"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <iostream>
+#include <random>
+
+#include <Render/FrustumCuller.hpp>
+#include <Render/RenderQueue.hpp>
+#include <Scene/SceneGraph.hpp>
+#include <Utility/JobSystem.hpp>
+
+namespace Benchmarks {
+
+void runCulling(const Frustum &frustum, const glm::vec3 &center) {
+    constexpr size_t count      = 100000;
+    constexpr int    iterations = 100;
+    constexpr float  extent     = 500.0f;
+
+    std::mt19937                          generator(42);
+    std::uniform_real_distribution<float> position(-extent, extent);
+    std::uniform_real_distribution<float> radius(0.1f, 5.0f);
+
+    FrustumCuller culler;
+    culler.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        const glm::vec3 offset(position(generator), position(generator), position(generator));
+        culler.add({center + offset, radius(generator)});
+    }
+
+    std::vector<uint32_t> visible;
+    visible.reserve(count);
+
+    double total = 0.0;
+    for (int i = 0; i < iterations; i++) {
+        visible.clear();
+        culler.cull(frustum, visible);
+        total += culler.getStats().milliseconds;
+    }
+
+    std::cout << std::format("FrustumCuller benchmark | {} spheres | {} visible | {:.3f} ms average over {} runs",
+                             count,
+                             visible.size(),
+                             total / iterations,
+                             iterations)
+              << std::endl;
+}
+
+std::vector<LightClusters::Light> createLights(size_t count, const glm::vec3 &center, const glm::vec3 &extent) {
+    std::mt19937                          generator(11);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> range(10.0f, 40.0f);
+    std::uniform_real_distribution<float> angle(glm::radians(20.0f), glm::radians(50.0f));
+
+    std::vector<LightClusters::Light> lights;
+    lights.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        LightClusters::Light light{};
+        light.position = center + glm::vec3(offset(generator), offset(generator), offset(generator)) * extent;
+        light.range    = range(generator);
+
+        // bright enough to stand out at half the range
+        const glm::vec3 color(unit(generator), unit(generator), unit(generator));
+        light.color = color / std::max({color.x, color.y, color.z, 0.01f}) * light.range * light.range / 16.0f;
+
+        if (i % 4 == 3) {
+            light.direction  = glm::vec3(0.0f, -1.0f, 0.0f);
+            light.outerAngle = angle(generator);
+            light.innerAngle = light.outerAngle * 0.7f;
+        }
+        lights.push_back(light);
+    }
+    return lights;
+}
+
+void runLightBinning(const Camera &camera) {
+    constexpr size_t count      = 1000;
+    constexpr int    iterations = 100;
+
+    const glm::vec3 center = camera.getPosition() + glm::vec3(0.0f, 0.0f, -150.0f);
+
+    LightClusters clusters;
+    clusters.getLights() = createLights(count, center, glm::vec3(150.0f, 50.0f, 150.0f));
+
+    const auto average = [&](bool threaded) {
+        clusters.setThreaded(threaded);
+        double total = 0.0;
+        for (int i = 0; i < iterations; i++) {
+            clusters.build(camera.getView(), camera.getProjection(), camera.getNear(), camera.getFar());
+            total += clusters.getStats().milliseconds;
+        }
+        return total / iterations;
+    };
+
+    const double single   = average(false);
+    const double threaded = average(true);
+
+    const LightClusters::Stats &stats = clusters.getStats();
+    std::cout << std::format("LightClusters benchmark | {} lights | {} references in {} of {} froxels | 1 thread "
+                             "{:.3f} ms | {} threads {:.3f} ms | average over {} runs",
+                             count,
+                             stats.references,
+                             stats.occupied,
+                             LightClusters::FROXEL_COUNT,
+                             single,
+                             JobSystem::shared().activeThreads(),
+                             threaded,
+                             iterations)
+              << std::endl;
+
+    clusters.deleteBuffers();
+}
+
+void runSceneGraph() {
+    constexpr size_t objects        = 500;
+    constexpr size_t nodesPerObject = 100;
+
+    SceneGraph                      scene;
+    std::vector<SceneGraph::NodeId> roots;
+
+    for (size_t i = 0; i < objects; i++) {
+        const glm::mat4 offset = glm::translate(glm::mat4(1.0f), glm::vec3(static_cast<float>(i), 0.0f, 0.0f));
+        roots.push_back(scene.add(SceneGraph::NONE, offset));
+
+        // a short chain below a fan of children
+        SceneGraph::NodeId parent = roots.back();
+        for (size_t j = 1; j < nodesPerObject; j++) {
+            const SceneGraph::NodeId node = scene.add(j % 10 == 1 ? roots.back() : parent, glm::mat4(1.0f));
+            parent                        = node;
+        }
+    }
+
+    scene.update();
+    const SceneGraph::Stats full = scene.getStats();
+
+    scene.setLocal(roots[objects / 2], glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+    scene.update();
+    const SceneGraph::Stats single = scene.getStats();
+
+    std::cout << std::format("SceneGraph benchmark | {} nodes | full update {} nodes in {:.3f} ms | moving one object "
+                             "{} nodes in {:.3f} ms",
+                             full.nodes,
+                             full.updatedNodes,
+                             full.milliseconds,
+                             single.updatedNodes,
+                             single.milliseconds)
+              << std::endl;
+}
+
+std::vector<Model::Instance> createInstanceGrid(size_t count, const glm::mat4 &model) {
+    constexpr float spacing = 40.0f;
+
+    const auto side = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+    const auto half = static_cast<float>(side) * spacing * 0.5f;
+
+    std::mt19937                          generator(7);
+    std::uniform_real_distribution<float> channel(0.3f, 1.0f);
+
+    std::vector<Model::Instance> instances;
+    instances.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        const glm::vec3 offset(static_cast<float>(i % side) * spacing - half,
+                               -20.0f,
+                               -static_cast<float>(i / side) * spacing - spacing);
+        instances.push_back({glm::translate(glm::mat4(1.0f), offset) * model,
+                             glm::vec4(channel(generator), channel(generator), channel(generator), 1.0f)});
+    }
+
+    return instances;
+}
+
+void runJobSystem(Model &teapot, ShaderVariants &shaders, const Camera &camera, const glm::mat4 &model) {
+    constexpr size_t count          = 100000;
+    constexpr size_t transformGrain = 4096;
+    constexpr int    iterations     = 20;
+
+    const std::vector<Model::Instance> grid      = createInstanceGrid(count, model);
+    std::vector<Model::Instance>       instances = grid;
+
+    RenderQueue queue;
+    JobSystem  &jobs = JobSystem::shared();
+
+    const auto frame = [&](float angle) {
+        // every teapot spins around its own up axis
+        const glm::mat4 spin = glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 0.0f, 1.0f));
+        jobs.parallelFor(count, transformGrain, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                instances[i].transform = grid[i].transform * spin;
+            }
+        });
+
+        teapot.submitInstances(queue, shaders, instances, camera);
+        queue.prepare(camera.getFrustum());
+        queue.clear();
+    };
+
+    double single = 0.0;
+    for (size_t threads = 1; threads <= jobs.threadCount() + 1; threads++) {
+        jobs.setThreadLimit(threads);
+        frame(0.0f);
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            frame(glm::radians(static_cast<float>(i)));
+        }
+        const double milliseconds =
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() /
+                iterations;
+
+        if (threads == 1) {
+            single = milliseconds;
+        }
+
+        std::cout << std::format("JobSystem benchmark | {} instances | {} visible | {} threads | {:.2f} ms/frame | "
+                                 "{:.2f}x",
+                                 count,
+                                 queue.getCullStats().visible,
+                                 threads,
+                                 milliseconds,
+                                 single / milliseconds)
+                  << std::endl;
+    }
+
+    jobs.setThreadLimit(0);
+    queue.deleteBuffers();
+}
+
+} // namespace Benchmarks
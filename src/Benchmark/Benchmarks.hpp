@@ -0,0 +1,38 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+#include <Camera.hpp>
+#include <ShaderVariants.hpp>
+#include <Model/Model.hpp>
+#include <Render/Frustum.hpp>
+#include <Render/LightClusters.hpp>
+
+// The micro benchmarks started by the --*-benchmark flags, each prints its results and leaves the app running, and
+// the generated scenes they share with the app
+namespace Benchmarks {
+
+// Culls random spheres around the camera and prints the average time of the batch test
+void runCulling(const Frustum &frustum, const glm::vec3 &center);
+
+// Bins 1000 lights in front of the camera on one thread and on the pool and prints the average times
+void runLightBinning(const Camera &camera);
+
+// Builds a 50k node scene and compares a full update with moving a single object
+void runSceneGraph();
+
+// Runs the CPU side of a frame over 100k teapots with 1 to N threads and prints the average frame times: moving every
+// instance, the level of detail selection and draw building of submitInstances, then culling, sorting and packing the
+// queue. Nothing is drawn.
+void runJobSystem(Model &teapot, ShaderVariants &shaders, const Camera &camera, const glm::mat4 &model);
+
+// Scatters count point and spot lights in a box around center, a quarter of them are spot lights pointing down
+std::vector<LightClusters::Light> createLights(size_t count, const glm::vec3 &center, const glm::vec3 &extent);
+
+// Places count copies of a model on a square grid in the XZ plane, each with its own tint
+std::vector<Model::Instance> createInstanceGrid(size_t count, const glm::mat4 &model);
+
+} // namespace Benchmarks
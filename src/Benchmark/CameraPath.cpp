@@ -0,0 +1,63 @@
+#include "CameraPath.hpp"
+
+#include <algorithm>
+#include <format>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <Utility/fs_helpers.hpp>
+
+CameraPath CameraPath::load(const std::filesystem::path &path) {
+    const std::optional<fs_helpers::Resource> resource = fs_helpers::openResource(path);
+    if (!resource.has_value()) {
+        throw std::runtime_error(std::format("CameraPath::load | Failed to open {}", path.string()));
+    }
+
+    std::istringstream file{std::string(resource->text())};
+
+    std::vector<Keyframe> keyframes;
+    std::string           line;
+    size_t                lineNumber = 0;
+
+    while (std::getline(file, line)) {
+        lineNumber++;
+        if (line.empty() || line.starts_with('#')) {
+            continue;
+        }
+
+        std::istringstream stream(line);
+        Keyframe           keyframe{};
+        stream >> keyframe.time >> keyframe.position.x >> keyframe.position.y >> keyframe.position.z >>
+                keyframe.rotation.x >> keyframe.rotation.y;
+
+        if (stream.fail() || (!keyframes.empty() && keyframe.time <= keyframes.back().time)) {
+            throw std::runtime_error(
+                    std::format("CameraPath::load | Invalid keyframe at {}:{}", path.string(), lineNumber));
+        }
+        keyframes.push_back(keyframe);
+    }
+
+    if (keyframes.empty()) {
+        throw std::runtime_error(std::format("CameraPath::load | No keyframes in {}", path.string()));
+    }
+
+    return CameraPath(std::move(keyframes));
+}
+
+CameraPath::Keyframe CameraPath::sample(float time) const {
+    const auto next = std::ranges::upper_bound(m_keyframes, time, {}, &Keyframe::time);
+    if (next == m_keyframes.begin()) {
+        return m_keyframes.front();
+    }
+    if (next == m_keyframes.end()) {
+        return m_keyframes.back();
+    }
+
+    const Keyframe &a = *(next - 1);
+    const Keyframe &b = *next;
+    const float     t = (time - a.time) / (b.time - a.time);
+
+    return {time, a.position + (b.position - a.position) * t, a.rotation + (b.rotation - a.rotation) * t};
+}
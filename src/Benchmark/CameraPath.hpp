@@ -0,0 +1,31 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <filesystem>
+#include <vector>
+
+// Camera keyframes for scripted runs, sampled with linear interpolation.
+//
+// The file has one keyframe per line, "time x y z pitch yaw" with the time in seconds and the angles in degrees as in
+// Camera::getRotation(). Empty lines and lines starting with # are skipped, the times have to increase.
+class CameraPath {
+    public:
+    struct Keyframe {
+        float     time;
+        glm::vec3 position;
+        glm::vec3 rotation; // pitch, yaw, roll
+    };
+
+    static CameraPath load(const std::filesystem::path &path);
+
+    // Clamps to the first and last keyframe outside of the path
+    [[nodiscard]] Keyframe sample(float time) const;
+
+    [[nodiscard]] float duration() const noexcept { return m_keyframes.back().time; }
+
+    private:
+    std::vector<Keyframe> m_keyframes; // never empty
+
+    explicit CameraPath(std::vector<Keyframe> keyframes) : m_keyframes(std::move(keyframes)) {}
+};
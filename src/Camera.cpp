@@ -4,20 +4,46 @@
 #include <Utility/OpenGlHeaders.hpp>
 #include <Utility/Input.hpp>
 
+#include <cmath>
+#include <limits>
+
 Camera::Camera(GLFWwindow *window) : m_window(window) {
     m_projection = glm::perspective(glm::radians(m_fov), m_width / m_height, m_near, m_far);
     m_view       = glm::lookAt(m_position, m_position + m_front, m_up);
 }
 
+float Camera::getProjectedRadius(const BoundingSphere &sphere) const {
+    const float distance = glm::distance(m_position, sphere.center);
+    if (distance <= sphere.radius) {
+        return std::numeric_limits<float>::max();
+    }
+
+    const float focalLength = m_height * 0.5f / std::tan(glm::radians(m_fov) * 0.5f);
+    return sphere.radius / distance * focalLength;
+}
+
 void Camera::update() {
     processKeyboard();
     processMouse();
 }
 
+void Camera::setPose(const glm::vec3 &position, const glm::vec3 &rotation) {
+    m_position = position;
+    m_rotation = rotation;
+    m_pitch    = rotation.x;
+    m_yaw      = rotation.y;
+
+    m_view = glm::lookAt(m_position, m_position + getFront(), m_up);
+}
+
+glm::vec3 Camera::getFront() const {
+    return glm::rotate(glm::mat4(1.0f), glm::radians(m_rotation.y), glm::vec3(0.0f, 1.0f, 0.0f)) *
+           glm::rotate(glm::mat4(1.0f), glm::radians(m_rotation.x), glm::vec3(1.0f, 0.0f, 0.0f)) *
+           glm::vec4(m_front, 1.0f);
+}
+
 void Camera::processKeyboard() {
-    glm::vec3 rotated_front = glm::rotate(glm::mat4(1.0f), glm::radians(m_rotation.y), glm::vec3(0.0f, 1.0f, 0.0f)) *
-                              glm::rotate(glm::mat4(1.0f), glm::radians(m_rotation.x), glm::vec3(1.0f, 0.0f, 0.0f)) *
-                              glm::vec4(m_front, 1.0f);
+    glm::vec3 rotated_front = getFront();
 
     float speed = Input::isKeyPressed(GLFW_KEY_LEFT_SHIFT) ? m_fast_speed : m_slow_speed;
 
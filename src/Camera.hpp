@@ -3,6 +3,7 @@
 #include "Utility/OpenGlHeaders.hpp"
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
+#include "Render/Frustum.hpp"
 
 class Camera {
     private:
@@ -32,6 +33,8 @@ class Camera {
     void processKeyboard();
     void processMouse();
 
+    [[nodiscard]] glm::vec3 getFront() const;
+
     static constexpr glm::vec3 m_front{0.0f, 0.0f, 1.0f};
     static constexpr glm::vec3 m_up{0.0f, 1.0f, 0.0f};
 
@@ -41,8 +44,19 @@ class Camera {
     Camera();
     void update();
 
+    // Places the camera without going through the input, rotation is pitch and yaw in degrees like getRotation()
+    void setPose(const glm::vec3 &position, const glm::vec3 &rotation);
+
     [[nodiscard]] glm::mat4 getView() const noexcept { return m_view; }
     [[nodiscard]] glm::mat4 getProjection() const noexcept { return m_projection; }
     [[nodiscard]] glm::vec3 getPosition() const { return m_position; };
     [[nodiscard]] glm::vec3 getRotation() const { return m_rotation; };
+    [[nodiscard]] float     getNear() const noexcept { return m_near; }
+    [[nodiscard]] float     getFar() const noexcept { return m_far; }
+
+    // Radius of the sphere on screen in pixels, as if it was in the middle of the view
+    [[nodiscard]] float getProjectedRadius(const BoundingSphere &sphere) const;
+
+    // Planes of getProjection() * getView(), in world space
+    [[nodiscard]] Frustum getFrustum() const { return Frustum::fromMatrix(m_projection * m_view); }
 };
\ No newline at end of file
@@ -0,0 +1,23 @@
+#include "FrameUniforms.hpp"
+
+static_assert(sizeof(FrameUniforms::Data) == 2 * sizeof(glm::mat4) + 5 * sizeof(glm::vec4),
+              "FrameUniforms::Data must match the std140 layout of the FrameData block");
+
+FrameUniforms::FrameUniforms() : m_stream(GL_UNIFORM_BUFFER, sizeof(Data)) {}
+
+void FrameUniforms::attach(const Shader &shader) {
+    const GLuint blockIndex = shader.getUniformBlockIndex(BLOCK_NAME);
+    if (blockIndex != GL_INVALID_INDEX) {
+        glUniformBlockBinding(shader.getProgramID(), blockIndex, BINDING);
+    }
+}
+
+void FrameUniforms::upload(const Data &data) {
+    m_stream.beginFrame();
+    const size_t offset = m_stream.write(&data, sizeof(Data));
+    glBindBufferRange(GL_UNIFORM_BUFFER,
+                      BINDING,
+                      m_stream.getBuffer(),
+                      static_cast<GLintptr>(offset),
+                      static_cast<GLsizeiptr>(sizeof(Data)));
+}
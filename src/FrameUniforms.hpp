@@ -0,0 +1,44 @@
+#pragma once
+
+#include <Utility/OpenGlHeaders.hpp>
+#include <glm/glm.hpp>
+
+#include <Render/StreamBuffer.hpp>
+#include <Shader.hpp>
+#include <Utility/MemoryUsage.hpp>
+
+// Per-frame uniform buffer shared by every program, uploaded once per frame.
+//
+// Matches the std140 block declared in the shaders:
+//     layout(std140) uniform FrameData { mat4 view; mat4 projection; vec4 viewPos; ... };
+class FrameUniforms {
+    public:
+    static constexpr GLuint      BINDING    = 0;
+    static constexpr const char *BLOCK_NAME = "FrameData";
+
+    // vec3s are padded to vec4, std140 aligns them to 16 bytes anyway
+    struct Data {
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::vec4 viewPos;
+        glm::vec4 lightPos;
+        glm::vec4 lightColor;
+        glm::vec4 ambientLightColor;
+        glm::vec4 clusterParameters; // see LightClusters::getShaderParameters
+    };
+
+    FrameUniforms();
+
+    // Points the program's FrameData block at the shared binding, a no-op for programs that don't declare it
+    static void attach(const Shader &shader);
+
+    // Writes the data into the next region of the stream and points the binding at it
+    void upload(const Data &data);
+    void deleteBuffer() { m_stream.deleteBuffer(); }
+
+    [[nodiscard]] const StreamBuffer::Stats &getStreamStats() const noexcept { return m_stream.getStats(); }
+    [[nodiscard]] MemoryUsage                getMemoryUsage() const { return m_stream.getMemoryUsage(); }
+
+    private:
+    StreamBuffer m_stream;
+};
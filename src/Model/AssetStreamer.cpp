@@ -0,0 +1,59 @@
+#include "AssetStreamer.hpp"
+
+#include <chrono>
+
+#include <Utility/ThreadPool.hpp>
+
+AssetStreamer::Handle AssetStreamer::request(const std::string &modelName,
+                                             Mesh::VertexFormat format,
+                                             uint32_t           retention) {
+    m_entries.push_back(
+            {ThreadPool::shared().submit([modelName, format]() { return Model::import(modelName, format); }),
+             {},
+             retention});
+    m_pendingModels++;
+
+    return m_entries.size() - 1;
+}
+
+Model *AssetStreamer::get(Handle handle) {
+    auto &model = m_entries.at(handle).model;
+    return model.has_value() ? &model.value() : nullptr;
+}
+
+void AssetStreamer::update() {
+    for (auto &entry : m_entries) {
+        if (!entry.data.valid() || entry.data.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            continue;
+        }
+
+        // get() rethrows a failed import on the render thread
+        entry.model.emplace(entry.data.get(), &m_textureQueue, entry.retention);
+        m_pendingModels--;
+
+        // one geometry upload per frame keeps the frame time flat when several imports finish together
+        break;
+    }
+
+    m_uploadedBytes = m_textureQueue.process();
+}
+
+AssetStreamer::Stats AssetStreamer::getStats() const {
+    return {m_uploadedBytes,
+            m_textureQueue.budget(),
+            m_textureQueue.queuedBytes(),
+            m_textureQueue.queuedTextures(),
+            m_pendingModels};
+}
+
+void AssetStreamer::deleteAll() {
+    for (auto &entry : m_entries) {
+        if (entry.data.valid()) {
+            entry.data.wait();
+        }
+        if (entry.model.has_value()) {
+            entry.model->deleteModel();
+        }
+    }
+    m_textureQueue.deleteBuffers();
+}
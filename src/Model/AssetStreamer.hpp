@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <optional>
+#include <string>
+
+#include "Model.hpp"
+#include "TextureUploadQueue.hpp"
+
+// Loads models in the background while the render loop keeps running.
+//
+// Models are requested by handle and imported on the thread pool. update() has to be called once per frame on the
+// context thread, it uploads the geometry of models whose import finished and streams at most the upload budget of
+// texture data. get() returns nullptr until the geometry of a model is on the GPU, its textures may still be
+// placeholders at that point.
+class AssetStreamer {
+    public:
+    using Handle = size_t;
+
+    struct Stats {
+        size_t uploadedBytes;  // texture bytes uploaded by the last update
+        size_t budgetBytes;    // texture bytes allowed per update
+        size_t queuedBytes;    // texture bytes still waiting
+        size_t queuedTextures; // textures that are not complete yet
+        size_t pendingModels;  // models still importing
+    };
+
+    explicit AssetStreamer(size_t uploadBudgetBytes) : m_textureQueue(uploadBudgetBytes) {}
+
+    // retention is passed on to Model, see Mesh::Retention
+    Handle request(const std::string &modelName,
+                   Mesh::VertexFormat format    = Mesh::FLOAT32,
+                   uint32_t           retention = Mesh::RETAIN_OCCLUDER);
+
+    [[nodiscard]] Model *get(Handle handle);
+
+    void update();
+
+    [[nodiscard]] Stats getStats() const;
+    [[nodiscard]] bool  isIdle() const { return m_pendingModels == 0 && m_textureQueue.queuedTextures() == 0; }
+
+    // What the texture streaming holds, the models report their own usage
+    [[nodiscard]] MemoryUsage getMemoryUsage() const { return m_textureQueue.getMemoryUsage(); }
+
+    void deleteAll();
+
+    private:
+    struct Entry {
+        std::future<Model::Data> data;
+        std::optional<Model>     model;
+        uint32_t                 retention;
+    };
+
+    // a deque keeps the models in place while new requests come in
+    std::deque<Entry>  m_entries;
+    TextureUploadQueue m_textureQueue;
+    size_t             m_pendingModels = 0;
+    size_t             m_uploadedBytes = 0;
+};
@@ -0,0 +1,289 @@
+#include "CompressedImage.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <Utility/BinaryIO.hpp>
+#include <Utility/fs_helpers.hpp>
+
+#include "Image.hpp"
+#include "TextureCompression.hpp"
+
+namespace {
+
+using BinaryIO::readAt;
+using BinaryIO::writeRaw;
+
+// Bumped whenever the encoders or the mip filter change, older files are transcoded again
+constexpr uint32_t VERSION = 1;
+
+constexpr std::array<uint8_t, 12> KTX_IDENTIFIER{0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+constexpr uint32_t                KTX_ENDIANNESS = 0x04030201;
+
+constexpr std::string_view SOURCE_KEY      = "learnOpenGL.source";
+constexpr std::string_view ORIENTATION_KEY = "KTXorientation";
+constexpr std::string_view ORIENTATION     = "S=r,T=u"; // Image::load flips the rows so the first one is the bottom
+
+// KTX 1.1 file header, followed by the key/value data and every level as a 32 bit size and the blocks
+struct KtxHeader {
+    std::array<uint8_t, 12> identifier;
+    uint32_t                endianness;
+    uint32_t                glType;
+    uint32_t                glTypeSize;
+    uint32_t                glFormat;
+    uint32_t                glInternalFormat;
+    uint32_t                glBaseInternalFormat;
+    uint32_t                pixelWidth;
+    uint32_t                pixelHeight;
+    uint32_t                pixelDepth;
+    uint32_t                numberOfArrayElements;
+    uint32_t                numberOfFaces;
+    uint32_t                numberOfMipmapLevels;
+    uint32_t                bytesOfKeyValueData;
+};
+
+static_assert(sizeof(KtxHeader) == 64, "KtxHeader must match the file layout");
+
+std::atomic<bool> compressionEnabled{true};
+
+GLenum baseFormat(GLenum internalFormat) {
+    switch (internalFormat) {
+    case GL_COMPRESSED_RED_RGTC1:
+        return GL_RED;
+    case GL_COMPRESSED_RG_RGTC2:
+        return GL_RG;
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        return GL_RGB;
+    default:
+        return GL_RGBA;
+    }
+}
+
+// The file is only reused for the same source file, encoder version and filtering
+std::string sourceStamp(const std::filesystem::path &source, bool color) {
+    const fs_helpers::ResourceStamp stamp = fs_helpers::getResourceStamp(source);
+    return std::format("{} {} {} {}",
+                       stamp.size,
+                       stamp.modified,
+                       VERSION,
+                       color ? "srgb" : "linear");
+}
+
+// the key/value pairs and the levels start 4 byte aligned
+size_t alignUp(size_t value) {
+    return BinaryIO::alignUp(value, 4);
+}
+
+// Value of key in the key/value data, empty when it is missing
+std::string_view findValue(const MappedFile &file, size_t offset, size_t end, std::string_view key) {
+    while (offset + sizeof(uint32_t) <= end) {
+        const auto size = readAt<uint32_t>(file, offset);
+        offset += sizeof(uint32_t);
+        if (offset + size > end) {
+            break;
+        }
+
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast, cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        const std::string_view pair(reinterpret_cast<const char *>(file.data() + offset), size);
+        const size_t           separator = pair.find('\0');
+        if (separator != std::string_view::npos && pair.substr(0, separator) == key) {
+            std::string_view value = pair.substr(separator + 1);
+            return value.substr(0, value.find('\0'));
+        }
+
+        offset = alignUp(offset + size);
+    }
+    return {};
+}
+
+// Maps the KTX file, nullopt when it was written for a different version of the source or doesn't hold a full chain
+std::optional<CompressedImage> read(const std::filesystem::path &path, std::string_view stamp) {
+    CompressedImage image;
+    image.mapping = MappedFile(path);
+
+    const MappedFile &file   = image.mapping;
+    const auto        header = readAt<KtxHeader>(file, 0);
+
+    if (header.identifier != KTX_IDENTIFIER || header.endianness != KTX_ENDIANNESS ||
+        TextureCompression::blockSize(header.glInternalFormat) == 0 || header.pixelWidth == 0 ||
+        header.pixelHeight == 0 || header.pixelDepth != 0 || header.numberOfFaces != 1 ||
+        header.numberOfMipmapLevels == 0) {
+        return std::nullopt;
+    }
+
+    const size_t keyValueEnd = sizeof(KtxHeader) + header.bytesOfKeyValueData;
+    if (findValue(file, sizeof(KtxHeader), keyValueEnd, SOURCE_KEY) != stamp) {
+        return std::nullopt;
+    }
+
+    image.internalFormat = header.glInternalFormat;
+
+    auto   width  = static_cast<int>(header.pixelWidth);
+    auto   height = static_cast<int>(header.pixelHeight);
+    size_t offset = keyValueEnd;
+    for (uint32_t i = 0; i < header.numberOfMipmapLevels; i++) {
+        const auto size = readAt<uint32_t>(file, offset);
+        offset += sizeof(uint32_t);
+
+        if (size != TextureCompression::levelSize(image.internalFormat, width, height) || offset + size > file.size()) {
+            return std::nullopt;
+        }
+
+        image.levels.push_back({width, height, offset, size});
+        offset = alignUp(offset + size);
+        width  = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+
+    // a chain that stops early would leave the texture incomplete with the default filters
+    if (image.levels.back().width != 1 || image.levels.back().height != 1) {
+        return std::nullopt;
+    }
+
+    return image;
+}
+
+void writeKeyValue(std::ofstream &file, std::string_view key, std::string_view value) {
+    const auto size = static_cast<uint32_t>(key.size() + value.size() + 2);
+    writeRaw(file, size);
+    file.write(key.data(), static_cast<std::streamsize>(key.size())).put('\0');
+    file.write(value.data(), static_cast<std::streamsize>(value.size())).put('\0');
+
+    BinaryIO::writePadding(file, alignUp(static_cast<uint64_t>(file.tellp())));
+}
+
+size_t keyValueSize(std::string_view key, std::string_view value) {
+    return sizeof(uint32_t) + alignUp(key.size() + value.size() + 2);
+}
+
+void write(const std::filesystem::path &path, const CompressedImage &image, std::string_view stamp) {
+    std::filesystem::path temporaryPath = path;
+    temporaryPath += ".tmp";
+
+    std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+    if (file.fail()) {
+        throw std::runtime_error(
+                std::format("CompressedImage::write | Failed to open file: {}", temporaryPath.string()));
+    }
+
+    KtxHeader header{};
+    header.identifier           = KTX_IDENTIFIER;
+    header.endianness           = KTX_ENDIANNESS;
+    header.glTypeSize           = 1;
+    header.glInternalFormat     = image.internalFormat;
+    header.glBaseInternalFormat = baseFormat(image.internalFormat);
+    header.pixelWidth           = static_cast<uint32_t>(image.width());
+    header.pixelHeight          = static_cast<uint32_t>(image.height());
+    header.numberOfFaces        = 1;
+    header.numberOfMipmapLevels = static_cast<uint32_t>(image.levels.size());
+    header.bytesOfKeyValueData  = static_cast<uint32_t>(keyValueSize(ORIENTATION_KEY, ORIENTATION) +
+                                                      keyValueSize(SOURCE_KEY, stamp));
+    writeRaw(file, header);
+
+    writeKeyValue(file, ORIENTATION_KEY, ORIENTATION);
+    writeKeyValue(file, SOURCE_KEY, stamp);
+
+    // block sizes are multiples of 4, the levels need no padding
+    for (size_t i = 0; i < image.levels.size(); i++) {
+        const std::span<const std::byte> level = image.level(i);
+        const auto                       size  = static_cast<uint32_t>(level.size());
+        writeRaw(file, size);
+        BinaryIO::writeBytes(file, level);
+    }
+
+    file.close();
+    if (file.fail()) {
+        throw std::runtime_error(
+                std::format("CompressedImage::write | Failed to write file: {}", temporaryPath.string()));
+    }
+
+    std::filesystem::rename(temporaryPath, path);
+}
+} // namespace
+
+bool CompressedImage::isSupported() {
+    // RGTC is core since 3.0, only the S3TC formats need the extension
+    return compressionEnabled && GLAD_GL_EXT_texture_compression_s3tc != 0;
+}
+
+void CompressedImage::setEnabled(bool enabled) { compressionEnabled = enabled; }
+
+std::filesystem::path CompressedImage::cachePath(const std::filesystem::path &source) {
+    std::filesystem::path path = source;
+    path += ".ktx";
+    return path;
+}
+
+CompressedImage CompressedImage::load(const std::filesystem::path &source, bool color) {
+    const auto        start = std::chrono::steady_clock::now();
+    const auto        path  = cachePath(source);
+    const std::string stamp = sourceStamp(source, color);
+
+    const auto elapsed = [&] {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    if (std::filesystem::exists(path)) {
+        try {
+            if (auto image = read(path, stamp)) {
+                image->cached       = true;
+                image->milliseconds = elapsed();
+                return std::move(*image);
+            }
+        } catch (const std::runtime_error &) {
+            // unreadable files are replaced like outdated ones
+        }
+    }
+
+    const Image  decoded = Image::load(source);
+    const GLenum format  = TextureCompression::selectFormat(decoded.channels);
+    if (format == 0) {
+        throw std::runtime_error(std::format(
+                "CompressedImage::load | Unsupported channel count {}: {}", decoded.channels, source.string()));
+    }
+
+    CompressedImage image;
+    image.internalFormat = format;
+
+    for (auto &level : TextureCompression::compress(decoded, format, color)) {
+        image.levels.push_back({level.width, level.height, image.storage.size(), level.blocks.size()});
+        image.storage.insert(image.storage.end(), level.blocks.begin(), level.blocks.end());
+    }
+
+    try {
+        write(path, image, stamp);
+    } catch (const std::exception &error) {
+        std::cerr << "CompressedImage::load | Failed to write KTX file: " << error.what() << std::endl;
+    }
+
+    image.milliseconds = elapsed();
+    return image;
+}
+
+size_t CompressedImage::size() const noexcept {
+    size_t total = 0;
+    for (const auto &level : levels) {
+        total += level.size;
+    }
+    return total;
+}
+
+size_t CompressedImage::uncompressedSize() const noexcept {
+    const auto channels = static_cast<size_t>(TextureCompression::uncompressedChannels(internalFormat));
+
+    size_t total = 0;
+    for (const auto &level : levels) {
+        total += static_cast<size_t>(level.width) * static_cast<size_t>(level.height) * channels;
+    }
+    return total;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <Utility/OpenGlHeaders.hpp>
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+#include <Utility/MappedFile.hpp>
+
+// Block compressed image with its full mip chain, ready for glCompressedTexImage2D.
+//
+// The first load of a source image decodes it, filters and compresses every level with TextureCompression and writes
+// the result to a KTX file next to the source. Later loads map that file as long as the source is unchanged, so the
+// cost of the transcode is only paid once. Like Image it touches no GL state and can be loaded on any thread.
+struct CompressedImage {
+    struct Level {
+        int    width;
+        int    height;
+        size_t offset; // into data()
+        size_t size;
+    };
+
+    GLenum             internalFormat = 0;
+    std::vector<Level> levels; // largest first
+
+    // the KTX file when the image was read from it, otherwise the freshly compressed blocks
+    MappedFile             mapping;
+    std::vector<std::byte> storage;
+
+    // how long load took and whether it could use the KTX file instead of transcoding
+    double milliseconds = 0.0;
+    bool   cached       = false;
+
+    // Whether the driver can sample the compressed formats and compression isn't turned off with setEnabled. Without it
+    // the textures go through Image and glGenerateMipmap.
+    static bool isSupported();
+    static void setEnabled(bool enabled);
+
+    // Colour images are filtered in linear space, data maps such as specular or roughness as they are stored
+    static CompressedImage load(const std::filesystem::path &source, bool color);
+
+    // The KTX file written for source
+    static std::filesystem::path cachePath(const std::filesystem::path &source);
+
+    [[nodiscard]] const std::byte *data() const noexcept { return mapping.isOpen() ? mapping.data() : storage.data(); }
+    [[nodiscard]] std::span<const std::byte> level(size_t index) const {
+        return {data() + levels.at(index).offset, levels.at(index).size}; // NOLINT(*-pro-bounds-pointer-arithmetic)
+    }
+
+    [[nodiscard]] int width() const { return levels.at(0).width; }
+    [[nodiscard]] int height() const { return levels.at(0).height; }
+
+    // Bytes of all levels on the GPU
+    [[nodiscard]] size_t size() const noexcept;
+
+    // Bytes the same texture takes uncompressed with a generated mip chain, RGB is padded to RGBA by the driver
+    [[nodiscard]] size_t uncompressedSize() const noexcept;
+};
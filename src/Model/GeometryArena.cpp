@@ -0,0 +1,404 @@
+#include "GeometryArena.hpp"
+#include "Quantization.hpp"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <utility>
+
+GeometryArena &GeometryArena::forFormat(Mesh::VertexFormat format) {
+    static std::array<GeometryArena, Mesh::VERTEX_FORMAT_COUNT> arenas{GeometryArena(Mesh::FLOAT32),
+                                                                       GeometryArena(Mesh::QUANTIZED),
+                                                                       GeometryArena(Mesh::QUANTIZED_OCTAHEDRAL)};
+    return arenas.at(format);
+}
+
+GeometryArena::Handle GeometryArena::allocate(std::span<const std::byte> vertices,
+                                              std::span<const std::byte> indices,
+                                              size_t                     indexSize) {
+    if (m_vertexArray == 0) {
+        createBuffers();
+    }
+
+    const size_t vertexCount = vertices.size() / m_vertexSize;
+    const size_t indexBytes  = (indices.size() + INDEX_ALIGNMENT - 1) / INDEX_ALIGNMENT * INDEX_ALIGNMENT;
+
+    // defragment before taking either range, the repack only keeps the live ranges and would hand a range reserved
+    // in between out again
+    if ((!m_vertices.fits(vertexCount) && m_vertices.freeSpace() >= vertexCount) ||
+        (!m_indices.fits(indexBytes) && m_indices.freeSpace() >= indexBytes)) {
+        defragment();
+    }
+
+    Range range{};
+    range.baseVertex  = static_cast<GLint>(reserveVertices(vertexCount));
+    range.vertexCount = static_cast<GLsizei>(vertexCount);
+    range.indexBytes  = indexBytes;
+    range.indexOffset = reserveIndices(range.indexBytes);
+    range.indexCount  = static_cast<GLsizei>(indices.size() / indexSize);
+    range.indexType   = indexSize == sizeof(uint16_t) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+    // upload through the copy target so the element buffer binding of the bound VAO is left alone
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_vertexBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER,
+                    static_cast<GLintptr>(range.baseVertex * m_vertexSize),
+                    static_cast<GLsizeiptr>(vertices.size_bytes()),
+                    vertices.data());
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_indexBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER,
+                    static_cast<GLintptr>(range.indexOffset),
+                    static_cast<GLsizeiptr>(indices.size_bytes()),
+                    indices.data());
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    if (!m_freeHandles.empty()) {
+        const Handle handle = m_freeHandles.back();
+        m_freeHandles.pop_back();
+
+        m_ranges[handle] = range;
+        m_live[handle]   = true;
+        checkRanges();
+        return handle;
+    }
+
+    m_ranges.push_back(range);
+    m_live.push_back(true);
+    checkRanges();
+    return static_cast<Handle>(m_ranges.size() - 1);
+}
+
+void GeometryArena::free(Handle handle) {
+    if (!m_live.at(handle)) {
+        return;
+    }
+
+    const Range &range = m_ranges[handle];
+    m_vertices.free(static_cast<size_t>(range.baseVertex), static_cast<size_t>(range.vertexCount));
+    m_indices.free(range.indexOffset, range.indexBytes);
+
+    m_live[handle] = false;
+    m_freeHandles.push_back(handle);
+    checkRanges();
+}
+
+GeometryArena::Stats GeometryArena::getStats() const {
+    const size_t totalFree = m_vertices.freeSpace() * m_vertexSize + m_indices.freeSpace();
+    const size_t largest   = std::max(m_vertices.largestBlock() * m_vertexSize, m_indices.largestBlock());
+
+    Stats stats{};
+    stats.vertexBytesCapacity = m_vertices.capacity() * m_vertexSize;
+    stats.vertexBytesUsed     = stats.vertexBytesCapacity - m_vertices.freeSpace() * m_vertexSize;
+    stats.indexBytesCapacity  = m_indices.capacity();
+    stats.indexBytesUsed      = stats.indexBytesCapacity - m_indices.freeSpace();
+    stats.freeBlocks          = m_vertices.blockCount() + m_indices.blockCount();
+    stats.fragmentation = totalFree == 0 ? 0.0f : 1.0f - static_cast<float>(largest) / static_cast<float>(totalFree);
+
+    return stats;
+}
+
+MemoryUsage GeometryArena::getMemoryUsage() const {
+    MemoryUsage usage;
+    usage.cpuBytes = m_ranges.capacity() * sizeof(Range) + m_live.capacity() / 8 +
+                     m_freeHandles.capacity() * sizeof(Handle);
+
+    if (m_vertexArray != 0) {
+        usage.bufferBytes = m_vertices.capacity() * m_vertexSize + m_indices.capacity();
+        usage.glObjects   = 3;
+    }
+    return usage;
+}
+
+void GeometryArena::defragment() {
+    if (m_vertexArray == 0) {
+        return;
+    }
+
+    GLuint vertexBuffer = 0;
+    GLuint indexBuffer  = 0;
+    glGenBuffers(1, &vertexBuffer);
+    glGenBuffers(1, &indexBuffer);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, vertexBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER,
+                 static_cast<GLsizeiptr>(m_vertices.capacity() * m_vertexSize),
+                 nullptr,
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, indexBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(m_indices.capacity()), nullptr, GL_STATIC_DRAW);
+
+    size_t nextVertex = 0;
+    size_t nextIndex  = 0;
+
+    for (size_t handle = 0; handle < m_ranges.size(); handle++) {
+        if (!m_live[handle]) {
+            continue;
+        }
+
+        Range &range = m_ranges[handle];
+
+        glBindBuffer(GL_COPY_READ_BUFFER, m_vertexBuffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, vertexBuffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER,
+                            GL_COPY_WRITE_BUFFER,
+                            static_cast<GLintptr>(range.baseVertex * m_vertexSize),
+                            static_cast<GLintptr>(nextVertex * m_vertexSize),
+                            static_cast<GLsizeiptr>(range.vertexCount * m_vertexSize));
+
+        glBindBuffer(GL_COPY_READ_BUFFER, m_indexBuffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, indexBuffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER,
+                            GL_COPY_WRITE_BUFFER,
+                            static_cast<GLintptr>(range.indexOffset),
+                            static_cast<GLintptr>(nextIndex),
+                            static_cast<GLsizeiptr>(range.indexBytes));
+
+        range.baseVertex  = static_cast<GLint>(nextVertex);
+        range.indexOffset = nextIndex;
+
+        nextVertex += static_cast<size_t>(range.vertexCount);
+        nextIndex += range.indexBytes;
+    }
+
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    glDeleteBuffers(1, &m_vertexBuffer);
+    glDeleteBuffers(1, &m_indexBuffer);
+    m_vertexBuffer = vertexBuffer;
+    m_indexBuffer  = indexBuffer;
+
+    m_vertices.reset(nextVertex, m_vertices.capacity());
+    m_indices.reset(nextIndex, m_indices.capacity());
+
+    configureVertexArray();
+    checkRanges();
+}
+
+void GeometryArena::deleteBuffers() {
+    glDeleteVertexArrays(1, &m_vertexArray);
+    glDeleteBuffers(1, &m_vertexBuffer);
+    glDeleteBuffers(1, &m_indexBuffer);
+
+    m_vertexArray  = 0;
+    m_vertexBuffer = 0;
+    m_indexBuffer  = 0;
+}
+
+void GeometryArena::createBuffers() {
+    glGenVertexArrays(1, &m_vertexArray);
+    glGenBuffers(1, &m_vertexBuffer);
+    glGenBuffers(1, &m_indexBuffer);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_vertexBuffer);
+    glBufferData(
+            GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(INITIAL_VERTICES * m_vertexSize), nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_indexBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(INITIAL_INDEX_BYTES), nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    m_vertices.reset(0, INITIAL_VERTICES);
+    m_indices.reset(0, INITIAL_INDEX_BYTES);
+
+    configureVertexArray();
+}
+
+void GeometryArena::configureVertexArray() const {
+    glBindVertexArray(m_vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+
+    const unsigned int positionIndex = 0;
+    const unsigned int normalIndex   = 1;
+    const unsigned int texCoordIndex = 2;
+
+    const auto stride = static_cast<GLsizei>(m_vertexSize);
+
+    glEnableVertexAttribArray(positionIndex);
+    glEnableVertexAttribArray(normalIndex);
+    glEnableVertexAttribArray(texCoordIndex);
+
+    if (m_format == Mesh::FLOAT32) {
+        const auto *positionOffset = reinterpret_cast<void *>(offsetof(Mesh::Vertex, Position));  // NOLINT
+        const auto *normalOffset   = reinterpret_cast<void *>(offsetof(Mesh::Vertex, Normal));    // NOLINT
+        const auto *texCoordOffset = reinterpret_cast<void *>(offsetof(Mesh::Vertex, TexCoords)); // NOLINT
+
+        glVertexAttribPointer(positionIndex, 3, GL_FLOAT, GL_FALSE, stride, positionOffset);
+        glVertexAttribPointer(normalIndex, 3, GL_FLOAT, GL_FALSE, stride, normalOffset);
+        glVertexAttribPointer(texCoordIndex, 2, GL_FLOAT, GL_FALSE, stride, texCoordOffset);
+    } else {
+        const auto *positionOffset = reinterpret_cast<void *>(offsetof(Quantization::Vertex, position));  // NOLINT
+        const auto *normalOffset   = reinterpret_cast<void *>(offsetof(Quantization::Vertex, normal));    // NOLINT
+        const auto *texCoordOffset = reinterpret_cast<void *>(offsetof(Quantization::Vertex, texCoords)); // NOLINT
+
+        // unorm positions inside the mesh bounds, the vertex shader applies the dequantization transform
+        glVertexAttribPointer(positionIndex, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, positionOffset);
+
+        if (m_format == Mesh::QUANTIZED_OCTAHEDRAL) {
+            // the shader decodes the two components back into a direction
+            glVertexAttribPointer(normalIndex, 2, GL_SHORT, GL_TRUE, stride, normalOffset);
+        } else {
+            glVertexAttribPointer(normalIndex, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, normalOffset);
+        }
+
+        glVertexAttribPointer(texCoordIndex, 2, GL_HALF_FLOAT, GL_FALSE, stride, texCoordOffset);
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+size_t GeometryArena::reserveVertices(size_t count) {
+    if (auto offset = m_vertices.allocate(count)) {
+        return *offset;
+    }
+
+    const size_t capacity = std::max(m_vertices.capacity() * 2, m_vertices.capacity() + count);
+    m_vertexBuffer        = resizeBuffer(m_vertexBuffer,
+                                  m_vertices.capacity() * m_vertexSize,
+                                  capacity * m_vertexSize);
+    m_vertices.grow(capacity);
+    configureVertexArray();
+
+    return m_vertices.allocate(count).value();
+}
+
+size_t GeometryArena::reserveIndices(size_t bytes) {
+    if (auto offset = m_indices.allocate(bytes)) {
+        return *offset;
+    }
+
+    const size_t capacity = std::max(m_indices.capacity() * 2, m_indices.capacity() + bytes);
+    m_indexBuffer         = resizeBuffer(m_indexBuffer, m_indices.capacity(), capacity);
+    m_indices.grow(capacity);
+    configureVertexArray();
+
+    return m_indices.allocate(bytes).value();
+}
+
+void GeometryArena::checkRanges() const {
+#ifndef NDEBUG
+    // every vertex and index byte must be either in exactly one live range or in a free block
+    std::vector<std::pair<size_t, size_t>> vertexSpans(m_vertices.blocks().begin(), m_vertices.blocks().end());
+    std::vector<std::pair<size_t, size_t>> indexSpans(m_indices.blocks().begin(), m_indices.blocks().end());
+    for (size_t handle = 0; handle < m_ranges.size(); handle++) {
+        if (m_live[handle]) {
+            const Range &range = m_ranges[handle];
+            vertexSpans.emplace_back(static_cast<size_t>(range.baseVertex), static_cast<size_t>(range.vertexCount));
+            indexSpans.emplace_back(range.indexOffset, range.indexBytes);
+        }
+    }
+
+    const auto tiles = [](std::vector<std::pair<size_t, size_t>> &spans, size_t capacity) {
+        std::ranges::sort(spans);
+        size_t end = 0;
+        for (const auto &[offset, size] : spans) {
+            if (size == 0) {
+                continue;
+            }
+            if (offset != end) {
+                return false;
+            }
+            end = offset + size;
+        }
+        return end == capacity;
+    };
+
+    if (!tiles(vertexSpans, m_vertices.capacity()) || !tiles(indexSpans, m_indices.capacity())) {
+        throw std::runtime_error("GeometryArena | Live ranges overlap each other or the free blocks");
+    }
+#endif
+}
+
+GLuint GeometryArena::resizeBuffer(GLuint buffer, size_t oldSize, size_t newSize) {
+    GLuint resized = 0;
+    glGenBuffers(1, &resized);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, resized);
+    glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(newSize), nullptr, GL_STATIC_DRAW);
+
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, static_cast<GLsizeiptr>(oldSize));
+
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    glDeleteBuffers(1, &buffer);
+    return resized;
+}
+
+std::optional<size_t> GeometryArena::FreeList::allocate(size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+
+    for (auto iterator = m_blocks.begin(); iterator != m_blocks.end(); ++iterator) {
+        const auto [offset, blockSize] = *iterator;
+        if (blockSize < size) {
+            continue;
+        }
+
+        m_blocks.erase(iterator);
+        if (blockSize > size) {
+            m_blocks.emplace(offset + size, blockSize - size);
+        }
+
+        m_free -= size;
+        return offset;
+    }
+
+    return std::nullopt;
+}
+
+void GeometryArena::FreeList::free(size_t offset, size_t size) {
+    if (size == 0) {
+        return;
+    }
+
+    m_free += size;
+
+    auto next = m_blocks.lower_bound(offset);
+
+    // merge with the block that ends where this one starts
+    if (next != m_blocks.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset) {
+            offset = previous->first;
+            size += previous->second;
+            m_blocks.erase(previous);
+        }
+    }
+
+    // and with the block that starts where this one ends
+    if (next != m_blocks.end() && offset + size == next->first) {
+        size += next->second;
+        m_blocks.erase(next);
+    }
+
+    m_blocks.emplace(offset, size);
+}
+
+void GeometryArena::FreeList::reset(size_t used, size_t capacity) {
+    m_blocks.clear();
+    m_capacity = capacity;
+    m_free     = capacity - used;
+
+    if (m_free > 0) {
+        m_blocks.emplace(used, m_free);
+    }
+}
+
+void GeometryArena::FreeList::grow(size_t capacity) {
+    const size_t oldCapacity = m_capacity;
+    m_capacity               = capacity;
+    free(oldCapacity, capacity - oldCapacity);
+}
+
+size_t GeometryArena::FreeList::largestBlock() const {
+    size_t largest = 0;
+    for (const auto &[offset, size] : m_blocks) {
+        largest = std::max(largest, size);
+    }
+    return largest;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <Utility/OpenGlHeaders.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <Utility/MemoryUsage.hpp>
+
+#include "Mesh.hpp"
+
+// One vertex buffer, one index buffer and one VAO shared by every mesh of a vertex format.
+//
+// Meshes get a range of each buffer from a free list and draw with glDrawElementsBaseVertex, so switching meshes
+// never rebinds buffers or vertex arrays. Allocations are referred to by handle, which stays valid when defragment()
+// moves the ranges around.
+class GeometryArena {
+    public:
+    using Handle = uint32_t;
+
+    struct Range {
+        GLint   baseVertex  = 0;
+        GLsizei vertexCount = 0;
+        size_t  indexOffset = 0; // bytes
+        size_t  indexBytes  = 0; // allocated, padded so every range starts 4 byte aligned
+        GLsizei indexCount  = 0;
+        GLenum  indexType   = GL_UNSIGNED_INT;
+    };
+
+    struct Stats {
+        size_t vertexBytesUsed;
+        size_t vertexBytesCapacity;
+        size_t indexBytesUsed;
+        size_t indexBytesCapacity;
+        size_t freeBlocks;
+
+        // 1 - largest free block / total free space, over both buffers. 0 when the free space is contiguous.
+        float fragmentation;
+    };
+
+    explicit GeometryArena(Mesh::VertexFormat format) : m_format(format), m_vertexSize(Mesh::vertexSize(format)) {}
+
+    // The arena holding the meshes of a vertex format
+    static GeometryArena &forFormat(Mesh::VertexFormat format);
+
+    // Uploads the geometry into the arena, must be called on the context thread. The vertices are encoded in the
+    // arena's format, the indices are 16 or 32 bit as given by indexSize.
+    Handle allocate(std::span<const std::byte> vertices, std::span<const std::byte> indices, size_t indexSize);
+    void   free(Handle handle);
+
+    [[nodiscard]] const Range &range(Handle handle) const { return m_ranges.at(handle); }
+    [[nodiscard]] GLuint             getVertexArray() const noexcept { return m_vertexArray; }
+    [[nodiscard]] Mesh::VertexFormat getFormat() const noexcept { return m_format; }
+    [[nodiscard]] Stats              getStats() const;
+
+    // The buffers at their full capacity and the vertex array, nothing until the first allocation creates them
+    [[nodiscard]] MemoryUsage getMemoryUsage() const;
+
+    // Packs every live range at the start of the buffers, leaving a single free block at the end
+    void defragment();
+
+    void deleteBuffers();
+
+    private:
+    // First fit allocator over vertex offsets or index buffer bytes, the free blocks are kept sorted so neighbours
+    // can be merged
+    class FreeList {
+        public:
+        std::optional<size_t> allocate(size_t size);
+        void                  free(size_t offset, size_t size);
+        void                  reset(size_t used, size_t capacity);
+        void                  grow(size_t capacity);
+
+        [[nodiscard]] size_t capacity() const noexcept { return m_capacity; }
+        [[nodiscard]] size_t freeSpace() const noexcept { return m_free; }
+        [[nodiscard]] size_t largestBlock() const;
+        [[nodiscard]] size_t blockCount() const noexcept { return m_blocks.size(); }
+        [[nodiscard]] bool   fits(size_t size) const { return size == 0 || largestBlock() >= size; }
+
+        [[nodiscard]] const std::map<size_t, size_t> &blocks() const noexcept { return m_blocks; }
+
+        private:
+        std::map<size_t, size_t> m_blocks; // offset -> size
+        size_t                   m_capacity = 0;
+        size_t                   m_free     = 0;
+    };
+
+    static constexpr size_t INITIAL_VERTICES    = size_t{1} << 16;
+    static constexpr size_t INITIAL_INDEX_BYTES = size_t{1} << 20;
+    static constexpr size_t INDEX_ALIGNMENT     = 4;
+
+    Mesh::VertexFormat m_format;
+    size_t             m_vertexSize;
+
+    GLuint m_vertexArray  = 0;
+    GLuint m_vertexBuffer = 0;
+    GLuint m_indexBuffer  = 0;
+
+    FreeList m_vertices;
+    FreeList m_indices; // in bytes
+
+    std::vector<Range>  m_ranges;
+    std::vector<bool>   m_live;
+    std::vector<Handle> m_freeHandles;
+
+    void createBuffers();
+    void configureVertexArray() const;
+
+    // takes the given number of vertices or index bytes from the free list, growing the buffer when no block is
+    // large enough. Never defragments, allocate() does that once before reserving either range
+    size_t reserveVertices(size_t count);
+    size_t reserveIndices(size_t bytes);
+
+    // debug builds only: throws when the live ranges and the free blocks don't tile both buffers exactly
+    void checkRanges() const;
+
+    static GLuint resizeBuffer(GLuint buffer, size_t oldSize, size_t newSize);
+};
@@ -0,0 +1,36 @@
+#include "Image.hpp"
+
+#include <climits>
+#include <format>
+#include <stdexcept>
+
+#include <Utility/fs_helpers.hpp>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb/stb_image.h>
+
+Image Image::load(const std::filesystem::path &path) {
+    Image image;
+
+    const std::optional<fs_helpers::Resource> file = fs_helpers::openResource(path);
+    if (!file.has_value() || file->size() > INT_MAX) {
+        throw std::runtime_error(std::format("Image::load | Failed to open file: {}", path.string()));
+    }
+
+    // the flag is thread local, the global setter would race with decodes on other workers
+    stbi_set_flip_vertically_on_load_thread(1);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    unsigned char *data = stbi_load_from_memory(reinterpret_cast<const stbi_uc *>(file->bytes().data()),
+                                                static_cast<int>(file->size()),
+                                                &image.width,
+                                                &image.height,
+                                                &image.channels,
+                                                0);
+
+    if (data == nullptr) {
+        throw std::runtime_error(std::format("stbi_load | {} | {}", stbi_failure_reason(), path.string()));
+    }
+
+    image.pixels = {data, stbi_image_free};
+    return image;
+}
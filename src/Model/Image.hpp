@@ -0,0 +1,34 @@
+#pragma once
+
+#include <Utility/OpenGlHeaders.hpp>
+
+#include <filesystem>
+#include <memory>
+
+// Decoded 8 bit image, owned by stb_image. Decoding touches no GL state and can run on any thread.
+struct Image {
+    int width    = 0;
+    int height   = 0;
+    int channels = 0;
+
+    std::unique_ptr<unsigned char, void (*)(void *)> pixels{nullptr, [](void *) {}};
+
+    static Image load(const std::filesystem::path &path);
+
+    [[nodiscard]] size_t rowSize() const noexcept { return static_cast<size_t>(width) * static_cast<size_t>(channels); }
+    [[nodiscard]] size_t size() const noexcept { return rowSize() * static_cast<size_t>(height); }
+
+    // Matching pixel format for glTexImage2D
+    [[nodiscard]] GLenum format() const noexcept {
+        switch (channels) {
+        case 1:
+            return GL_RED;
+        case 3:
+            return GL_RGB;
+        case 4:
+            return GL_RGBA;
+        default:
+            return 0;
+        }
+    }
+};
@@ -0,0 +1,91 @@
+#include "Material.hpp"
+
+#include "Texture.hpp"
+
+#include <algorithm>
+#include <array>
+#include <string>
+
+Material::Uniforms Material::prepareShader(const Shader &shader) {
+    Shader::setInt(shader.getUniform(std::string(Texture::DIFFUSE) + "1"), Texture::DIFFUSE_UNIT);
+    Shader::setInt(shader.getUniform(std::string(Texture::SPECULAR) + "1"), Texture::SPECULAR_UNIT);
+    Shader::setInt(shader.getUniform(std::string(Texture::ROUGHNESS) + "1"), Texture::ROUGHNESS_UNIT);
+
+    return {shader.getUniform("material_shininess")};
+}
+
+void Material::bind(const Uniforms &uniforms) const {
+    glActiveTexture(GL_TEXTURE0 + Texture::DIFFUSE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, diffuse);
+
+    glActiveTexture(GL_TEXTURE0 + Texture::SPECULAR_UNIT);
+    glBindTexture(GL_TEXTURE_2D, specular);
+
+    glActiveTexture(GL_TEXTURE0 + Texture::ROUGHNESS_UNIT);
+    glBindTexture(GL_TEXTURE_2D, roughness);
+
+    Shader::setFloat(uniforms.shininess, shininess);
+}
+
+MaterialLibrary &MaterialLibrary::shared() {
+    static MaterialLibrary library;
+    return library;
+}
+
+uint32_t MaterialLibrary::add(Material material) {
+    if (m_white == 0) {
+        m_white = createFallback(255);
+        m_black = createFallback(0);
+    }
+
+    // the roughness map only shapes the specular term, without a specular map it would compile an identical variant
+    material.features = (material.diffuse != 0 ? ShaderVariants::HAS_DIFFUSE_MAP : 0U) |
+                        (material.specular != 0 ? ShaderVariants::HAS_SPECULAR_MAP : 0U) |
+                        (material.specular != 0 && material.roughness != 0 ? ShaderVariants::HAS_ROUGHNESS_MAP : 0U);
+
+    material.diffuse   = material.diffuse != 0 ? material.diffuse : m_white;
+    material.specular  = material.specular != 0 ? material.specular : m_black;
+    material.roughness = material.roughness != 0 ? material.roughness : m_white;
+
+    // materials are only added at load time and there are few of them, a linear search is enough
+    auto iterator = std::find(m_materials.begin(), m_materials.end(), material);
+    if (iterator != m_materials.end()) {
+        return static_cast<uint32_t>(iterator - m_materials.begin());
+    }
+
+    m_materials.push_back(material);
+    return static_cast<uint32_t>(m_materials.size() - 1);
+}
+
+size_t MaterialLibrary::bind(uint32_t index, const Material::Uniforms &uniforms) {
+    if (index == m_bound) {
+        return 0;
+    }
+
+    m_materials.at(index).bind(uniforms);
+    m_bound = index;
+
+    return 3;
+}
+
+void MaterialLibrary::deleteFallbacks() {
+    glDeleteTextures(1, &m_white);
+    glDeleteTextures(1, &m_black);
+    m_white = 0;
+    m_black = 0;
+}
+
+GLuint MaterialLibrary::createFallback(unsigned char value) {
+    const std::array<unsigned char, 4> pixel{value, value, value, 255};
+
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixel.data());
+
+    return texture;
+}
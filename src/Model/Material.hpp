@@ -0,0 +1,74 @@
+#pragma once
+
+#include <Utility/OpenGlHeaders.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <Shader.hpp>
+#include <ShaderVariants.hpp>
+#include <Utility/MemoryUsage.hpp>
+
+// Textures and parameters of a surface, built once at import.
+//
+// Every map has a fixed sampler slot, see Texture.hpp. Missing maps point at a fallback texture, white for the
+// diffuse and roughness maps and black for the specular map, so binding a material never leaves a slot holding the
+// previous material's texture. The features record which maps are real, they pick the shader variant that skips the
+// others.
+struct Material {
+    GLuint   diffuse   = 0;
+    GLuint   specular  = 0;
+    GLuint   roughness = 0;
+    float    shininess = 32.0f;
+    uint32_t features  = 0; // ShaderVariants::Feature bits, set by MaterialLibrary::add
+
+    bool operator==(const Material &other) const = default;
+
+    // Uniform handles used by bind, resolved once per program
+    struct Uniforms {
+        Shader::Uniform shininess;
+    };
+
+    // Resolves the handles and points the samplers at their slots, the program has to be in use
+    static Uniforms prepareShader(const Shader &shader);
+
+    void bind(const Uniforms &uniforms) const;
+};
+
+// Deduplicated materials of all models, meshes refer to them by index
+class MaterialLibrary {
+    public:
+    static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+    static MaterialLibrary &shared();
+
+    // Returns the index of an identical material if there is one. Maps left at 0 get their fallback texture.
+    uint32_t add(Material material);
+
+    [[nodiscard]] const Material &operator[](uint32_t index) const { return m_materials.at(index); }
+    [[nodiscard]] size_t          size() const noexcept { return m_materials.size(); }
+
+    // The materials and the two 1x1 fallback textures, the maps are counted by TextureManager
+    [[nodiscard]] MemoryUsage getMemoryUsage() const {
+        return {.cpuBytes = m_materials.capacity() * sizeof(Material), .textureBytes = 8, .glObjects = 2};
+    }
+
+    // Binds a material unless it is the one already bound, returns the number of textures bound
+    size_t bind(uint32_t index, const Material::Uniforms &uniforms);
+
+    // Forgets the bound material, needed when the program changes since the uniforms belong to it
+    void invalidate() noexcept { m_bound = NONE; }
+
+    void deleteFallbacks();
+
+    private:
+    std::vector<Material> m_materials;
+    uint32_t              m_bound = NONE;
+
+    GLuint m_white = 0;
+    GLuint m_black = 0;
+
+    static GLuint createFallback(unsigned char value);
+};
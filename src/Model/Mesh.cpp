@@ -1,95 +1,181 @@
 #include "Mesh.hpp"
-
-#include "Texture.hpp"
+#include "GeometryArena.hpp"
+#include "Quantization.hpp"
 
 #include <Utility/OpenGlHeaders.hpp>
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
 #include <vector>
 #include <string>
 #include <iostream>
 
-Mesh::Mesh(std::vector<Vertex>       vertices,
-           std::vector<unsigned int> indices,
-           std::vector<Texture>      textures,
-           float                     shininess)
-        : m_vertices(std::move(vertices)),
-          m_indices(std::move(indices)),
-          m_textures(std::move(textures)),
-          m_shininess(shininess) {
-    setupMesh();
+size_t Mesh::vertexSize(VertexFormat format) {
+    return format == FLOAT32 ? sizeof(Vertex) : sizeof(Quantization::Vertex);
 }
 
-void Mesh::setupMesh() {
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-
-    // GLsizeiptr is a signed, if there are too many vertices or indices, it will overflow and result in a negative size
-    const GLsizeiptr verticesSize = m_vertices.size() * sizeof(Vertex);
-    const GLsizeiptr indicesSize  = m_indices.size() * sizeof(unsigned int);
+Mesh::View Mesh::Data::view() const {
+    const std::span<const std::byte> vertexBytes =
+            format == FLOAT32 ? std::as_bytes(std::span(vertices)) : std::span<const std::byte>(encodedVertices);
+
+    const bool                       narrow     = !shortIndices.empty();
+    const std::span<const std::byte> indexBytes = narrow ? std::as_bytes(std::span(shortIndices))
+                                                         : std::as_bytes(std::span(indices));
+
+    return {format,
+            vertexBytes,
+            indexBytes,
+            narrow ? sizeof(uint16_t) : sizeof(unsigned int),
+            textures,
+            shininess,
+            boundsMin,
+            boundsMax,
+            boundingRadius,
+            dequantization,
+            lods};
+}
 
-    glBufferData(GL_ARRAY_BUFFER, verticesSize, m_vertices.data(), GL_STATIC_DRAW);
+Mesh::Mesh(const View &view, uint32_t material, uint32_t retention)
+        : m_materialId(material),
+          m_format(view.format),
+          m_dequantization(view.dequantization),
+          m_boundsMin(view.boundsMin),
+          m_boundsMax(view.boundsMax),
+          m_bounds{(view.boundsMin + view.boundsMax) * 0.5f, view.boundingRadius},
+          m_lods(view.lods),
+          m_geometry(GeometryArena::forFormat(view.format).allocate(view.vertices, view.indices, view.indexSize)) {
+    if (m_lods.empty()) {
+        m_lods.push_back({0, static_cast<uint32_t>(view.indexCount()), 0.0f});
+    }
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indicesSize, m_indices.data(), GL_STATIC_DRAW);
+    if ((retention & RETAIN_OCCLUDER) != 0) {
+        extractOccluder(view);
+    }
+    if ((retention & RETAIN_GEOMETRY) != 0) {
+        m_retainedVertices.assign(view.vertices.begin(), view.vertices.end());
+        m_retainedIndices.assign(view.indices.begin(), view.indices.end());
+    }
+}
 
-    const unsigned int positionIndex = 0;
-    const unsigned int normalIndex   = 1;
-    const unsigned int texCoordIndex = 2;
+void Mesh::extractOccluder(const View &view) {
+    const Lod &level = m_lods.back();
+    if (level.indexCount / 3 > MAX_OCCLUDER_TRIANGLES) {
+        return;
+    }
 
-    const unsigned int sizeofPosition = 3;
-    const unsigned int sizeofNormal   = 3;
-    const unsigned int sizeofTexCoord = 2;
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    const auto index = [&](size_t i) -> uint32_t {
+        if (view.indexSize == sizeof(uint16_t)) {
+            uint16_t value = 0;
+            std::memcpy(&value, view.indices.data() + i * sizeof(uint16_t), sizeof(value));
+            return value;
+        }
+        uint32_t value = 0;
+        std::memcpy(&value, view.indices.data() + i * sizeof(uint32_t), sizeof(value));
+        return value;
+    };
+
+    const auto position = [&](uint32_t vertex) {
+        if (view.format == FLOAT32) {
+            Vertex decoded{};
+            std::memcpy(&decoded, view.vertices.data() + size_t{vertex} * sizeof(Vertex), sizeof(decoded));
+            return decoded.Position;
+        }
+        Quantization::Vertex encoded{};
+        std::memcpy(&encoded, view.vertices.data() + size_t{vertex} * sizeof(encoded), sizeof(encoded));
+        return Quantization::decodePosition(encoded, view.dequantization);
+    };
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+    // the level indexes into the vertices of the full mesh, only the ones it uses are kept
+    constexpr uint32_t    UNUSED = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> remap(view.vertexCount(), UNUSED);
+
+    m_occluderIndices.reserve(level.indexCount);
+    for (size_t i = level.firstIndex; i < size_t{level.firstIndex} + level.indexCount; i++) {
+        const uint32_t vertex = index(i);
+        if (remap.at(vertex) == UNUSED) {
+            remap[vertex] = static_cast<uint32_t>(m_occluderVertices.size());
+            m_occluderVertices.push_back(position(vertex));
+        }
+        m_occluderIndices.push_back(remap[vertex]);
+    }
+}
 
-    const auto *positionOffset = reinterpret_cast<void *>(offsetof(Vertex, Position));  // NOLINT
-    const auto *normalOffset   = reinterpret_cast<void *>(offsetof(Vertex, Normal));    // NOLINT
-    const auto *texCoordOffset = reinterpret_cast<void *>(offsetof(Vertex, TexCoords)); // NOLINT
+size_t Mesh::getIndexSize() const {
+    return GeometryArena::forFormat(m_format).range(m_geometry).indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t)
+                                                                                                : sizeof(uint32_t);
+}
 
-    // vertex positions
-    glEnableVertexAttribArray(positionIndex);
-    glVertexAttribPointer(positionIndex, sizeofPosition, GL_FLOAT, GL_FALSE, sizeof(Vertex), positionOffset);
+MemoryUsage Mesh::getMemoryUsage() const {
+    const GeometryArena::Range &range = GeometryArena::forFormat(m_format).range(m_geometry);
 
-    // vertex normals
-    glEnableVertexAttribArray(normalIndex);
-    glVertexAttribPointer(normalIndex, sizeofNormal, GL_FLOAT, GL_FALSE, sizeof(Vertex), normalOffset);
+    MemoryUsage usage;
+    usage.cpuBytes = m_lods.capacity() * sizeof(Lod) + m_occluderVertices.capacity() * sizeof(glm::vec3) +
+                     m_occluderIndices.capacity() * sizeof(uint32_t) + m_retainedVertices.capacity() +
+                     m_retainedIndices.capacity();
+    usage.bufferBytes = static_cast<size_t>(range.vertexCount) * vertexSize(m_format) + range.indexBytes;
+    return usage;
+}
 
-    // vertex texture coords
-    glEnableVertexAttribArray(texCoordIndex);
-    glVertexAttribPointer(texCoordIndex, sizeofTexCoord, GL_FLOAT, GL_FALSE, sizeof(Vertex), texCoordOffset);
+void Mesh::deleteMesh() const {
+    GeometryArena::forFormat(m_format).free(m_geometry);
+}
 
-    glBindVertexArray(0);
+Mesh::Uniforms Mesh::prepareShader(const Shader &shader) {
+    return {shader.getUniform("positionOffset"),
+            shader.getUniform("positionScale"),
+            shader.getUniform("octahedralNormals")};
 }
 
-void Mesh::Draw(Shader &shader) {
-    unsigned int diffuseNr   = 1;
-    unsigned int specularNr  = 1;
-    unsigned int roughnessNr = 1;
+void Mesh::bindUniforms(const Uniforms &uniforms) const {
+    Shader::setVec3(uniforms.positionOffset, m_dequantization.offset);
+    Shader::setVec3(uniforms.positionScale, m_dequantization.scale);
+    Shader::setBool(uniforms.octahedralNormals, m_format == QUANTIZED_OCTAHEDRAL);
+}
 
-    // BUG: If the mesh doesn't have one of the texture types,
-    // the shader will use the last texture of that type
-    for (unsigned int i = 0; i < m_textures.size(); i++) {
-        const auto texture = m_textures[i];
+void Mesh::drawElements(GLsizei instanceCount, uint32_t lod) const {
+    const GeometryArena::Range &range = GeometryArena::forFormat(m_format).range(m_geometry);
+    const Lod                  &level = m_lods.at(lod);
+
+    const size_t indexSize = range.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+    const size_t offset    = range.indexOffset + level.firstIndex * indexSize;
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast, performance-no-int-to-ptr)
+    auto *firstIndex = reinterpret_cast<void *>(offset);
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES,
+                                      static_cast<GLsizei>(level.indexCount),
+                                      range.indexType,
+                                      firstIndex,
+                                      instanceCount,
+                                      range.baseVertex);
+}
 
-        glActiveTexture(GL_TEXTURE0 + i);
+uint32_t Mesh::selectLod(float projectedRadius, uint32_t current) const {
+    auto projectedError = [&](uint32_t lod) { return m_lods[lod].error * projectedRadius; };
 
-        std::string number = texture.type == ::Texture::DIFFUSE     ? std::to_string(diffuseNr++)
-                             : texture.type == ::Texture::SPECULAR  ? std::to_string(specularNr++)
-                             : texture.type == ::Texture::ROUGHNESS ? std::to_string(roughnessNr++)
-                                                                    : "";
+    current = std::min(current, getLodCount() - 1);
 
-        shader.setInt(texture.type + number, (int)i);
-        glBindTexture(GL_TEXTURE_2D, texture.id);
+    // the coarsest level within the threshold, the errors grow with the level
+    uint32_t lod = 0;
+    while (lod + 1 < getLodCount() && projectedError(lod + 1) <= LOD_ERROR_PIXELS) {
+        lod++;
     }
 
-    shader.setFloat("material_shininess", m_shininess);
+    if (lod > current) {
+        // only get coarser once the error is comfortably below the threshold
+        while (lod > current && projectedError(lod) > LOD_ERROR_PIXELS / LOD_HYSTERESIS) {
+            lod--;
+        }
+    } else if (lod < current && projectedError(current) <= LOD_ERROR_PIXELS * LOD_HYSTERESIS) {
+        // and only get finer once the current level is clearly too coarse
+        lod = current;
+    }
 
-    glActiveTexture(GL_TEXTURE0);
+    return lod;
+}
 
-    // draw mesh
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, m_indices.size(), GL_UNSIGNED_INT, nullptr);
-    glBindVertexArray(0);
-}
\ No newline at end of file
+GLuint Mesh::getVertexArray() const {
+    return GeometryArena::forFormat(m_format).getVertexArray();
+}
@@ -2,10 +2,15 @@
 
 #include <glm/glm.hpp>
 
+#include <cstddef>
+#include <cstdint>
+#include <span>
 #include <vector>
 #include <string>
 
+#include <Render/Frustum.hpp>
 #include <Shader.hpp>
+#include <Utility/MemoryUsage.hpp>
 
 class Mesh {
     public:
@@ -21,30 +26,163 @@ class Mesh {
         std::string  path;
     };
 
-    Mesh(std::vector<Vertex>       vertices,
-         std::vector<unsigned int> indices,
-         std::vector<Texture>      textures,
-         float                     shininess);
+    // Layout of the vertices on the GPU
+    enum VertexFormat : uint32_t {
+        FLOAT32,              // Vertex as is, 32 bytes
+        QUANTIZED,            // 16 bit position, 10_10_10_2 normal, half float UV, 16 bytes
+        QUANTIZED_OCTAHEDRAL, // 16 bit position, 2x16 bit octahedral normal, half float UV, 16 bytes
+        VERTEX_FORMAT_COUNT
+    };
+
+    static size_t vertexSize(VertexFormat format);
+
+    // A level of detail is a range of the mesh's indices into the shared vertices, level 0 is the full mesh
+    struct Lod {
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        float    error; // estimated surface deviation relative to the bounding radius
+    };
+
+    static constexpr size_t MAX_LODS = 4;
+
+    // A level is used while its error stays below LOD_ERROR_PIXELS on screen, switching levels needs the error to
+    // pass the threshold by LOD_HYSTERESIS so meshes close to it don't flicker between two levels
+    static constexpr float LOD_ERROR_PIXELS = 1.0f;
+    static constexpr float LOD_HYSTERESIS   = 1.5f;
+
+    // The coarsest level is kept on the CPU as an occluder for OcclusionCuller unless it has more triangles than this
+    static constexpr size_t MAX_OCCLUDER_TRIANGLES = 4096;
+
+    // What a mesh keeps on the CPU after its geometry is uploaded, a combination of the flags
+    enum Retention : uint32_t {
+        RETAIN_NOTHING  = 0,
+        RETAIN_OCCLUDER = 1 << 0, // the coarsest level for OcclusionCuller
+        RETAIN_GEOMETRY = 1 << 1, // a copy of the uploaded vertices and indices, for picking or uploading them again
+    };
 
-    void deleteMesh() {
-        glDeleteVertexArrays(1, &VAO);
-        glDeleteBuffers(1, &VBO);
-        glDeleteBuffers(1, &EBO);
-    }
+    // Quantized positions are stored relative to the mesh bounds, position = offset + stored * scale
+    struct Dequantization {
+        glm::vec3 offset{0.0f};
+        glm::vec3 scale{1.0f};
+    };
+
+    // Mesh::Data or a mapped mesh cache entry, the geometry isn't owned
+    struct View {
+        VertexFormat               format;
+        std::span<const std::byte> vertices; // encoded in format
+        std::span<const std::byte> indices;  // 16 or 32 bit, see indexSize
+        size_t                     indexSize;
+        std::vector<Texture>       textures;
+        float                      shininess;
+        glm::vec3                  boundsMin;
+        glm::vec3                  boundsMax;
+        float                      boundingRadius; // around the center of the bounds
+        Dequantization             dequantization;
+        std::vector<Lod>           lods; // empty when there is only the full mesh
+
+        [[nodiscard]] size_t vertexCount() const { return vertices.size() / vertexSize(format); }
+        [[nodiscard]] size_t indexCount() const { return indices.size() / indexSize; }
+    };
+
+    // CPU-side mesh as produced by the importer, before it is uploaded
+    struct Data {
+        std::vector<Vertex>       vertices; // always full precision, what the import stages work on
+        std::vector<unsigned int> indices;
+        std::vector<Texture>      textures;
+        float                     shininess;
+        std::vector<Lod>          lods; // filled by the optimizer, the index lists follow each other in indices
+        glm::vec3                 boundsMin{0.0f};
+        glm::vec3                 boundsMax{0.0f};
+        float                     boundingRadius = 0.0f;
 
-    void Draw(Shader& shader);
+        // vertices in the upload format, empty for FLOAT32
+        VertexFormat           format = FLOAT32;
+        std::vector<std::byte> encodedVertices;
+        Dequantization         dequantization;
+
+        // indices narrowed to 16 bit, filled by the optimizer when every vertex can be addressed with them
+        std::vector<uint16_t> shortIndices;
+
+        // largest difference between the encoded and the original vertices
+        float maxPositionError = 0.0f;
+        float maxNormalError   = 0.0f; // degrees
+
+        [[nodiscard]] View view() const;
+    };
+
+    // The geometry is only read during construction, it is copied into the arena of its format and can point straight
+    // into a mapped mesh cache. The material is an index into MaterialLibrary::shared(), retention the Retention flags.
+    Mesh(const View &view, uint32_t material, uint32_t retention = RETAIN_OCCLUDER);
+
+    // Releases the geometry, the arena can hand the space to other meshes
+    void deleteMesh() const;
+
+    // Uniform handles used by bindUniforms, resolved once per program
+    struct Uniforms {
+        Shader::Uniform positionOffset;
+        Shader::Uniform positionScale;
+        Shader::Uniform octahedralNormals;
+    };
+
+    static Uniforms prepareShader(const Shader &shader);
+
+    // Sets the per-mesh vertex decoding uniforms
+    void bindUniforms(const Uniforms &uniforms) const;
+
+    // Issues the draw call, the vertex array and the instance attributes have to be bound
+    void drawElements(GLsizei instanceCount = 1, uint32_t lod = 0) const;
+
+    // Picks the level for a mesh whose bounding sphere covers projectedRadius pixels, current is the level it was
+    // drawn with last
+    [[nodiscard]] uint32_t selectLod(float projectedRadius, uint32_t current) const;
+
+    // Meshes of the same format share their arena's vertex array
+    [[nodiscard]] GLuint getVertexArray() const;
+
+    [[nodiscard]] uint32_t       getMaterialId() const noexcept { return m_materialId; }
+    [[nodiscard]] glm::vec3      getCenter() const noexcept { return m_bounds.center; }
+    [[nodiscard]] BoundingSphere getBoundingSphere() const noexcept { return m_bounds; }
+    [[nodiscard]] glm::vec3      getBoundsMin() const noexcept { return m_boundsMin; }
+    [[nodiscard]] glm::vec3      getBoundsMax() const noexcept { return m_boundsMax; }
+    [[nodiscard]] VertexFormat   getVertexFormat() const noexcept { return m_format; }
+    [[nodiscard]] uint32_t       getLodCount() const noexcept { return static_cast<uint32_t>(m_lods.size()); }
+    [[nodiscard]] uint32_t       getTriangleCount(uint32_t lod = 0) const { return m_lods.at(lod).indexCount / 3; }
+
+    // Model space triangles of the occluder, both empty when the mesh has none
+    [[nodiscard]] std::span<const glm::vec3> getOccluderVertices() const noexcept { return m_occluderVertices; }
+    [[nodiscard]] std::span<const uint32_t>  getOccluderIndices() const noexcept { return m_occluderIndices; }
+
+    // The uploaded vertices in getVertexFormat() and indices of getIndexSize() bytes, empty unless RETAIN_GEOMETRY
+    [[nodiscard]] std::span<const std::byte> getRetainedVertices() const noexcept { return m_retainedVertices; }
+    [[nodiscard]] std::span<const std::byte> getRetainedIndices() const noexcept { return m_retainedIndices; }
+    [[nodiscard]] size_t                     getIndexSize() const;
+
+    // What the mesh holds on the CPU and its share of the arena, the arena's buffers are counted by the arena
+    [[nodiscard]] MemoryUsage getMemoryUsage() const;
 
     private:
     // mesh data
-    std::vector<Vertex>       m_vertices;
-    std::vector<unsigned int> m_indices;
-    std::vector<Texture>      m_textures;
-    float                     m_shininess;
+    uint32_t       m_materialId = 0;
+    VertexFormat   m_format     = FLOAT32;
+    Dequantization m_dequantization;
+
+    // model space bounds, the sphere is centered on the box
+    glm::vec3      m_boundsMin{0.0f};
+    glm::vec3      m_boundsMax{0.0f};
+    BoundingSphere m_bounds;
+
+    std::vector<Lod> m_lods; // never empty
+
+    // the coarsest level with its own compact vertices
+    std::vector<glm::vec3> m_occluderVertices;
+    std::vector<uint32_t>  m_occluderIndices;
+
+    // copies of the uploaded geometry, see RETAIN_GEOMETRY
+    std::vector<std::byte> m_retainedVertices;
+    std::vector<std::byte> m_retainedIndices;
 
-    //  render data
-    unsigned int VAO = 0;
-    unsigned int VBO = 0;
-    unsigned int EBO = 0;
+    void extractOccluder(const View &view);
 
-    void setupMesh();
+    //  render data, a handle into the arena of m_format
+    uint32_t m_geometry = 0;
 };
\ No newline at end of file
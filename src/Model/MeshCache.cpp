@@ -0,0 +1,436 @@
+#include "MeshCache.hpp"
+
+#include <algorithm>
+#include <array>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include <Utility/BinaryIO.hpp>
+#include <Utility/fs_helpers.hpp>
+
+namespace {
+
+using BinaryIO::alignUp;
+using BinaryIO::readAt;
+using BinaryIO::writePadding;
+using BinaryIO::writeRaw;
+
+constexpr std::array<char, 4> MAGIC{'M', 'C', 'H', 'E'};
+constexpr uint64_t            DATA_ALIGNMENT = 16;
+
+struct FileHeader {
+    std::array<char, 4> magic;
+    uint32_t            version;
+    uint32_t            importFlags;
+    uint32_t            meshCount;
+    uint32_t            vertexFormat;
+    uint32_t            padding;
+    uint64_t            sourceSize;
+    int64_t             sourceModified;
+    uint64_t            sourcePathOffset;
+    uint64_t            sourcePathLength;
+    uint64_t            meshTableOffset;
+    uint64_t            textureTableOffset;
+    uint64_t            textureCount;
+    uint64_t            nodeTableOffset;
+    uint64_t            nodeCount;
+    uint64_t            dependencyTableOffset;
+    uint64_t            dependencyCount;
+    uint64_t            stringsOffset;
+    uint64_t            fileSize;
+};
+
+struct LodRecord {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float    error;
+};
+
+struct MeshRecord {
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t firstTexture;
+    uint32_t textureCount;
+    float    shininess;
+
+    std::array<float, 3> boundsMin;
+    std::array<float, 3> boundsMax;
+    std::array<float, 3> positionOffset;
+    std::array<float, 3> positionScale;
+
+    uint32_t indexSize;
+    float    boundingRadius;
+    uint32_t lodCount;
+
+    std::array<LodRecord, Mesh::MAX_LODS> lods;
+};
+
+struct NodeRecord {
+    uint32_t              parent;
+    uint32_t              firstMesh;
+    uint32_t              meshCount;
+    uint32_t              padding;
+    std::array<float, 16> transform; // column major
+};
+
+struct TextureRecord {
+    uint32_t typeOffset;
+    uint32_t typeLength;
+    uint32_t pathOffset;
+    uint32_t pathLength;
+};
+
+// A file the import read besides the source, with the stamp it had at the time
+struct DependencyRecord {
+    uint32_t pathOffset;
+    uint32_t pathLength;
+    uint64_t size;
+    int64_t  modified;
+};
+
+static_assert(std::is_trivially_copyable_v<Mesh::Vertex>);
+static_assert(sizeof(Mesh::Vertex) == 8 * sizeof(float), "Mesh::Vertex must not contain padding");
+
+std::array<float, 3> toArray(glm::vec3 vector) {
+    return {vector.x, vector.y, vector.z};
+}
+
+glm::vec3 toVec3(const std::array<float, 3> &array) {
+    return {array[0], array[1], array[2]};
+}
+
+// FNV-1a, only used to name the cache file
+uint64_t hashString(std::string_view string) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const char character : string) {
+        hash ^= static_cast<unsigned char>(character);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// the same for a packed source, the archive keeps the size and write time of the file
+using SourceStamp = fs_helpers::ResourceStamp;
+
+SourceStamp getSourceStamp(const std::filesystem::path &source) {
+    return fs_helpers::getResourceStamp(source);
+}
+
+std::string_view stringAt(const MappedFile &file, const FileHeader &header, uint64_t offset, uint64_t length) {
+    if (header.stringsOffset + offset + length > file.size()) {
+        throw std::runtime_error("MeshCache | String out of bounds");
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast, cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    return {reinterpret_cast<const char *>(file.data() + header.stringsOffset + offset), length};
+}
+
+} // namespace
+
+std::filesystem::path MeshCache::getCachePath(const std::filesystem::path &source, Mesh::VertexFormat format) {
+    return fs_helpers::getPathToCacheDirectory() /
+           std::format("{:016x}-{}.meshcache", hashString(source.string()), static_cast<uint32_t>(format));
+}
+
+std::optional<MeshCache>
+MeshCache::open(const std::filesystem::path &source, unsigned int importFlags, Mesh::VertexFormat format) {
+    const std::filesystem::path cachePath = getCachePath(source, format);
+
+    std::error_code error;
+    if (!std::filesystem::exists(cachePath, error)) {
+        return std::nullopt;
+    }
+
+    MeshCache         cache(MappedFile{cachePath});
+    const MappedFile &file   = cache.m_file;
+    const auto        header = readAt<FileHeader>(file, 0);
+    const SourceStamp stamp  = getSourceStamp(source);
+
+    if (header.magic != MAGIC || header.version != VERSION || header.importFlags != importFlags ||
+        header.vertexFormat != format || header.sourceSize != stamp.size || header.sourceModified != stamp.modified ||
+        header.fileSize != file.size()) {
+        return std::nullopt;
+    }
+
+    if (stringAt(file, header, header.sourcePathOffset, header.sourcePathLength) != source.string()) {
+        return std::nullopt;
+    }
+
+    for (uint64_t i = 0; i < header.dependencyCount; i++) {
+        const auto record = readAt<DependencyRecord>(file, header.dependencyTableOffset + i * sizeof(DependencyRecord));
+        const std::filesystem::path dependency(stringAt(file, header, record.pathOffset, record.pathLength));
+
+        if (!fs_helpers::resourceExists(dependency)) {
+            return std::nullopt;
+        }
+        const SourceStamp dependencyStamp = getSourceStamp(dependency);
+        if (dependencyStamp.size != record.size || dependencyStamp.modified != record.modified) {
+            return std::nullopt;
+        }
+    }
+
+    return cache;
+}
+
+std::vector<MeshCache::Node> MeshCache::nodes() const {
+    const auto header = readAt<FileHeader>(m_file, 0);
+
+    std::vector<Node> nodes;
+    nodes.reserve(header.nodeCount);
+
+    for (uint64_t i = 0; i < header.nodeCount; i++) {
+        const auto record = readAt<NodeRecord>(m_file, header.nodeTableOffset + i * sizeof(NodeRecord));
+        if ((record.parent != NO_PARENT && record.parent >= i) ||
+            uint64_t{record.firstMesh} + record.meshCount > header.meshCount) {
+            throw std::runtime_error("MeshCache::nodes | Corrupted node record");
+        }
+
+        Node node{record.parent, record.firstMesh, record.meshCount, glm::mat4(1.0f)};
+        for (int column = 0; column < 4; column++) {
+            for (int row = 0; row < 4; row++) {
+                node.transform[column][row] = record.transform.at(static_cast<size_t>(column * 4 + row));
+            }
+        }
+        nodes.push_back(node);
+    }
+
+    return nodes;
+}
+
+size_t MeshCache::meshCount() const {
+    return readAt<FileHeader>(m_file, 0).meshCount;
+}
+
+Mesh::View MeshCache::mesh(size_t index) const {
+    const auto header = readAt<FileHeader>(m_file, 0);
+    if (index >= header.meshCount) {
+        throw std::out_of_range(std::format("MeshCache::mesh | Index {} out of range", index));
+    }
+
+    const auto record = readAt<MeshRecord>(m_file, header.meshTableOffset + index * sizeof(MeshRecord));
+
+    const auto     format       = static_cast<Mesh::VertexFormat>(header.vertexFormat);
+    const uint64_t verticesSize = uint64_t{record.vertexCount} * Mesh::vertexSize(format);
+    const uint64_t indicesSize  = uint64_t{record.indexCount} * record.indexSize;
+    if (record.vertexOffset + verticesSize > m_file.size() || record.indexOffset + indicesSize > m_file.size() ||
+        record.firstTexture + record.textureCount > header.textureCount ||
+        (record.indexSize != sizeof(uint16_t) && record.indexSize != sizeof(unsigned int)) ||
+        record.lodCount > Mesh::MAX_LODS) {
+        throw std::runtime_error("MeshCache::mesh | Corrupted mesh record");
+    }
+
+    Mesh::View view{};
+    view.format = format;
+
+    // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast, cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    view.vertices = {reinterpret_cast<const std::byte *>(m_file.data() + record.vertexOffset), verticesSize};
+    view.indices  = {reinterpret_cast<const std::byte *>(m_file.data() + record.indexOffset), indicesSize};
+    // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast, cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+    view.indexSize             = record.indexSize;
+    view.shininess             = record.shininess;
+    view.boundsMin             = toVec3(record.boundsMin);
+    view.boundsMax             = toVec3(record.boundsMax);
+    view.boundingRadius        = record.boundingRadius;
+    view.dequantization.offset = toVec3(record.positionOffset);
+    view.dequantization.scale  = toVec3(record.positionScale);
+
+    for (uint32_t i = 0; i < record.lodCount; i++) {
+        const LodRecord &lod = record.lods.at(i);
+        if (uint64_t{lod.firstIndex} + lod.indexCount > record.indexCount) {
+            throw std::runtime_error("MeshCache::mesh | Corrupted level of detail");
+        }
+        view.lods.push_back({lod.firstIndex, lod.indexCount, lod.error});
+    }
+
+    for (uint32_t i = 0; i < record.textureCount; i++) {
+        const auto texture = readAt<TextureRecord>(
+                m_file, header.textureTableOffset + (uint64_t{record.firstTexture} + i) * sizeof(TextureRecord));
+
+        view.textures.push_back({0,
+                                 std::string(stringAt(m_file, header, texture.typeOffset, texture.typeLength)),
+                                 std::string(stringAt(m_file, header, texture.pathOffset, texture.pathLength))});
+    }
+
+    return view;
+}
+
+void MeshCache::write(const std::filesystem::path           &source,
+                      std::span<const std::filesystem::path> dependencies,
+                      unsigned int                           importFlags,
+                      Mesh::VertexFormat                     format,
+                      std::span<const Mesh::Data>            meshes,
+                      std::span<const Node>                  nodes) {
+    const SourceStamp stamp = getSourceStamp(source);
+
+    // lay the string table and the tables out before writing anything
+    std::string                   strings = source.string();
+    std::vector<MeshRecord>       meshRecords;
+    std::vector<TextureRecord>    textureRecords;
+    std::vector<DependencyRecord> dependencyRecords;
+
+    auto addString = [&strings](const std::string &string) {
+        const auto offset = static_cast<uint32_t>(strings.size());
+        strings += string;
+        return offset;
+    };
+
+    // Assimp may open a file more than once, the source is already stamped in the header
+    std::vector<std::string> dependencyPaths;
+    for (const auto &dependency : dependencies) {
+        dependencyPaths.push_back(dependency.string());
+    }
+    std::ranges::sort(dependencyPaths);
+    const auto duplicates = std::ranges::unique(dependencyPaths);
+    dependencyPaths.erase(duplicates.begin(), duplicates.end());
+    std::erase(dependencyPaths, source.string());
+
+    for (const auto &path : dependencyPaths) {
+        const SourceStamp dependencyStamp = getSourceStamp(path);
+
+        DependencyRecord record{};
+        record.pathOffset = addString(path);
+        record.pathLength = static_cast<uint32_t>(path.size());
+        record.size       = dependencyStamp.size;
+        record.modified   = dependencyStamp.modified;
+        dependencyRecords.push_back(record);
+    }
+
+    for (const auto &mesh : meshes) {
+        MeshRecord record{};
+        record.vertexCount  = static_cast<uint32_t>(mesh.vertices.size());
+        record.indexCount   = static_cast<uint32_t>(mesh.indices.size());
+        record.firstTexture = static_cast<uint32_t>(textureRecords.size());
+        record.textureCount = static_cast<uint32_t>(mesh.textures.size());
+        record.shininess    = mesh.shininess;
+
+        record.boundsMin      = toArray(mesh.boundsMin);
+        record.boundsMax      = toArray(mesh.boundsMax);
+        record.boundingRadius = mesh.boundingRadius;
+        record.positionOffset = toArray(mesh.dequantization.offset);
+        record.positionScale  = toArray(mesh.dequantization.scale);
+
+        record.lodCount = static_cast<uint32_t>(std::min(mesh.lods.size(), Mesh::MAX_LODS));
+        for (uint32_t i = 0; i < record.lodCount; i++) {
+            record.lods.at(i) = {mesh.lods[i].firstIndex, mesh.lods[i].indexCount, mesh.lods[i].error};
+        }
+
+        for (const auto &texture : mesh.textures) {
+            TextureRecord textureRecord{};
+            textureRecord.typeOffset = addString(texture.type);
+            textureRecord.typeLength = static_cast<uint32_t>(texture.type.size());
+            textureRecord.pathOffset = addString(texture.path);
+            textureRecord.pathLength = static_cast<uint32_t>(texture.path.size());
+            textureRecords.push_back(textureRecord);
+        }
+
+        meshRecords.push_back(record);
+    }
+
+    FileHeader header{};
+    header.magic              = MAGIC;
+    header.version            = VERSION;
+    header.importFlags        = importFlags;
+    header.meshCount          = static_cast<uint32_t>(meshes.size());
+    header.vertexFormat       = format;
+    header.sourceSize         = stamp.size;
+    header.sourceModified     = stamp.modified;
+    header.sourcePathOffset   = 0;
+    header.sourcePathLength   = source.string().size();
+    header.meshTableOffset    = alignUp(sizeof(FileHeader), DATA_ALIGNMENT);
+    header.textureTableOffset = alignUp(header.meshTableOffset + meshRecords.size() * sizeof(MeshRecord), DATA_ALIGNMENT);
+    header.textureCount       = textureRecords.size();
+    header.nodeTableOffset    = alignUp(header.textureTableOffset + textureRecords.size() * sizeof(TextureRecord),
+                                     DATA_ALIGNMENT);
+    header.nodeCount          = nodes.size();
+
+    header.dependencyTableOffset = alignUp(header.nodeTableOffset + nodes.size() * sizeof(NodeRecord), DATA_ALIGNMENT);
+    header.dependencyCount       = dependencyRecords.size();
+    header.stringsOffset         = alignUp(
+            header.dependencyTableOffset + dependencyRecords.size() * sizeof(DependencyRecord), DATA_ALIGNMENT);
+
+    std::vector<Mesh::View> views;
+    for (const auto &mesh : meshes) {
+        if (mesh.format != format) {
+            throw std::invalid_argument("MeshCache::write | Every mesh must be encoded in the cache's vertex format");
+        }
+        views.push_back(mesh.view());
+    }
+
+    uint64_t offset = header.stringsOffset + strings.size();
+    for (size_t i = 0; i < meshes.size(); i++) {
+        meshRecords[i].vertexOffset = alignUp(offset, DATA_ALIGNMENT);
+        meshRecords[i].indexOffset  = alignUp(meshRecords[i].vertexOffset + views[i].vertices.size(), DATA_ALIGNMENT);
+        meshRecords[i].indexSize    = static_cast<uint32_t>(views[i].indexSize);
+        offset                      = meshRecords[i].indexOffset + views[i].indices.size();
+    }
+    header.fileSize = offset;
+
+    const std::filesystem::path cachePath = getCachePath(source, format);
+    std::filesystem::create_directories(cachePath.parent_path());
+
+    // write to a temporary file first so a crash never leaves a half written entry behind
+    std::filesystem::path temporaryPath = cachePath;
+    temporaryPath += ".tmp";
+
+    std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+    if (file.fail()) {
+        throw std::runtime_error(std::format("MeshCache::write | Failed to open file: {}", temporaryPath.string()));
+    }
+
+    writeRaw(file, header);
+
+    writePadding(file, header.meshTableOffset);
+    for (const auto &record : meshRecords) {
+        writeRaw(file, record);
+    }
+
+    writePadding(file, header.textureTableOffset);
+    for (const auto &record : textureRecords) {
+        writeRaw(file, record);
+    }
+
+    writePadding(file, header.nodeTableOffset);
+    for (const auto &node : nodes) {
+        NodeRecord record{};
+        record.parent    = node.parent;
+        record.firstMesh = node.firstMesh;
+        record.meshCount = node.meshCount;
+        for (int column = 0; column < 4; column++) {
+            for (int row = 0; row < 4; row++) {
+                record.transform.at(static_cast<size_t>(column * 4 + row)) = node.transform[column][row];
+            }
+        }
+        writeRaw(file, record);
+    }
+
+    writePadding(file, header.dependencyTableOffset);
+    for (const auto &record : dependencyRecords) {
+        writeRaw(file, record);
+    }
+
+    writePadding(file, header.stringsOffset);
+    file.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+
+    for (size_t i = 0; i < meshes.size(); i++) {
+        const Mesh::View &view = views[i];
+
+        writePadding(file, meshRecords[i].vertexOffset);
+        BinaryIO::writeBytes(file, view.vertices);
+
+        writePadding(file, meshRecords[i].indexOffset);
+        BinaryIO::writeBytes(file, view.indices);
+    }
+
+    file.close();
+    if (file.fail()) {
+        throw std::runtime_error(std::format("MeshCache::write | Failed to write file: {}", temporaryPath.string()));
+    }
+
+    std::filesystem::rename(temporaryPath, cachePath);
+}
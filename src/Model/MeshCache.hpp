@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <Utility/MappedFile.hpp>
+#include "Mesh.hpp"
+
+// Binary cache of imported meshes, stored in the cache directory next to the binary.
+//
+// The file is keyed on the source path, its size and modification time, the Assimp import flags and the vertex format.
+// The size and modification time of every other file the import read, like an OBJ material library, are stored too so
+// editing one of them also invalidates the entry.
+// It is written once after an import and memory mapped on later runs, the vertex and index spans point straight into
+// the mapping. Vertices are stored already encoded, so quantized models are uploaded without touching them.
+class MeshCache {
+    public:
+    static constexpr uint32_t NO_PARENT = std::numeric_limits<uint32_t>::max();
+
+    // Node of the imported hierarchy in preorder, it owns the meshes [firstMesh, firstMesh + meshCount)
+    struct Node {
+        uint32_t  parent; // index into the node list, NO_PARENT for the root
+        uint32_t  firstMesh;
+        uint32_t  meshCount;
+        glm::mat4 transform; // relative to the parent
+    };
+
+    // Returns an empty optional if there is no entry or if it is stale
+    static std::optional<MeshCache>
+                open(const std::filesystem::path &source, unsigned int importFlags, Mesh::VertexFormat format);
+    static void write(const std::filesystem::path           &source,
+                      std::span<const std::filesystem::path> dependencies,
+                      unsigned int                           importFlags,
+                      Mesh::VertexFormat                     format,
+                      std::span<const Mesh::Data>            meshes,
+                      std::span<const Node>                  nodes);
+
+    [[nodiscard]] size_t            meshCount() const;
+    [[nodiscard]] Mesh::View        mesh(size_t index) const;
+    [[nodiscard]] std::vector<Node> nodes() const;
+
+    private:
+    static constexpr uint32_t VERSION = 7;
+
+    MappedFile m_file;
+
+    explicit MeshCache(MappedFile file) : m_file(std::move(file)) {}
+
+    static std::filesystem::path getCachePath(const std::filesystem::path &source, Mesh::VertexFormat format);
+};
@@ -0,0 +1,424 @@
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+namespace {
+
+constexpr unsigned int UNUSED = std::numeric_limits<unsigned int>::max();
+constexpr size_t       NONE   = std::numeric_limits<size_t>::max();
+
+// Forsyth's scoring parameters, the cache is the modelled one and not the analysis cache
+constexpr size_t FORSYTH_CACHE_SIZE  = 32;
+constexpr float  CACHE_DECAY_POWER   = 1.5f;
+constexpr float  LAST_TRIANGLE_SCORE = 0.75f;
+constexpr float  VALENCE_BOOST_SCALE = 2.0f;
+constexpr float  VALENCE_BOOST_POWER = 0.5f;
+
+struct VertexHash {
+    size_t operator()(const Mesh::Vertex &vertex) const noexcept {
+        std::array<uint32_t, sizeof(Mesh::Vertex) / sizeof(uint32_t)> words{};
+        std::memcpy(words.data(), &vertex, sizeof(Mesh::Vertex));
+
+        uint64_t hash = 14695981039346656037ULL;
+        for (const uint32_t word : words) {
+            hash ^= word;
+            hash *= 1099511628211ULL;
+        }
+        return static_cast<size_t>(hash);
+    }
+};
+
+struct VertexEqual {
+    bool operator()(const Mesh::Vertex &a, const Mesh::Vertex &b) const noexcept {
+        return std::memcmp(&a, &b, sizeof(Mesh::Vertex)) == 0;
+    }
+};
+
+float vertexScore(int cachePosition, uint32_t remainingTriangles) {
+    if (remainingTriangles == 0) {
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            // the vertices of the last triangle get a fixed score so the next triangle doesn't simply reuse them
+            score = LAST_TRIANGLE_SCORE;
+        } else {
+            const float scale = 1.0f / static_cast<float>(FORSYTH_CACHE_SIZE - 3);
+            score = std::pow(1.0f - static_cast<float>(cachePosition - 3) * scale, CACHE_DECAY_POWER);
+        }
+    }
+
+    // vertices with few triangles left are finished first so they don't linger
+    score += VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+    return score;
+}
+
+struct Cluster {
+    size_t firstTriangle;
+    size_t triangleCount;
+    float  sortKey;
+};
+
+} // namespace
+
+MeshOptimizer::Stats &MeshOptimizer::Stats::operator+=(const Stats &other) {
+    vertices += other.vertices;
+    indexBytes += other.indexBytes;
+    triangles += other.triangles;
+    cacheMisses += other.cacheMisses;
+    for (size_t i = 0; i < lodTriangles.size(); i++) {
+        lodTriangles.at(i) += other.lodTriangles.at(i);
+    }
+    return *this;
+}
+
+MeshOptimizer::Report MeshOptimizer::optimize(Mesh::Data &mesh) {
+    Report report{};
+    report.before = analyze(mesh);
+
+    weld(mesh);
+    generateLods(mesh);
+
+    for (size_t i = 0; i < mesh.lods.size(); i++) {
+        const auto range = std::span(mesh.indices).subspan(mesh.lods[i].firstIndex, mesh.lods[i].indexCount);
+
+        std::vector<unsigned int> optimized = optimizeVertexCache(range, mesh.vertices.size());
+        if (i == 0) {
+            optimized = optimizeOverdraw(optimized, mesh.vertices, OVERDRAW_THRESHOLD);
+        }
+        std::ranges::copy(optimized, range.begin());
+    }
+
+    optimizeVertexFetch(mesh);
+    narrowIndices(mesh);
+
+    report.after = analyze(mesh);
+    return report;
+}
+
+MeshOptimizer::Stats MeshOptimizer::analyze(const Mesh::Data &mesh) {
+    // the cache figures are about the full mesh, the levels only contribute their triangle counts
+    const auto full = std::span(mesh.indices).first(mesh.lods.empty() ? mesh.indices.size() : mesh.lods[0].indexCount);
+
+    Stats stats{};
+    stats.vertices    = mesh.vertices.size();
+    stats.indexBytes  = mesh.indices.size() * (mesh.shortIndices.empty() ? sizeof(unsigned int) : sizeof(uint16_t));
+    stats.triangles   = full.size() / 3;
+    stats.cacheMisses = countCacheMisses(full, mesh.vertices.size(), ANALYSIS_CACHE_SIZE);
+
+    stats.lodTriangles[0] = stats.triangles;
+    for (size_t i = 1; i < mesh.lods.size(); i++) {
+        stats.lodTriangles.at(i) = mesh.lods[i].indexCount / 3;
+    }
+    return stats;
+}
+
+void MeshOptimizer::weld(Mesh::Data &mesh) {
+    std::unordered_map<Mesh::Vertex, unsigned int, VertexHash, VertexEqual> unique;
+    unique.reserve(mesh.vertices.size());
+
+    std::vector<Mesh::Vertex> welded;
+    std::vector<unsigned int> remap(mesh.vertices.size());
+
+    for (size_t i = 0; i < mesh.vertices.size(); i++) {
+        const auto next                 = static_cast<unsigned int>(welded.size());
+        const auto [iterator, inserted] = unique.try_emplace(mesh.vertices[i], next);
+        if (inserted) {
+            welded.push_back(mesh.vertices[i]);
+        }
+        remap[i] = iterator->second;
+    }
+
+    for (auto &index : mesh.indices) {
+        index = remap.at(index);
+    }
+
+    mesh.vertices = std::move(welded);
+}
+
+void MeshOptimizer::generateLods(Mesh::Data &mesh) {
+    const size_t fullIndexCount = mesh.indices.size();
+    mesh.lods.assign(1, {0, static_cast<uint32_t>(fullIndexCount), 0.0f});
+
+    // every level is simplified from the full mesh, so the errors don't compound
+    const std::vector<unsigned int> full = mesh.indices;
+
+    for (size_t i = 0; i < LOD_RATIOS.size(); i++) {
+        const size_t previous = mesh.lods.back().indexCount;
+        const size_t target   = static_cast<size_t>(static_cast<float>(fullIndexCount) * LOD_RATIOS.at(i)) / 3 * 3;
+
+        float                           error = 0.0f;
+        const std::vector<unsigned int> level =
+                MeshSimplifier::simplify(full, mesh.vertices, target, LOD_ERRORS.at(i), error);
+
+        if (static_cast<float>(level.size()) > static_cast<float>(previous) * LOD_MIN_REDUCTION ||
+            level.size() / 3 < LOD_MIN_TRIANGLES) {
+            break;
+        }
+
+        // level selection relies on the errors growing along the chain
+        error = std::max(error, mesh.lods.back().error);
+        mesh.lods.push_back({static_cast<uint32_t>(mesh.indices.size()), static_cast<uint32_t>(level.size()), error});
+        mesh.indices.insert(mesh.indices.end(), level.begin(), level.end());
+    }
+}
+
+std::vector<unsigned int> MeshOptimizer::optimizeVertexCache(std::span<const unsigned int> indices,
+                                                             size_t                        vertexCount) {
+    const size_t triangleCount = indices.size() / 3;
+
+    // triangles of every vertex, the first remaining[vertex] entries are the ones not emitted yet
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for (const unsigned int index : indices) {
+        remaining.at(index)++;
+    }
+
+    std::vector<size_t> offsets(vertexCount + 1, 0);
+    for (size_t vertex = 0; vertex < vertexCount; vertex++) {
+        offsets[vertex + 1] = offsets[vertex] + remaining[vertex];
+    }
+
+    std::vector<uint32_t> adjacency(indices.size());
+    {
+        std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t triangle = 0; triangle < triangleCount; triangle++) {
+            for (size_t corner = 0; corner < 3; corner++) {
+                adjacency[fill[indices[triangle * 3 + corner]]++] = static_cast<uint32_t>(triangle);
+            }
+        }
+    }
+
+    std::vector<float> scores(vertexCount);
+    for (size_t vertex = 0; vertex < vertexCount; vertex++) {
+        scores[vertex] = vertexScore(-1, remaining[vertex]);
+    }
+
+    std::vector<bool>         emitted(triangleCount, false);
+    std::vector<unsigned int> result;
+    result.reserve(triangleCount * 3);
+
+    std::vector<unsigned int> cache;
+    std::vector<unsigned int> nextCache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    nextCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+    size_t cursor = 0;
+    size_t best   = NONE;
+
+    for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+        if (best == NONE) {
+            // nothing in the cache has triangles left, continue with the next triangle in input order
+            while (emitted[cursor]) {
+                cursor++;
+            }
+            best = cursor;
+        }
+
+        const size_t triangle = best;
+        emitted[triangle]     = true;
+
+        nextCache.clear();
+        for (size_t corner = 0; corner < 3; corner++) {
+            const unsigned int vertex = indices[triangle * 3 + corner];
+            result.push_back(vertex);
+
+            if (std::ranges::find(nextCache, vertex) == nextCache.end()) {
+                nextCache.push_back(vertex);
+            }
+
+            // move the triangle out of the remaining part of the adjacency list
+            auto begin    = adjacency.begin() + static_cast<std::ptrdiff_t>(offsets[vertex]);
+            auto end      = begin + remaining[vertex];
+            auto iterator = std::find(begin, end, static_cast<uint32_t>(triangle));
+            std::iter_swap(iterator, end - 1);
+            remaining[vertex]--;
+        }
+
+        for (const unsigned int vertex : cache) {
+            if (std::ranges::find(nextCache, vertex) == nextCache.end()) {
+                nextCache.push_back(vertex);
+            }
+        }
+
+        for (size_t position = 0; position < nextCache.size(); position++) {
+            const unsigned int vertex        = nextCache[position];
+            const int          cachePosition = position < FORSYTH_CACHE_SIZE ? static_cast<int>(position) : -1;
+
+            // vertices pushed out of the cache lose their cache score
+            scores[vertex] = vertexScore(cachePosition, remaining[vertex]);
+        }
+
+        nextCache.resize(std::min(nextCache.size(), FORSYTH_CACHE_SIZE));
+        std::swap(cache, nextCache);
+
+        // the next triangle is the best one touching the cache
+        best            = NONE;
+        float bestScore = -std::numeric_limits<float>::infinity();
+
+        for (const unsigned int vertex : cache) {
+            for (size_t i = 0; i < remaining[vertex]; i++) {
+                const uint32_t candidate = adjacency[offsets[vertex] + i];
+                const float    score     = scores[indices[candidate * 3]] + scores[indices[candidate * 3 + 1]] +
+                                    scores[indices[candidate * 3 + 2]];
+
+                if (score > bestScore) {
+                    bestScore = score;
+                    best      = candidate;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+std::vector<unsigned int> MeshOptimizer::optimizeOverdraw(std::span<const unsigned int>  indices,
+                                                          std::span<const Mesh::Vertex> vertices,
+                                                          float                         threshold) {
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) {
+        return {indices.begin(), indices.end()};
+    }
+
+    // a triangle whose three vertices all miss the cache starts a new cluster, reordering whole clusters keeps
+    // most of the cache locality
+    std::vector<Cluster> clusters;
+    {
+        std::vector<size_t> timestamps(vertices.size(), 0);
+        size_t              time = ANALYSIS_CACHE_SIZE + 1;
+
+        for (size_t triangle = 0; triangle < triangleCount; triangle++) {
+            size_t misses = 0;
+            for (size_t corner = 0; corner < 3; corner++) {
+                const unsigned int vertex = indices[triangle * 3 + corner];
+                if (time - timestamps[vertex] > ANALYSIS_CACHE_SIZE) {
+                    timestamps[vertex] = time++;
+                    misses++;
+                }
+            }
+
+            if (clusters.empty() || misses == 3) {
+                clusters.push_back({triangle, 0, 0.0f});
+            }
+            clusters.back().triangleCount++;
+        }
+    }
+
+    if (clusters.size() == 1) {
+        return {indices.begin(), indices.end()};
+    }
+
+    // area weighted centroid and normal of every cluster
+    std::vector<glm::vec3> centroids(clusters.size(), glm::vec3(0.0f));
+    std::vector<glm::vec3> normals(clusters.size(), glm::vec3(0.0f));
+    glm::vec3              meshCentroid(0.0f);
+    float                  meshArea = 0.0f;
+
+    for (size_t i = 0; i < clusters.size(); i++) {
+        float area = 0.0f;
+
+        for (size_t triangle = clusters[i].firstTriangle;
+             triangle < clusters[i].firstTriangle + clusters[i].triangleCount;
+             triangle++) {
+            const glm::vec3 &a = vertices[indices[triangle * 3]].Position;
+            const glm::vec3 &b = vertices[indices[triangle * 3 + 1]].Position;
+            const glm::vec3 &c = vertices[indices[triangle * 3 + 2]].Position;
+
+            const glm::vec3 normal       = glm::cross(b - a, c - a);
+            const float     triangleArea = glm::length(normal);
+
+            centroids[i] += (a + b + c) * (triangleArea / 3.0f);
+            normals[i] += normal;
+            area += triangleArea;
+        }
+
+        meshCentroid += centroids[i];
+        meshArea += area;
+
+        if (area > 0.0f) {
+            centroids[i] /= area;
+        }
+    }
+
+    if (meshArea > 0.0f) {
+        meshCentroid /= meshArea;
+    }
+
+    // clusters far out and facing away from the center are likely occluders, they go first
+    for (size_t i = 0; i < clusters.size(); i++) {
+        const float length  = glm::length(normals[i]);
+        clusters[i].sortKey = length > 0.0f ? glm::dot(centroids[i] - meshCentroid, normals[i] / length) : 0.0f;
+    }
+
+    std::ranges::stable_sort(clusters, [](const Cluster &a, const Cluster &b) { return a.sortKey > b.sortKey; });
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    for (const auto &cluster : clusters) {
+        const auto first = indices.begin() + static_cast<std::ptrdiff_t>(cluster.firstTriangle * 3);
+        result.insert(result.end(), first, first + static_cast<std::ptrdiff_t>(cluster.triangleCount * 3));
+    }
+
+    const auto before = static_cast<float>(countCacheMisses(indices, vertices.size(), ANALYSIS_CACHE_SIZE));
+    const auto after  = static_cast<float>(countCacheMisses(result, vertices.size(), ANALYSIS_CACHE_SIZE));
+    if (after > before * threshold) {
+        return {indices.begin(), indices.end()};
+    }
+
+    return result;
+}
+
+void MeshOptimizer::optimizeVertexFetch(Mesh::Data &mesh) {
+    std::vector<unsigned int> remap(mesh.vertices.size(), UNUSED);
+    std::vector<Mesh::Vertex> ordered;
+    ordered.reserve(mesh.vertices.size());
+
+    // unreferenced vertices are dropped along the way
+    for (auto &index : mesh.indices) {
+        if (remap.at(index) == UNUSED) {
+            remap[index] = static_cast<unsigned int>(ordered.size());
+            ordered.push_back(mesh.vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    mesh.vertices = std::move(ordered);
+}
+
+void MeshOptimizer::narrowIndices(Mesh::Data &mesh) {
+    mesh.shortIndices.clear();
+
+    if (mesh.vertices.size() >= size_t{std::numeric_limits<uint16_t>::max()} + 1) {
+        return;
+    }
+
+    mesh.shortIndices.reserve(mesh.indices.size());
+    for (const unsigned int index : mesh.indices) {
+        mesh.shortIndices.push_back(static_cast<uint16_t>(index));
+    }
+}
+
+size_t MeshOptimizer::countCacheMisses(std::span<const unsigned int> indices, size_t vertexCount, size_t cacheSize) {
+    // FIFO cache, a vertex is still cached while fewer than cacheSize vertices were inserted after it
+    std::vector<size_t> timestamps(vertexCount, 0);
+    size_t              time   = cacheSize + 1;
+    size_t              misses = 0;
+
+    for (const unsigned int index : indices) {
+        if (time - timestamps.at(index) > cacheSize) {
+            timestamps[index] = time++;
+            misses++;
+        }
+    }
+
+    return misses;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "Mesh.hpp"
+
+// Load time geometry optimization, runs on Mesh::Data between the import and the vertex encoding.
+//
+// Assimp is asked for triangulation only, so OBJ files come in with three unique vertices per triangle in file
+// order. optimize() welds identical vertices, simplifies the mesh into a level of detail chain, orders the triangles of
+// every level for the post-transform vertex cache and those of the full mesh for overdraw, orders the vertices by first
+// use so fetches stay local and narrows the indices to 16 bit when possible.
+namespace MeshOptimizer {
+struct Stats {
+    size_t vertices    = 0;
+    size_t indexBytes  = 0;
+    size_t triangles   = 0;
+    size_t cacheMisses = 0; // in a FIFO cache of ANALYSIS_CACHE_SIZE entries
+
+    std::array<size_t, Mesh::MAX_LODS> lodTriangles{}; // zero for the levels that weren't generated
+
+    // average cache miss ratio, transformed vertices per triangle
+    [[nodiscard]] double acmr() const {
+        return triangles == 0 ? 0.0 : static_cast<double>(cacheMisses) / static_cast<double>(triangles);
+    }
+
+    Stats &operator+=(const Stats &other);
+};
+
+struct Report {
+    Stats before;
+    Stats after;
+};
+
+constexpr size_t ANALYSIS_CACHE_SIZE = 16;
+
+// Overdraw ordering is dropped when it makes the ACMR worse than this factor
+constexpr float OVERDRAW_THRESHOLD = 1.05f;
+
+// Index count and error targets of the levels after the full mesh, simplification stops at whichever comes first
+constexpr std::array<float, Mesh::MAX_LODS - 1> LOD_RATIOS{0.5f, 0.25f, 0.125f};
+constexpr std::array<float, Mesh::MAX_LODS - 1> LOD_ERRORS{0.01f, 0.03f, 0.1f};
+
+// The chain ends at the first level that keeps more than this fraction of the previous level's triangles or that falls
+// below LOD_MIN_TRIANGLES
+constexpr float  LOD_MIN_REDUCTION = 0.85f;
+constexpr size_t LOD_MIN_TRIANGLES = 32;
+
+Report optimize(Mesh::Data &mesh);
+
+[[nodiscard]] Stats analyze(const Mesh::Data &mesh);
+
+// Merges bitwise identical vertices and rewrites the indices
+void weld(Mesh::Data &mesh);
+
+// Appends the simplified levels to the indices of a welded mesh and fills mesh.lods
+void generateLods(Mesh::Data &mesh);
+
+// Tom Forsyth's linear-speed vertex cache optimization
+[[nodiscard]] std::vector<unsigned int> optimizeVertexCache(std::span<const unsigned int> indices, size_t vertexCount);
+
+// Splits an already cache optimized triangle order into clusters at cache restarts and draws the clusters facing
+// away from the mesh center first, keeping the order only if the ACMR stays within threshold
+[[nodiscard]] std::vector<unsigned int>
+optimizeOverdraw(std::span<const unsigned int> indices, std::span<const Mesh::Vertex> vertices, float threshold);
+
+// Renumbers the vertices in order of first use
+void optimizeVertexFetch(Mesh::Data &mesh);
+
+// Fills mesh.shortIndices when every vertex fits in 16 bit
+void narrowIndices(Mesh::Data &mesh);
+
+[[nodiscard]] size_t countCacheMisses(std::span<const unsigned int> indices, size_t vertexCount, size_t cacheSize);
+} // namespace MeshOptimizer
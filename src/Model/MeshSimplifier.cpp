@@ -0,0 +1,536 @@
+#include "MeshSimplifier.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+namespace {
+
+constexpr unsigned int NO_VERTEX = std::numeric_limits<unsigned int>::max();
+constexpr unsigned int MULTIPLE  = NO_VERTEX - 1;
+
+// open edges get a plane perpendicular to their triangle, weighted this much more than the triangle planes
+constexpr double BORDER_WEIGHT = 10.0;
+constexpr size_t MAX_PASSES    = 100;
+
+enum class VertexKind : uint8_t {
+    MANIFOLD, // every edge has an opposite, collapses in any direction
+    BORDER,   // on an open border, collapses along it
+    SEAM,     // one of the two vertices at an attribute seam, collapses along it together with its twin
+    LOCKED    // anything more complicated, never collapses
+};
+
+struct Quadric {
+    double a00 = 0.0, a11 = 0.0, a22 = 0.0, a01 = 0.0, a02 = 0.0, a12 = 0.0;
+    double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+    double c      = 0.0;
+    double weight = 0.0;
+
+    // plane dot(normal, p) + distance = 0, normal has unit length
+    static Quadric fromPlane(const glm::vec3 &normal, float distance, double weight) {
+        const double x = normal.x;
+        const double y = normal.y;
+        const double z = normal.z;
+        const double d = distance;
+
+        return {weight * x * x,
+                weight * y * y,
+                weight * z * z,
+                weight * x * y,
+                weight * x * z,
+                weight * y * z,
+                weight * x * d,
+                weight * y * d,
+                weight * z * d,
+                weight * d * d,
+                weight};
+    }
+
+    Quadric &operator+=(const Quadric &other) {
+        a00 += other.a00;
+        a11 += other.a11;
+        a22 += other.a22;
+        a01 += other.a01;
+        a02 += other.a02;
+        a12 += other.a12;
+        b0 += other.b0;
+        b1 += other.b1;
+        b2 += other.b2;
+        c += other.c;
+        weight += other.weight;
+        return *this;
+    }
+
+    // weighted mean of the squared distances to the accumulated planes
+    [[nodiscard]] double error(const glm::vec3 &point) const {
+        const double x = point.x;
+        const double y = point.y;
+        const double z = point.z;
+
+        const double squared = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+                               2.0 * (b0 * x + b1 * y + b2 * z) + c;
+        return weight > 0.0 ? std::abs(squared) / weight : 0.0;
+    }
+};
+
+struct PositionHash {
+    size_t operator()(const glm::vec3 &position) const noexcept {
+        std::array<uint32_t, 3> words{};
+        std::memcpy(words.data(), &position, sizeof(words));
+
+        uint64_t hash = 14695981039346656037ULL;
+        for (const uint32_t word : words) {
+            hash ^= word;
+            hash *= 1099511628211ULL;
+        }
+        return static_cast<size_t>(hash);
+    }
+};
+
+struct PositionEqual {
+    bool operator()(const glm::vec3 &a, const glm::vec3 &b) const noexcept {
+        return std::memcmp(&a, &b, sizeof(glm::vec3)) == 0;
+    }
+};
+
+// Compressed adjacency list, the entries of vertex v are entries[offsets[v]] to entries[offsets[v + 1]]
+struct Adjacency {
+    std::vector<unsigned int> offsets;
+    std::vector<unsigned int> entries;
+
+    [[nodiscard]] std::span<const unsigned int> of(unsigned int vertex) const {
+        return std::span(entries).subspan(offsets[vertex], offsets[vertex + 1] - offsets[vertex]);
+    }
+};
+
+// Half-edges a -> b of every triangle, stored at a
+Adjacency buildEdges(std::span<const unsigned int> indices, size_t vertexCount) {
+    Adjacency edges;
+    edges.offsets.assign(vertexCount + 1, 0);
+    edges.entries.resize(indices.size());
+
+    for (const unsigned int index : indices) {
+        edges.offsets[index + 1]++;
+    }
+    std::partial_sum(edges.offsets.begin(), edges.offsets.end(), edges.offsets.begin());
+
+    std::vector<unsigned int> fill(edges.offsets.begin(), edges.offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        for (size_t k = 0; k < 3; k++) {
+            const unsigned int from = indices[i + k];
+            edges.entries[fill[from]++] = indices[i + (k + 1) % 3];
+        }
+    }
+
+    return edges;
+}
+
+// Triangles touching each vertex
+Adjacency buildTriangles(std::span<const unsigned int> indices, size_t vertexCount) {
+    Adjacency triangles;
+    triangles.offsets.assign(vertexCount + 1, 0);
+    triangles.entries.resize(indices.size());
+
+    for (const unsigned int index : indices) {
+        triangles.offsets[index + 1]++;
+    }
+    std::partial_sum(triangles.offsets.begin(), triangles.offsets.end(), triangles.offsets.begin());
+
+    std::vector<unsigned int> fill(triangles.offsets.begin(), triangles.offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); i++) {
+        triangles.entries[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+    }
+
+    return triangles;
+}
+
+bool hasEdge(const Adjacency &edges, unsigned int from, unsigned int to) {
+    return std::ranges::find(edges.of(from), to) != edges.of(from).end();
+}
+
+bool isOpenEdge(const Adjacency &edges, unsigned int a, unsigned int b) {
+    return hasEdge(edges, a, b) != hasEdge(edges, b, a);
+}
+
+struct Collapse {
+    unsigned int from;
+    unsigned int to;
+    double       cost;
+};
+
+class Simplifier {
+    public:
+    Simplifier(std::span<const unsigned int> indices, std::span<const Mesh::Vertex> vertices)
+            : m_indices(indices.begin(), indices.end()),
+              m_positions(vertices.size()),
+              m_wedges(vertices.size()),
+              m_nextWedge(vertices.size()),
+              m_kinds(vertices.size(), VertexKind::LOCKED),
+              m_quadrics(vertices.size()),
+              m_remap(vertices.size()),
+              m_locked(vertices.size(), 0) {
+        normalizePositions(vertices);
+        buildWedges();
+
+        const Adjacency edges = buildEdges(m_indices, m_positions.size());
+        classifyVertices(edges);
+        accumulateQuadrics(edges);
+
+        std::iota(m_remap.begin(), m_remap.end(), 0U);
+    }
+
+    std::vector<unsigned int> run(size_t targetIndexCount, float targetError, float &error) {
+        const double errorLimit = static_cast<double>(targetError) * static_cast<double>(targetError);
+
+        for (size_t pass = 0; pass < MAX_PASSES && m_indices.size() > targetIndexCount; pass++) {
+            if (collapsePass(targetIndexCount, errorLimit) == 0) {
+                break;
+            }
+            compactIndices();
+        }
+
+        error = static_cast<float>(std::sqrt(m_maxError));
+        return std::move(m_indices);
+    }
+
+    private:
+    std::vector<unsigned int> m_indices;
+    std::vector<glm::vec3>    m_positions; // centered on the bounds and scaled to a unit bounding radius
+
+    // vertices sharing a position form a ring, m_wedges holds the first vertex of it
+    std::vector<unsigned int> m_wedges;
+    std::vector<unsigned int> m_nextWedge;
+
+    std::vector<VertexKind> m_kinds;
+    std::vector<Quadric>    m_quadrics; // by wedge
+    std::vector<unsigned int> m_remap;
+    std::vector<uint8_t>      m_locked; // by wedge, reset every pass
+
+    double m_maxError = 0.0;
+
+    void normalizePositions(std::span<const Mesh::Vertex> vertices) {
+        if (vertices.empty()) {
+            return;
+        }
+
+        glm::vec3 min = vertices.front().Position;
+        glm::vec3 max = vertices.front().Position;
+        for (const auto &vertex : vertices) {
+            min = glm::min(min, vertex.Position);
+            max = glm::max(max, vertex.Position);
+        }
+
+        const glm::vec3 center = (min + max) * 0.5f;
+
+        float radius = 0.0f;
+        for (const auto &vertex : vertices) {
+            radius = std::max(radius, glm::length(vertex.Position - center));
+        }
+
+        const float scale = radius > 0.0f ? 1.0f / radius : 1.0f;
+        for (size_t i = 0; i < vertices.size(); i++) {
+            m_positions[i] = (vertices[i].Position - center) * scale;
+        }
+    }
+
+    void buildWedges() {
+        std::unordered_map<glm::vec3, unsigned int, PositionHash, PositionEqual> first;
+        first.reserve(m_positions.size());
+
+        for (unsigned int i = 0; i < m_positions.size(); i++) {
+            const auto [iterator, inserted] = first.try_emplace(m_positions[i], i);
+            const unsigned int wedge        = iterator->second;
+
+            m_wedges[i] = wedge;
+            if (inserted) {
+                m_nextWedge[i] = i;
+            } else {
+                m_nextWedge[i]     = m_nextWedge[wedge];
+                m_nextWedge[wedge] = i;
+            }
+        }
+    }
+
+    // true if some vertex at the position of b has an edge to some vertex at the position of a
+    [[nodiscard]] bool hasPositionEdge(const Adjacency &edges, unsigned int a, unsigned int b) const {
+        unsigned int vertex = a;
+        do {
+            for (const unsigned int target : edges.of(vertex)) {
+                if (m_wedges[target] == m_wedges[b]) {
+                    return true;
+                }
+            }
+            vertex = m_nextWedge[vertex];
+        } while (vertex != a);
+
+        return false;
+    }
+
+    void classifyVertices(const Adjacency &edges) {
+        const size_t vertexCount = m_positions.size();
+
+        // the single open edge leaving and entering every vertex, MULTIPLE when there is more than one
+        std::vector<unsigned int> openOut(vertexCount, NO_VERTEX);
+        std::vector<unsigned int> openIn(vertexCount, NO_VERTEX);
+
+        for (unsigned int from = 0; from < vertexCount; from++) {
+            for (const unsigned int to : edges.of(from)) {
+                if (!hasEdge(edges, to, from)) {
+                    openOut[from] = openOut[from] == NO_VERTEX ? to : MULTIPLE;
+                    openIn[to]    = openIn[to] == NO_VERTEX ? from : MULTIPLE;
+                }
+            }
+        }
+
+        auto single = [](unsigned int vertex) { return vertex != NO_VERTEX && vertex != MULTIPLE; };
+
+        for (unsigned int vertex = 0; vertex < vertexCount; vertex++) {
+            const unsigned int twin = m_nextWedge[vertex];
+
+            if (twin == vertex) {
+                if (openOut[vertex] == NO_VERTEX && openIn[vertex] == NO_VERTEX) {
+                    m_kinds[vertex] = VertexKind::MANIFOLD;
+                } else if (single(openOut[vertex]) && single(openIn[vertex]) &&
+                           !hasPositionEdge(edges, openOut[vertex], vertex) &&
+                           !hasPositionEdge(edges, vertex, openIn[vertex])) {
+                    m_kinds[vertex] = VertexKind::BORDER;
+                }
+            } else if (m_nextWedge[twin] == vertex) {
+                // both sides of the seam have to run along the same positions
+                if (single(openOut[vertex]) && single(openIn[vertex]) && single(openOut[twin]) &&
+                    single(openIn[twin]) && m_wedges[openOut[vertex]] == m_wedges[openIn[twin]] &&
+                    m_wedges[openIn[vertex]] == m_wedges[openOut[twin]]) {
+                    m_kinds[vertex] = VertexKind::SEAM;
+                }
+            }
+        }
+    }
+
+    void accumulateQuadrics(const Adjacency &edges) {
+        for (size_t i = 0; i < m_indices.size(); i += 3) {
+            const std::array<unsigned int, 3> corners{m_indices[i], m_indices[i + 1], m_indices[i + 2]};
+
+            const glm::vec3 &p0    = m_positions[corners[0]];
+            glm::vec3        cross = glm::cross(m_positions[corners[1]] - p0, m_positions[corners[2]] - p0);
+            const float      twiceArea = glm::length(cross);
+            if (twiceArea == 0.0f) {
+                continue;
+            }
+
+            const glm::vec3 normal = cross / twiceArea;
+            const Quadric   plane  = Quadric::fromPlane(normal, -glm::dot(normal, p0), twiceArea * 0.5);
+            for (const unsigned int corner : corners) {
+                m_quadrics[m_wedges[corner]] += plane;
+            }
+
+            // keep open edges in place with a plane standing on the edge
+            for (size_t k = 0; k < 3; k++) {
+                const unsigned int a = corners[k];
+                const unsigned int b = corners[(k + 1) % 3];
+                if (hasEdge(edges, b, a)) {
+                    continue;
+                }
+
+                const glm::vec3 edge   = m_positions[b] - m_positions[a];
+                const float     length = glm::length(edge);
+                if (length == 0.0f) {
+                    continue;
+                }
+
+                const glm::vec3 side = glm::normalize(glm::cross(edge, normal));
+                const Quadric   wall = Quadric::fromPlane(
+                        side, -glm::dot(side, m_positions[a]), static_cast<double>(length * length) * BORDER_WEIGHT);
+                m_quadrics[m_wedges[a]] += wall;
+                m_quadrics[m_wedges[b]] += wall;
+            }
+        }
+    }
+
+    [[nodiscard]] unsigned int resolve(unsigned int vertex) {
+        while (m_remap[vertex] != vertex) {
+            m_remap[vertex] = m_remap[m_remap[vertex]];
+            vertex          = m_remap[vertex];
+        }
+        return vertex;
+    }
+
+    [[nodiscard]] bool canCollapse(const Adjacency &edges, unsigned int from, unsigned int to) const {
+        if (m_wedges[from] == m_wedges[to]) {
+            return false;
+        }
+
+        switch (m_kinds[from]) {
+        case VertexKind::MANIFOLD:
+            return true;
+        case VertexKind::BORDER:
+        case VertexKind::SEAM:
+            return isOpenEdge(edges, from, to);
+        case VertexKind::LOCKED:
+            return false;
+        }
+        return false;
+    }
+
+    // The vertex at the position of to that the twin of a seam vertex collapses into
+    [[nodiscard]] unsigned int findTwinTarget(const Adjacency &edges, unsigned int twin, unsigned int to) const {
+        unsigned int candidate = to;
+        do {
+            if (candidate != to && isOpenEdge(edges, twin, candidate)) {
+                return candidate;
+            }
+            candidate = m_nextWedge[candidate];
+        } while (candidate != to);
+
+        return NO_VERTEX;
+    }
+
+    // True if moving from onto to turns any of its remaining triangles over
+    [[nodiscard]] bool flipsTriangles(const Adjacency &triangles, unsigned int from, unsigned int to) {
+        for (const unsigned int triangle : triangles.of(from)) {
+            std::array<unsigned int, 3> corners{};
+            bool                        collapses = false;
+
+            for (size_t k = 0; k < 3; k++) {
+                corners.at(k) = resolve(m_indices[triangle * 3 + k]);
+                collapses     = collapses || m_wedges[corners.at(k)] == m_wedges[to];
+            }
+
+            // triangles along the collapsed edge disappear
+            if (collapses) {
+                continue;
+            }
+
+            const glm::vec3 &p0 = m_positions[corners[0]];
+            const glm::vec3 &p1 = m_positions[corners[1]];
+            const glm::vec3 &p2 = m_positions[corners[2]];
+            const glm::vec3  before = glm::cross(p1 - p0, p2 - p0);
+
+            std::array<glm::vec3, 3> moved{p0, p1, p2};
+            for (size_t k = 0; k < 3; k++) {
+                if (corners.at(k) == from) {
+                    moved.at(k) = m_positions[to];
+                }
+            }
+            const glm::vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+
+            if (glm::dot(before, after) <= 0.0f) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    size_t collapsePass(size_t targetIndexCount, double errorLimit) {
+        const Adjacency edges     = buildEdges(m_indices, m_positions.size());
+        const Adjacency triangles = buildTriangles(m_indices, m_positions.size());
+
+        std::vector<Collapse> collapses;
+        collapses.reserve(m_indices.size());
+
+        for (size_t i = 0; i < m_indices.size(); i++) {
+            const unsigned int a = m_indices[i];
+            const unsigned int b = m_indices[i - i % 3 + (i + 1) % 3];
+
+            const double costAB = canCollapse(edges, a, b) ? m_quadrics[m_wedges[a]].error(m_positions[b])
+                                                           : std::numeric_limits<double>::max();
+            const double costBA = canCollapse(edges, b, a) ? m_quadrics[m_wedges[b]].error(m_positions[a])
+                                                           : std::numeric_limits<double>::max();
+
+            if (costAB <= costBA && costAB <= errorLimit) {
+                collapses.push_back({a, b, costAB});
+            } else if (costBA < costAB && costBA <= errorLimit) {
+                collapses.push_back({b, a, costBA});
+            }
+        }
+
+        std::ranges::sort(collapses, {}, &Collapse::cost);
+
+        // a manifold collapse removes two triangles, leave room for the later passes to pick the cheapest ones again
+        const size_t excessTriangles = (m_indices.size() - targetIndexCount) / 3;
+        const size_t budget          = std::max<size_t>(1, (excessTriangles + 1) / 2);
+
+        std::ranges::fill(m_locked, 0);
+        size_t applied = 0;
+
+        for (const auto &collapse : collapses) {
+            if (applied >= budget) {
+                break;
+            }
+
+            const unsigned int from = collapse.from;
+            const unsigned int to   = collapse.to;
+            if (m_locked[m_wedges[from]] != 0 || m_locked[m_wedges[to]] != 0) {
+                continue;
+            }
+
+            unsigned int twin       = NO_VERTEX;
+            unsigned int twinTarget = NO_VERTEX;
+            if (m_kinds[from] == VertexKind::SEAM) {
+                twin       = m_nextWedge[from];
+                twinTarget = findTwinTarget(edges, twin, to);
+                if (twinTarget == NO_VERTEX) {
+                    continue;
+                }
+            }
+
+            if (flipsTriangles(triangles, from, to) || (twin != NO_VERTEX && flipsTriangles(triangles, twin, twinTarget))) {
+                continue;
+            }
+
+            m_remap[from] = to;
+            if (twin != NO_VERTEX) {
+                m_remap[twin] = twinTarget;
+            }
+
+            m_quadrics[m_wedges[to]] += m_quadrics[m_wedges[from]];
+            m_locked[m_wedges[from]] = 1;
+            m_locked[m_wedges[to]]   = 1;
+
+            m_maxError = std::max(m_maxError, collapse.cost);
+            applied++;
+        }
+
+        return applied;
+    }
+
+    // Applies the collapses and drops the triangles that lost their area
+    void compactIndices() {
+        size_t kept = 0;
+        for (size_t i = 0; i < m_indices.size(); i += 3) {
+            const unsigned int a = resolve(m_indices[i]);
+            const unsigned int b = resolve(m_indices[i + 1]);
+            const unsigned int c = resolve(m_indices[i + 2]);
+
+            if (m_wedges[a] == m_wedges[b] || m_wedges[b] == m_wedges[c] || m_wedges[c] == m_wedges[a]) {
+                continue;
+            }
+
+            m_indices[kept++] = a;
+            m_indices[kept++] = b;
+            m_indices[kept++] = c;
+        }
+        m_indices.resize(kept);
+    }
+};
+
+} // namespace
+
+std::vector<unsigned int> MeshSimplifier::simplify(std::span<const unsigned int>  indices,
+                                                   std::span<const Mesh::Vertex> vertices,
+                                                   size_t                        targetIndexCount,
+                                                   float                         targetError,
+                                                   float                        &error) {
+    error = 0.0f;
+    if (indices.size() <= targetIndexCount) {
+        return {indices.begin(), indices.end()};
+    }
+
+    Simplifier simplifier(indices, vertices);
+    return simplifier.run(targetIndexCount, targetError, error);
+}
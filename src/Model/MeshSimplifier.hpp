@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "Mesh.hpp"
+
+// Quadric error edge collapse simplification (Garland and Heckbert) for the level of detail chain.
+//
+// Collapses are half-edge collapses, a vertex is merged into one of its neighbours and never moved, so every level
+// indexes the vertex buffer of the full mesh. Vertices on open borders only slide along the border and vertices on
+// attribute seams collapse together with their twin on the other side of the seam, everything else touching a border
+// or a seam stays where it is.
+namespace MeshSimplifier {
+// Simplifies until the index list is down to targetIndexCount or the next collapse would move the surface further
+// than targetError. Errors are relative to the bounding radius of the vertices, the error of the result is returned
+// through error.
+[[nodiscard]] std::vector<unsigned int> simplify(std::span<const unsigned int>  indices,
+                                                 std::span<const Mesh::Vertex> vertices,
+                                                 size_t                        targetIndexCount,
+                                                 float                         targetError,
+                                                 float                        &error);
+} // namespace MeshSimplifier
@@ -2,11 +2,15 @@
 #include "assimp/material.h"
 #include "glad/glad.h"
 
+#include <algorithm>
+#include <chrono>
 #include <filesystem>
 #include <stdexcept>
 #include <string>
 #include <format>
+#include <optional>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <assimp/Importer.hpp>
@@ -15,48 +19,280 @@
 
 #include <iostream>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb/stb_image.h>
-
+#include <Utility/JobSystem.hpp>
+#include <Utility/Profiler.hpp>
+#include <Utility/ThreadPool.hpp>
 #include <Utility/fs_helpers.hpp>
 #include "Mesh.hpp"
+#include "CompressedImage.hpp"
+#include "Image.hpp"
+#include "MeshCache.hpp"
+#include "MeshOptimizer.hpp"
+#include "Quantization.hpp"
+#include "ResourceIOSystem.hpp"
 #include "Texture.hpp"
+#include "TextureCompression.hpp"
+
+namespace {
+
+constexpr double MEBIBYTE = 1024.0 * 1024.0;
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// aiMatrix4x4 is row major, a1..a4 is the first row
+glm::mat4 toMat4(const aiMatrix4x4 &matrix) {
+    return {glm::vec4(matrix.a1, matrix.b1, matrix.c1, matrix.d1),
+            glm::vec4(matrix.a2, matrix.b2, matrix.c2, matrix.d2),
+            glm::vec4(matrix.a3, matrix.b3, matrix.c3, matrix.d3),
+            glm::vec4(matrix.a4, matrix.b4, matrix.c4, matrix.d4)};
+}
+
+} // namespace
+
+Model::Data Model::import(const std::string &modelName, Mesh::VertexFormat format) {
+    PROFILE_ZONE("Model::import");
+    using clock = std::chrono::steady_clock;
+
+    const std::filesystem::path path = fs_helpers::getPathToModel(modelName);
+
+    Data data;
+    data.name = modelName;
+
+    auto phaseStart = clock::now();
+
+    // the records are only validated when they are read, a corrupted one falls back to Assimp like a stale cache
+    try {
+        data.cache = MeshCache::open(path, IMPORT_FLAGS, format);
+        if (data.cache.has_value()) {
+            for (size_t i = 0; i < data.cache->meshCount(); i++) {
+                data.meshes.push_back(data.cache->mesh(i));
+            }
+            data.nodes = data.cache->nodes();
+        }
+    } catch (const std::runtime_error &error) {
+        std::cerr << "Model::import | Ignoring mesh cache for " << modelName << ": " << error.what() << std::endl;
+
+        // the meshes read so far point into the cache mapping
+        data.meshes.clear();
+        data.nodes.clear();
+        data.cache.reset();
+    }
+
+    if (data.cache.has_value()) {
+        data.timings.import = millisecondsSince(phaseStart);
+    } else {
+        // the importer reads the model and the files it references through the resource archive, it owns the handler
+        Assimp::Importer  importer;
+        ResourceIOSystem *ioSystem = new ResourceIOSystem(); // NOLINT(cppcoreguidelines-owning-memory)
+        importer.SetIOHandler(ioSystem);
+        const aiScene *scene = importer.ReadFile(path.string(), IMPORT_FLAGS);
+
+        if (scene == nullptr || ((scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) != 0u) || (scene->mRootNode) == nullptr) {
+            throw std::runtime_error(std::format("Assimp::Importer::ReadFile | {}", importer.GetErrorString()));
+        }
+
+        data.timings.import = millisecondsSince(phaseStart);
+        phaseStart          = clock::now();
+
+        // the traversal only collects the nodes and meshes, converting them into their slot keeps the order
+        // deterministic
+        std::vector<aiMesh *> nodeMeshes;
+        processNode(scene->mRootNode, scene, MeshCache::NO_PARENT, data.nodes, nodeMeshes);
+
+        data.imported.resize(nodeMeshes.size());
+        std::vector<MeshOptimizer::Report> reports(nodeMeshes.size());
+
+        ThreadPool::shared().parallelFor(nodeMeshes.size(), [&](size_t i) {
+            PROFILE_ZONE("Model::convertMesh");
+            data.imported[i] = processMesh(nodeMeshes[i], scene);
+            reports[i]       = MeshOptimizer::optimize(data.imported[i]);
+            Quantization::encode(data.imported[i], format);
+        });
+
+        MeshOptimizer::Stats before;
+        MeshOptimizer::Stats after;
+        for (const auto &report : reports) {
+            before += report.before;
+            after += report.after;
+        }
+
+        std::cout << std::format("Model | {} | optimized | {} -> {} vertices | {} -> {} index bytes | "
+                                 "ACMR {:.3f} -> {:.3f} | LOD triangles {} / {} / {} / {}",
+                                 modelName,
+                                 before.vertices,
+                                 after.vertices,
+                                 before.indexBytes,
+                                 after.indexBytes,
+                                 before.acmr(),
+                                 after.acmr(),
+                                 after.lodTriangles[0],
+                                 after.lodTriangles[1],
+                                 after.lodTriangles[2],
+                                 after.lodTriangles[3])
+                  << std::endl;
+
+        for (const auto &mesh : data.imported) {
+            data.meshes.push_back(mesh.view());
+        }
+
+        if (format != Mesh::FLOAT32) {
+            std::string report;
+            for (size_t i = 0; i < data.imported.size(); i++) {
+                const Mesh::Data &mesh   = data.imported[i];
+                const float       extent = glm::length(mesh.boundsMax - mesh.boundsMin);
+
+                report += std::format("Model | {} | mesh {} | {} vertices, {} B/vertex | max position error {:.6f} "
+                                      "({:.5f}% of the bounds) | max normal error {:.4f} deg\n",
+                                      modelName,
+                                      i,
+                                      mesh.vertices.size(),
+                                      Mesh::vertexSize(format),
+                                      mesh.maxPositionError,
+                                      extent > 0.0f ? mesh.maxPositionError / extent * 100.0f : 0.0f,
+                                      mesh.maxNormalError);
+            }
+            std::cout << report << std::flush;
+        }
 
-void Model::loadModel(const std::string &modelName) {
-    std::filesystem::path path = fs_helpers::getPathToModel(modelName);
+        try {
+            MeshCache::write(path, ioSystem->getOpenedFiles(), IMPORT_FLAGS, format, data.imported, data.nodes);
+        } catch (const std::exception &error) {
+            std::cerr << "Model::import | Failed to write mesh cache: " << error.what() << std::endl;
+        }
 
-    directory = path.parent_path();
+        data.timings.convert = millisecondsSince(phaseStart);
+    }
 
-    Assimp::Importer importer;
-    const aiScene   *scene = importer.ReadFile(path.string(), aiProcess_Triangulate | aiProcess_FlipUVs);
+    phaseStart = clock::now();
+    decodeTextures(data, path.parent_path());
+    data.timings.decode = millisecondsSince(phaseStart);
 
-    if (scene == nullptr || ((scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) != 0u) || (scene->mRootNode) == nullptr) {
-        throw std::runtime_error(std::format("Assimp::Importer::ReadFile | {}", importer.GetErrorString()));
+    return data;
+}
+
+Model::Model(Data data, TextureUploadQueue *textureQueue, uint32_t retention) : name(data.name) {
+    PROFILE_ZONE("Model::upload");
+    const auto start = std::chrono::steady_clock::now();
+
+    // the compressed images are handed to the GL or the queue below, report them while they are still around
+    std::string textureReport;
+    size_t      uncompressedBytes = 0;
+    size_t      compressedBytes   = 0;
+    for (const auto &[path, image] : data.compressedImages) {
+        uncompressedBytes += image.uncompressedSize();
+        compressedBytes += image.size();
+        textureReport += std::format("\nTexture | {} | {}x{} {}, {} levels | VRAM {:.2f} MiB -> {:.2f} MiB | "
+                                     "{} {:.2f} ms",
+                                     std::filesystem::path(path).filename().string(),
+                                     image.width(),
+                                     image.height(),
+                                     TextureCompression::formatName(image.internalFormat),
+                                     image.levels.size(),
+                                     static_cast<double>(image.uncompressedSize()) / MEBIBYTE,
+                                     static_cast<double>(image.size()) / MEBIBYTE,
+                                     image.cached ? "cached" : "transcoded",
+                                     image.milliseconds);
+    }
+    if (!data.compressedImages.empty()) {
+        textureReport += std::format("\nTextures | {} | VRAM {:.2f} MiB -> {:.2f} MiB",
+                                     data.name,
+                                     static_cast<double>(uncompressedBytes) / MEBIBYTE,
+                                     static_cast<double>(compressedBytes) / MEBIBYTE);
     }
 
-    processNode(scene->mRootNode, scene);
+    meshes.reserve(data.meshes.size());
+    for (const auto &view : data.meshes) {
+        meshes.emplace_back(view, createMaterial(view, data, textureQueue), retention);
+    }
+    nodes = std::move(data.nodes);
+
+    // the nodes are in preorder, every parent is resolved before its children
+    modelSpace.reserve(nodes.size());
+    for (const auto &node : nodes) {
+        modelSpace.push_back(node.parent == MeshCache::NO_PARENT ? node.transform
+                                                                 : modelSpace.at(node.parent) * node.transform);
+    }
+
+    data.timings.upload = millisecondsSince(start);
+
+    const LoadTimings &timings = data.timings;
+    std::cout << std::format("Model | {} | {} | {} meshes, {} B/vertex, {} textures{} | import {:.2f} ms | "
+                             "convert {:.2f} ms | decode {:.2f} ms | upload {:.2f} ms",
+                             data.name,
+                             data.cache.has_value() ? "warm (cache)" : "cold (assimp)",
+                             meshes.size(),
+                             data.meshes.empty() ? sizeof(Mesh::Vertex) : Mesh::vertexSize(data.meshes.front().format),
+                             data.images.size() + data.compressedImages.size(),
+                             textureQueue != nullptr ? " (streaming)" : "",
+                             timings.import,
+                             timings.convert,
+                             timings.decode,
+                             timings.upload)
+              << textureReport << std::endl;
+}
+
+MemoryUsage Model::getMemoryUsage() const {
+    MemoryUsage usage;
+    usage.cpuBytes = meshes.capacity() * sizeof(Mesh) + nodes.capacity() * sizeof(Node) +
+                     sceneNodes.capacity() * sizeof(SceneGraph::NodeId) + modelSpace.capacity() * sizeof(glm::mat4) +
+                     lodLevels.capacity() + instanceLodLevels.capacity();
+    for (const auto &chunk : instanceChunks) {
+        usage.cpuBytes += chunk.textureRadii.capacity() * sizeof(float) +
+                          chunk.occluders.capacity() * sizeof(std::pair<uint32_t, glm::mat4>);
+    }
+
+    std::unordered_set<GLuint> textures;
+    for (const auto &mesh : meshes) {
+        usage += mesh.getMemoryUsage();
+
+        const Material &material = MaterialLibrary::shared()[mesh.getMaterialId()];
+        textures.insert({material.diffuse, material.specular, material.roughness});
+    }
+
+    // the fallbacks of missing maps aren't known to the manager and are left out
+    for (const GLuint texture : textures) {
+        if (auto bytes = TextureManager::shared().getResidentBytes(texture)) {
+            usage.textureBytes += *bytes;
+            usage.glObjects++;
+        }
+    }
+    return usage;
 }
 
 // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-void Model::processNode(aiNode *node, const aiScene *scene) {
-    // process all the node's meshes (if any)
+void Model::processNode(aiNode                *node,
+                        const aiScene         *scene,
+                        uint32_t               parent,
+                        std::vector<Node>     &nodes,
+                        std::vector<aiMesh *> &nodeMeshes) {
+    const auto index = static_cast<uint32_t>(nodes.size());
+    nodes.push_back({parent,
+                     static_cast<uint32_t>(nodeMeshes.size()),
+                     node->mNumMeshes,
+                     toMat4(node->mTransformation)});
+
+    // collect all the node's meshes (if any)
     for (size_t i = 0; i < node->mNumMeshes; i++) {
-        aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
-        meshes.push_back(processMesh(mesh, scene));
+        nodeMeshes.push_back(scene->mMeshes[node->mMeshes[i]]);
     }
 
     // then do the same for each of its children
     for (size_t i = 0; i < node->mNumChildren; i++) {
-        processNode(node->mChildren[i], scene);
+        processNode(node->mChildren[i], scene, index, nodes, nodeMeshes);
     }
 }
 // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
 
-Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene) {
+Mesh::Data Model::processMesh(aiMesh *mesh, const aiScene *scene) {
     std::vector<Mesh::Vertex>  vertices;
     std::vector<unsigned int>  indices;
     std::vector<Mesh::Texture> textures;
 
+    vertices.reserve(mesh->mNumVertices);
+    indices.reserve(static_cast<size_t>(mesh->mNumFaces) * 3);
+
     // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
     for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
         Mesh::Vertex vertex{};
@@ -94,21 +330,39 @@ Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene) {
     float defaultShiniess = 32.0f;
     float shininess       = material->Get(AI_MATKEY_SHININESS, shininess) == AI_SUCCESS ? shininess : defaultShiniess;
 
-    return {vertices, indices, textures, shininess};
+    Mesh::Data data{};
+    data.vertices  = std::move(vertices);
+    data.indices   = std::move(indices);
+    data.textures  = std::move(textures);
+    data.shininess = shininess;
+
+    if (!data.vertices.empty()) {
+        data.boundsMin = data.boundsMax = data.vertices.front().Position;
+        for (const auto &vertex : data.vertices) {
+            data.boundsMin = glm::min(data.boundsMin, vertex.Position);
+            data.boundsMax = glm::max(data.boundsMax, vertex.Position);
+        }
+
+        // the sphere shares the box center, its radius reaches the farthest vertex
+        const glm::vec3 center = (data.boundsMin + data.boundsMax) * 0.5f;
+        for (const auto &vertex : data.vertices) {
+            data.boundingRadius = std::max(data.boundingRadius, glm::distance(center, vertex.Position));
+        }
+    }
+
+    return data;
 };
 
 std::vector<Mesh::Texture> Model::loadMaterialTextures(aiMaterial        *mat,
                                                        aiTextureType      type,
                                                        const std::string &typeName) {
     std::vector<Mesh::Texture> textures;
-    std::cout << "loadMaterialTextures | " << typeName << std::endl;
-    std::cout << "loadMaterialTextures | " << mat->GetTextureCount(type) << std::endl;
     for (unsigned int i = 0; i < mat->GetTextureCount(type); i++) {
         aiString texturePath;
         mat->GetTexture(type, i, &texturePath);
 
+        // the id is resolved once the mesh is uploaded, see Model::getTextureId
         Mesh::Texture texture{};
-        texture.id   = getTextureId(texturePath.C_Str());
         texture.type = typeName;
         texture.path = texturePath.C_Str();
 
@@ -117,38 +371,91 @@ std::vector<Mesh::Texture> Model::loadMaterialTextures(aiMaterial        *mat,
     return textures;
 }
 
-GLuint Model::getTextureId(const std::string &texturePath) {
-    static std::unordered_map<std::string, GLuint> loadedTextures{};
+void Model::decodeTextures(Data &data, const std::filesystem::path &directory) {
+    PROFILE_ZONE("Model::decodeTextures");
+    const bool compress = CompressedImage::isSupported();
+
+    std::vector<std::string> paths;
+    std::vector<bool>        colors; // parallel to paths, diffuse maps hold sRGB colours, the other maps data
+
+    for (auto &view : data.meshes) {
+        for (auto &texture : view.textures) {
+            if (!fs_helpers::isAbsolutePath(texture.path)) {
+                texture.path = (directory / texture.path).string();
+            }
+            if (data.images.contains(texture.path) || data.compressedImages.contains(texture.path)) {
+                continue;
+            }
+
+            if (compress) {
+                data.compressedImages.emplace(texture.path, CompressedImage{});
+            } else {
+                data.images.emplace(texture.path, Image{});
+            }
+            paths.push_back(texture.path);
+            colors.push_back(texture.type == ::Texture::DIFFUSE);
+        }
+    }
+
+    // the maps aren't modified from here on, each worker only writes to its own image
+    ThreadPool::shared().parallelFor(paths.size(), [&](size_t i) {
+        if (compress) {
+            PROFILE_ZONE("CompressedImage::load");
+            data.compressedImages.at(paths[i]) = CompressedImage::load(paths[i], colors[i]);
+        } else {
+            PROFILE_ZONE("Image::load");
+            data.images.at(paths[i]) = Image::load(paths[i]);
+        }
+    });
+}
 
-    std::string path = fs_helpers::isAbsolutePath(texturePath) ? texturePath : (directory / texturePath).string();
+uint32_t Model::createMaterial(const Mesh::View &view, Data &data, TextureUploadQueue *textureQueue) {
+    Material material{};
+    material.shininess = view.shininess;
 
-    auto iterator = loadedTextures.find(path);
+    // the shader has one slot per map type, only the first map of each type is used
+    for (const auto &texture : view.textures) {
+        GLuint *slot = texture.type == ::Texture::DIFFUSE     ? &material.diffuse
+                       : texture.type == ::Texture::SPECULAR  ? &material.specular
+                       : texture.type == ::Texture::ROUGHNESS ? &material.roughness
+                                                              : nullptr;
 
-    if (iterator != loadedTextures.end()) {
-        return iterator->second;
+        if (slot != nullptr && *slot == 0) {
+            *slot = getTextureId(texture.path, data, textureQueue);
+        }
     }
 
-    int widthTex      = 0;
-    int heightTex     = 0;
-    int nrChannelsTex = 0;
+    return MaterialLibrary::shared().add(material);
+}
 
-    stbi_set_flip_vertically_on_load(GL_TRUE);
-    unsigned char *dataTexture = stbi_load(path.c_str(), &widthTex, &heightTex, &nrChannelsTex, 0);
+GLuint Model::getTextureId(const std::string &path, Data &data, TextureUploadQueue *textureQueue) {
+    TextureManager &textures = TextureManager::shared();
 
-    if (dataTexture == nullptr) {
-        throw std::runtime_error(std::format("stbi_load | {} | {}", stbi_failure_reason(), path.c_str()));
+    if (const GLuint loaded = textures.find(path); loaded != 0) {
+        return loaded;
     }
 
-    GLenum format = 0;
+    auto compressed = data.compressedImages.find(path);
+    if (compressed != data.compressedImages.end()) {
+        return textures.add(path, std::move(compressed->second));
+    }
+
+    Image &image = data.images.at(path);
+
+    // the driver pads RGB to RGBA, the generated levels add a third
+    const size_t channels = image.channels == 3 ? 4 : static_cast<size_t>(image.channels);
+    const size_t bytes    = static_cast<size_t>(image.width) * static_cast<size_t>(image.height) * channels * 4 / 3;
 
-    if (nrChannelsTex == 1) {
-        format = GL_RED;
-    } else if (nrChannelsTex == 3) {
-        format = GL_RGB;
-    } else if (nrChannelsTex == 4) {
-        format = GL_RGBA;
+    if (textureQueue != nullptr) {
+        const GLuint textureId = TextureUploadQueue::createPlaceholder();
+        textureQueue->push(textureId, std::move(image));
+
+        textures.addPinned(path, textureId, bytes);
+        return textureId;
     }
 
+    const GLenum format = image.format();
+
     GLuint textureId = 0;
 
     glGenTextures(1, &textureId);
@@ -160,18 +467,149 @@ GLuint Model::getTextureId(const std::string &texturePath) {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 
-    glTexImage2D(GL_TEXTURE_2D, 0, format, widthTex, heightTex, 0, format, GL_UNSIGNED_BYTE, dataTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.pixels.get());
     glGenerateMipmap(GL_TEXTURE_2D);
 
-    stbi_image_free(dataTexture);
-
-    loadedTextures[path] = textureId;
+    textures.addPinned(path, textureId, bytes);
     return textureId;
 }
 
-void Model::Draw(Shader &shader) {
-    shader.use();
-    for (auto &mesh : meshes) {
-        mesh.Draw(shader);
+void Model::requestTextures(const Mesh &mesh, float projectedRadius) {
+    const Material &material = MaterialLibrary::shared()[mesh.getMaterialId()];
+    TextureManager &textures = TextureManager::shared();
+
+    const float pixels = 2.0f * projectedRadius;
+    textures.request(material.diffuse, pixels);
+    textures.request(material.specular, pixels);
+    textures.request(material.roughness, pixels);
+}
+
+void Model::attach(SceneGraph &scene, SceneGraph::NodeId parent) {
+    sceneNodes.clear();
+    sceneNodes.reserve(nodes.size());
+
+    // the nodes are in preorder, so every parent is already in the scene
+    for (const auto &node : nodes) {
+        sceneNodes.push_back(
+                scene.add(node.parent == MeshCache::NO_PARENT ? parent : sceneNodes.at(node.parent), node.transform));
+    }
+}
+
+void Model::submit(RenderQueue      &queue,
+                   ShaderVariants   &shaders,
+                   const SceneGraph &scene,
+                   const Camera     &camera,
+                   OcclusionCuller  *occlusion) {
+    PROFILE_ZONE("Model::submit");
+    const glm::vec3 viewPos = camera.getPosition();
+    const Frustum   frustum = camera.getFrustum();
+
+    lodLevels.resize(meshes.size(), 0);
+
+    for (size_t i = 0; i < nodes.size(); i++) {
+        const glm::mat4 &world = scene.getWorld(sceneNodes.at(i));
+
+        for (uint32_t j = nodes[i].firstMesh; j < nodes[i].firstMesh + nodes[i].meshCount; j++) {
+            const Mesh          &mesh   = meshes.at(j);
+            const BoundingSphere bounds = mesh.getBoundingSphere().transformed(world);
+            const float          depth  = glm::distance(viewPos, bounds.center) / camera.getFar();
+            const float          radius = camera.getProjectedRadius(bounds);
+            const Shader        &shader = shaders.get(MaterialLibrary::shared()[mesh.getMaterialId()].features);
+
+            lodLevels[j] = static_cast<uint8_t>(mesh.selectLod(radius, lodLevels[j]));
+            queue.submit(shader, mesh, world, depth, bounds, lodLevels[j]);
+
+            if (frustum.intersects(bounds)) {
+                requestTextures(mesh, radius);
+
+                if (occlusion != nullptr && radius >= OcclusionCuller::MIN_OCCLUDER_PIXELS) {
+                    occlusion->addOccluder(mesh, world);
+                }
+            }
+        }
+    }
+}
+
+void Model::submitInstances(RenderQueue              &queue,
+                            ShaderVariants           &shaders,
+                            std::span<const Instance> instances,
+                            const Camera             &camera,
+                            OcclusionCuller          *occlusion) {
+    PROFILE_ZONE("Model::submitInstances");
+    const glm::vec3 viewPos = camera.getPosition();
+    const Frustum   frustum = camera.getFrustum();
+
+    // the levels are kept per instance and mesh, they start over when the number of instances changes since the old
+    // ones would belong to other slots
+    if (instanceLodLevels.size() != instances.size() * meshes.size()) {
+        instanceLodLevels.assign(instances.size() * meshes.size(), 0);
+    }
+
+    // the variants are looked up once per mesh, the textures requested once per mesh for its largest visible instance
+    std::vector<const Shader *> variants;
+    variants.reserve(meshes.size());
+    for (const auto &mesh : meshes) {
+        variants.push_back(&shaders.get(MaterialLibrary::shared()[mesh.getMaterialId()].features));
+        queue.registerDraw(*variants.back(), mesh);
     }
-}
\ No newline at end of file
+
+    // every instance fills one slot per mesh, the chunks of instances are spread over the JobSystem and collect what
+    // has to be done on this thread afterwards
+    const size_t firstSlot  = queue.allocate(instances.size() * meshes.size());
+    const size_t chunkCount = (instances.size() + INSTANCE_CHUNK - 1) / INSTANCE_CHUNK;
+    instanceChunks.resize(chunkCount);
+
+    JobSystem::shared().parallelFor(chunkCount, [&](size_t c) {
+        InstanceChunk &chunk = instanceChunks[c];
+        chunk.textureRadii.assign(meshes.size(), -1.0f);
+        chunk.occluders.clear();
+
+        const size_t end = std::min(instances.size(), (c + 1) * INSTANCE_CHUNK);
+        for (size_t k = c * INSTANCE_CHUNK; k < end; k++) {
+            const Instance &instance = instances[k];
+
+            for (size_t i = 0; i < nodes.size(); i++) {
+                const glm::mat4 world = instance.transform * modelSpace[i];
+
+                for (uint32_t j = nodes[i].firstMesh; j < nodes[i].firstMesh + nodes[i].meshCount; j++) {
+                    const Mesh          &mesh   = meshes.at(j);
+                    const BoundingSphere bounds = mesh.getBoundingSphere().transformed(world);
+                    const float          depth  = glm::distance(viewPos, bounds.center) / camera.getFar();
+                    const float          radius = camera.getProjectedRadius(bounds);
+                    const size_t         slot   = k * meshes.size() + j;
+
+                    uint8_t &lod = instanceLodLevels[slot];
+                    lod          = static_cast<uint8_t>(mesh.selectLod(radius, lod));
+                    queue.submitAt(firstSlot + slot, *variants[j], mesh, world, depth, bounds, lod, instance.tint);
+
+                    if (!frustum.intersects(bounds)) {
+                        continue;
+                    }
+                    chunk.textureRadii[j] = std::max(chunk.textureRadii[j], radius);
+
+                    if (occlusion != nullptr && radius >= OcclusionCuller::MIN_OCCLUDER_PIXELS) {
+                        chunk.occluders.emplace_back(j, world);
+                    }
+                }
+            }
+        }
+    });
+
+    std::vector<float> textureRadii(meshes.size(), -1.0f);
+    for (const auto &chunk : instanceChunks) {
+        for (size_t j = 0; j < meshes.size(); j++) {
+            textureRadii[j] = std::max(textureRadii[j], chunk.textureRadii[j]);
+        }
+        if (occlusion != nullptr) {
+            for (const auto &[j, world] : chunk.occluders) {
+                occlusion->addOccluder(meshes[j], world);
+            }
+        }
+    }
+
+    for (size_t j = 0; j < meshes.size(); j++) {
+        if (textureRadii[j] >= 0.0f) {
+            requestTextures(meshes[j], textureRadii[j]);
+        }
+    }
+}
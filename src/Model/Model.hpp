@@ -1,17 +1,75 @@
 #pragma once
 
 #include <assimp/scene.h>
+#include <assimp/postprocess.h>
 
+#include <optional>
+#include <span>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include <filesystem>
 
+#include "CompressedImage.hpp"
+#include "Image.hpp"
+#include "Material.hpp"
 #include "Mesh.hpp"
-#include <Shader.hpp>
+#include "MeshCache.hpp"
+#include "TextureManager.hpp"
+#include "TextureUploadQueue.hpp"
+#include <Camera.hpp>
+#include <Render/OcclusionCuller.hpp>
+#include <Render/RenderQueue.hpp>
+#include <Scene/SceneGraph.hpp>
+#include <ShaderVariants.hpp>
 
 class Model {
     public:
-    explicit Model(const std::string &modelName) { loadModel(modelName); }
+    using Node = MeshCache::Node;
+
+    // One copy of the model for submitInstances, transform places the model's root in the world
+    struct Instance {
+        glm::mat4 transform;
+        glm::vec4 tint{1.0f};
+    };
+
+    // Milliseconds spent in each load phase
+    struct LoadTimings {
+        double import  = 0.0; // Assimp import or mesh cache lookup
+        double convert = 0.0; // aiMesh to optimized and encoded Mesh::Data, runs on the thread pool
+        double decode  = 0.0; // stb_image decoding or KTX loading and transcoding, runs on the thread pool
+        double upload  = 0.0; // GL object creation, runs on the context thread
+    };
+
+    // Result of the CPU side of a load, it doesn't touch any GL state so it can be produced on any thread
+    struct Data {
+        std::string              name;
+        std::optional<MeshCache> cache;
+        std::vector<Mesh::Data>  imported;
+        std::vector<Mesh::View>  meshes; // in node traversal order, points into cache or imported
+        std::vector<Node>        nodes;  // the Assimp node hierarchy, in preorder
+
+        // decoded images by resolved path, block compressed ones when the driver supports it
+        std::unordered_map<std::string, Image>           images;
+        std::unordered_map<std::string, CompressedImage> compressedImages;
+
+        LoadTimings timings;
+    };
+
+    explicit Model(const std::string &modelName, Mesh::VertexFormat format = Mesh::FLOAT32)
+            : Model(import(modelName, format)) {}
+
+    // Uploads an imported model, must be called on the thread that owns the GL context. Compressed textures are handed
+    // to TextureManager::shared(), which streams their finer levels in once they are drawn. Uncompressed textures start
+    // out as placeholders when a texture queue is given and their pixels are streamed in by the queue. The imported
+    // geometry is freed with data once it is uploaded, retention is what every mesh keeps of it, see Mesh::Retention.
+    explicit Model(Data                data,
+                   TextureUploadQueue *textureQueue = nullptr,
+                   uint32_t            retention    = Mesh::RETAIN_OCCLUDER);
+
+    // Quantized formats print the largest position and normal error of every mesh when they are encoded
+    static Data import(const std::string &modelName, Mesh::VertexFormat format = Mesh::FLOAT32);
 
     void deleteModel() {
         for (auto &mesh : meshes) {
@@ -19,17 +77,72 @@ class Model {
         }
     }
 
-    void Draw(Shader &shader);
+    // Adds the node hierarchy to the scene below parent, every node keeps its transform from the file
+    void attach(SceneGraph &scene, SceneGraph::NodeId parent);
+
+    [[nodiscard]] bool               isAttached() const noexcept { return !sceneNodes.empty(); }
+    [[nodiscard]] SceneGraph::NodeId getRootNode() const { return sceneNodes.at(0); }
+    [[nodiscard]] const std::string &getName() const noexcept { return name; }
+
+    // What the meshes keep on the CPU, their share of the geometry arenas and the resident levels of the textures of
+    // their materials. Textures shared with other models are counted by each of them.
+    [[nodiscard]] MemoryUsage getMemoryUsage() const;
+
+    // Queues every mesh with the world matrix of its node and the level of detail for its size on screen, the scene has
+    // to be updated and the model attached. Every mesh is drawn with the variant for its material's features. The
+    // textures of the visible meshes are requested from the TextureManager, and the visible meshes large enough on
+    // screen are added to the occluders when an occlusion culler is given.
+    void submit(RenderQueue      &queue,
+                ShaderVariants   &shaders,
+                const SceneGraph &scene,
+                const Camera     &camera,
+                OcclusionCuller  *occlusion = nullptr);
+
+    // Queues every mesh once per instance without going through the scene, the node transforms from the file are
+    // applied below each instance transform. With instancing on the queue turns every mesh into a single draw call.
+    // The level of detail selection and the draws of chunks of INSTANCE_CHUNK instances run on the JobSystem.
+    void submitInstances(RenderQueue              &queue,
+                         ShaderVariants           &shaders,
+                         std::span<const Instance> instances,
+                         const Camera             &camera,
+                         OcclusionCuller          *occlusion = nullptr);
+
+    static constexpr size_t INSTANCE_CHUNK = 1024;
 
     private:
+    static constexpr unsigned int IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_FlipUVs;
+
+    // what a job of submitInstances leaves for the calling thread
+    struct InstanceChunk {
+        std::vector<float>                           textureRadii; // per mesh, -1 when no instance was visible
+        std::vector<std::pair<uint32_t, glm::mat4>> occluders;    // mesh and world matrix
+    };
+
     // model data
-    std::vector<Mesh>     meshes;
-    std::filesystem::path directory{};
+    std::string                     name;
+    std::vector<Mesh>               meshes;
+    std::vector<Node>               nodes;
+    std::vector<SceneGraph::NodeId> sceneNodes; // parallel to nodes once attached
+    std::vector<glm::mat4>          modelSpace; // node to model root transforms, parallel to nodes
+
+    // level of detail each mesh was last drawn with, for the hysteresis of Mesh::selectLod
+    std::vector<uint8_t> lodLevels;
+    std::vector<uint8_t> instanceLodLevels; // instance major
+
+    std::vector<InstanceChunk> instanceChunks;
 
-    void   loadModel(const std::string &modelName);
-    void   processNode(aiNode *node, const aiScene *scene);
-    Mesh   processMesh(aiMesh *mesh, const aiScene *scene);
-    GLuint getTextureId(const std::string &texturePath);
+    static void       processNode(aiNode                *node,
+                                  const aiScene         *scene,
+                                  uint32_t               parent,
+                                  std::vector<Node>     &nodes,
+                                  std::vector<aiMesh *> &nodeMeshes);
+    static Mesh::Data processMesh(aiMesh *mesh, const aiScene *scene);
+    static void       decodeTextures(Data &data, const std::filesystem::path &directory);
+    static uint32_t   createMaterial(const Mesh::View &view, Data &data, TextureUploadQueue *textureQueue);
+    static GLuint     getTextureId(const std::string &path, Data &data, TextureUploadQueue *textureQueue);
+    static void       requestTextures(const Mesh &mesh, float projectedRadius);
 
-    std::vector<Mesh::Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, const std::string &typeName);
-};
\ No newline at end of file
+    static std::vector<Mesh::Texture> loadMaterialTextures(aiMaterial        *mat,
+                                                           aiTextureType      type,
+                                                           const std::string &typeName);
+};
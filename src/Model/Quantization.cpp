@@ -0,0 +1,130 @@
+#include "Quantization.hpp"
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr float    UNORM16_MAX = 65535.0f;
+constexpr float    SNORM10_MAX = 511.0f;
+constexpr uint32_t MASK_10     = 0x3FF;
+constexpr float    MIN_EXTENT  = 1e-8f;
+
+uint32_t packSnorm10(float value) {
+    const auto quantized = static_cast<int32_t>(std::round(std::clamp(value, -1.0f, 1.0f) * SNORM10_MAX));
+    return static_cast<uint32_t>(quantized) & MASK_10;
+}
+
+float unpackSnorm10(uint32_t bits) {
+    // sign extend the 10 bit value
+    const auto value = static_cast<int32_t>(bits << 22) >> 22;
+    return std::max(static_cast<float>(value) / SNORM10_MAX, -1.0f);
+}
+
+uint32_t packNormal1010102(glm::vec3 normal) {
+    return packSnorm10(normal.x) | packSnorm10(normal.y) << 10 | packSnorm10(normal.z) << 20;
+}
+
+glm::vec3 unpackNormal1010102(uint32_t packed) {
+    return {unpackSnorm10(packed & MASK_10),
+            unpackSnorm10(packed >> 10 & MASK_10),
+            unpackSnorm10(packed >> 20 & MASK_10)};
+}
+
+float angleDegrees(glm::vec3 a, glm::vec3 b) {
+    const float lengths = glm::length(a) * glm::length(b);
+    if (lengths == 0.0f) {
+        return 0.0f;
+    }
+    return glm::degrees(std::acos(std::clamp(glm::dot(a, b) / lengths, -1.0f, 1.0f)));
+}
+
+} // namespace
+
+glm::vec2 Quantization::encodeOctahedral(glm::vec3 normal) {
+    const float sum = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (sum == 0.0f) {
+        return {0.0f, 0.0f};
+    }
+
+    glm::vec2 encoded(normal.x / sum, normal.y / sum);
+
+    // the lower hemisphere is folded over the diagonals
+    if (normal.z < 0.0f) {
+        const glm::vec2 folded((1.0f - std::abs(encoded.y)) * (encoded.x >= 0.0f ? 1.0f : -1.0f),
+                               (1.0f - std::abs(encoded.x)) * (encoded.y >= 0.0f ? 1.0f : -1.0f));
+        encoded = folded;
+    }
+
+    return encoded;
+}
+
+glm::vec3 Quantization::decodeOctahedral(glm::vec2 encoded) {
+    glm::vec3 normal(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+
+    const float fold = std::max(-normal.z, 0.0f);
+    normal.x += normal.x >= 0.0f ? -fold : fold;
+    normal.y += normal.y >= 0.0f ? -fold : fold;
+
+    return glm::normalize(normal);
+}
+
+glm::vec3 Quantization::decodePosition(const Vertex &vertex, const Mesh::Dequantization &dequantization) {
+    const glm::vec3 normalized(static_cast<float>(vertex.position[0]) / UNORM16_MAX,
+                               static_cast<float>(vertex.position[1]) / UNORM16_MAX,
+                               static_cast<float>(vertex.position[2]) / UNORM16_MAX);
+    return dequantization.offset + normalized * dequantization.scale;
+}
+
+void Quantization::encode(Mesh::Data &mesh, Mesh::VertexFormat format) {
+    mesh.format = format;
+    mesh.encodedVertices.clear();
+    mesh.dequantization   = {};
+    mesh.maxPositionError = 0.0f;
+    mesh.maxNormalError   = 0.0f;
+
+    if (format == Mesh::FLOAT32) {
+        return;
+    }
+
+    const glm::vec3 extent = mesh.boundsMax - mesh.boundsMin;
+    const glm::vec3 scale(
+            std::max(extent.x, MIN_EXTENT), std::max(extent.y, MIN_EXTENT), std::max(extent.z, MIN_EXTENT));
+
+    mesh.dequantization = {mesh.boundsMin, scale};
+    mesh.encodedVertices.resize(mesh.vertices.size() * sizeof(Vertex));
+
+    for (size_t i = 0; i < mesh.vertices.size(); i++) {
+        const Mesh::Vertex &source = mesh.vertices[i];
+        Vertex              vertex{};
+
+        glm::vec3 decodedPosition;
+        for (int axis = 0; axis < 3; axis++) {
+            const float offset     = source.Position[axis] - mesh.boundsMin[axis];
+            const float normalized = std::clamp(offset / scale[axis], 0.0f, 1.0f);
+            const auto  quantized  = static_cast<uint16_t>(std::round(normalized * UNORM16_MAX));
+
+            vertex.position.at(static_cast<size_t>(axis)) = quantized;
+            decodedPosition[axis] = mesh.boundsMin[axis] + static_cast<float>(quantized) / UNORM16_MAX * scale[axis];
+        }
+
+        glm::vec3 decodedNormal;
+        if (format == Mesh::QUANTIZED_OCTAHEDRAL) {
+            vertex.normal = glm::packSnorm2x16(encodeOctahedral(source.Normal));
+            decodedNormal = decodeOctahedral(glm::unpackSnorm2x16(vertex.normal));
+        } else {
+            vertex.normal = packNormal1010102(source.Normal);
+            decodedNormal = unpackNormal1010102(vertex.normal);
+        }
+
+        vertex.texCoords = glm::packHalf2x16(source.TexCoords);
+
+        mesh.maxPositionError = std::max(mesh.maxPositionError, glm::distance(source.Position, decodedPosition));
+        mesh.maxNormalError   = std::max(mesh.maxNormalError, angleDegrees(source.Normal, decodedNormal));
+
+        std::memcpy(mesh.encodedVertices.data() + i * sizeof(Vertex), &vertex, sizeof(Vertex));
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+
+#include "Mesh.hpp"
+
+// Compact vertex encodings for Mesh::QUANTIZED and Mesh::QUANTIZED_OCTAHEDRAL.
+//
+// Positions are 16 bit unorm inside the mesh bounds and are restored in the vertex shader with the per-mesh
+// dequantization transform. Normals are either 10_10_10_2 snorm or an octahedral mapping stored as 2x16 bit snorm,
+// texture coordinates are half floats.
+namespace Quantization {
+struct Vertex {
+    std::array<uint16_t, 4> position; // the fourth component only pads the normal to a 4 byte boundary
+    uint32_t                normal;
+    uint32_t                texCoords;
+};
+
+static_assert(sizeof(Vertex) == 16, "Quantization::Vertex must not contain padding");
+
+// Encodes mesh.vertices into mesh.encodedVertices and measures the error of the encoding. FLOAT32 only sets the format.
+void encode(Mesh::Data &mesh, Mesh::VertexFormat format);
+
+// Model space position of an encoded vertex, what the vertex shader computes from the dequantization uniforms
+glm::vec3 decodePosition(const Vertex &vertex, const Mesh::Dequantization &dequantization);
+
+// Maps a unit vector onto the [-1, 1] square and back
+glm::vec2 encodeOctahedral(glm::vec3 normal);
+glm::vec3 decodeOctahedral(glm::vec2 encoded);
+} // namespace Quantization
@@ -0,0 +1,80 @@
+#include "ResourceIOSystem.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <utility>
+
+#include <Utility/fs_helpers.hpp>
+
+namespace {
+
+// Read-only stream over the bytes of a resource
+class ResourceStream : public Assimp::IOStream {
+    public:
+    explicit ResourceStream(fs_helpers::Resource resource) : m_resource(std::move(resource)) {}
+
+    size_t Read(void *buffer, size_t size, size_t count) override {
+        if (size == 0) {
+            return 0;
+        }
+
+        // only whole elements are read, like fread
+        count = std::min(count, (m_resource.size() - m_position) / size);
+        if (count > 0) {
+            std::memcpy(buffer, m_resource.bytes().subspan(m_position).data(), size * count);
+            m_position += size * count;
+        }
+        return count;
+    }
+
+    size_t Write(const void * /*buffer*/, size_t /*size*/, size_t /*count*/) override { return 0; }
+
+    aiReturn Seek(size_t offset, aiOrigin origin) override {
+        size_t base = 0;
+        if (origin == aiOrigin_CUR) {
+            base = m_position;
+        } else if (origin == aiOrigin_END) {
+            base = m_resource.size();
+        }
+
+        if (base + offset > m_resource.size()) {
+            return aiReturn_FAILURE;
+        }
+        m_position = base + offset;
+        return aiReturn_SUCCESS;
+    }
+
+    [[nodiscard]] size_t Tell() const override { return m_position; }
+    [[nodiscard]] size_t FileSize() const override { return m_resource.size(); }
+
+    void Flush() override {}
+
+    private:
+    fs_helpers::Resource m_resource;
+    size_t               m_position = 0;
+};
+
+} // namespace
+
+bool ResourceIOSystem::Exists(const char *file) const {
+    return fs_helpers::resourceExists(file);
+}
+
+Assimp::IOStream *ResourceIOSystem::Open(const char *file, const char *mode) {
+    // resources can't be written
+    if (std::string_view(mode).find_first_of("wa+") != std::string_view::npos) {
+        return nullptr;
+    }
+
+    auto resource = fs_helpers::openResource(file);
+    if (!resource.has_value()) {
+        return nullptr;
+    }
+    m_openedFiles.emplace_back(file);
+    return new ResourceStream(std::move(*resource)); // NOLINT(cppcoreguidelines-owning-memory)
+}
+
+void ResourceIOSystem::Close(Assimp::IOStream *stream) {
+    delete stream; // NOLINT(cppcoreguidelines-owning-memory)
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <assimp/IOStream.hpp>
+#include <assimp/IOSystem.hpp>
+
+#include <filesystem>
+#include <vector>
+
+// Lets Assimp read models and the files they reference, like OBJ material libraries, through fs_helpers::openResource.
+// Packed files are parsed straight from the mapped archive, loose ones from a mapping of the file. Nothing is written.
+class ResourceIOSystem : public Assimp::IOSystem {
+    public:
+    bool              Exists(const char *file) const override;
+    char              getOsSeparator() const override { return '/'; }
+    Assimp::IOStream *Open(const char *file, const char *mode = "rb") override;
+    void              Close(Assimp::IOStream *stream) override;
+
+    // Every file opened so far in the order Assimp asked for them, the mesh cache keys its entries on them
+    [[nodiscard]] const std::vector<std::filesystem::path> &getOpenedFiles() const noexcept { return m_openedFiles; }
+
+    private:
+    std::vector<std::filesystem::path> m_openedFiles;
+};
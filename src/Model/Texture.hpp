@@ -4,4 +4,9 @@ namespace Texture {
 constexpr const char* DIFFUSE   = "texture_diffuse";
 constexpr const char* SPECULAR  = "texture_specular";
 constexpr const char* ROUGHNESS = "texture_roughness";
-} // namespace Texture
\ No newline at end of file
+
+// Every map type has a fixed texture unit, the samplers are pointed at them once per program
+constexpr int DIFFUSE_UNIT   = 0;
+constexpr int SPECULAR_UNIT  = 1;
+constexpr int ROUGHNESS_UNIT = 2;
+} // namespace Texture
@@ -0,0 +1,461 @@
+#include "TextureCompression.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+constexpr int    BLOCK_DIMENSION = 4;
+constexpr size_t BLOCK_TEXELS    = 16;
+
+using Color = std::array<float, 3>;
+
+// sRGB transfer function, 8 bit sRGB to linear through a table and linear back to 8 bit through a finer one
+float srgbToLinear(float value) {
+    return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+float linearToSrgb(float value) {
+    return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+}
+
+const std::array<float, 256> &decodeTable() {
+    static const std::array<float, 256> table = [] {
+        std::array<float, 256> values{};
+        for (size_t i = 0; i < values.size(); i++) {
+            values.at(i) = srgbToLinear(static_cast<float>(i) / 255.0f);
+        }
+        return values;
+    }();
+    return table;
+}
+
+// the darkest 8 bit sRGB step is about 3e-4 in linear space, 16 bit of table resolution stays well below it
+constexpr size_t ENCODE_TABLE_SIZE = 1 << 16;
+
+const std::vector<uint8_t> &encodeTable() {
+    static const std::vector<uint8_t> table = [] {
+        std::vector<uint8_t> values(ENCODE_TABLE_SIZE);
+        for (size_t i = 0; i < values.size(); i++) {
+            const float srgb = linearToSrgb(static_cast<float>(i) / static_cast<float>(ENCODE_TABLE_SIZE - 1));
+            values[i]        = static_cast<uint8_t>(std::lround(std::clamp(srgb, 0.0f, 1.0f) * 255.0f));
+        }
+        return values;
+    }();
+    return table;
+}
+
+uint8_t quantizeUnorm(float value) {
+    return static_cast<uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+}
+
+uint8_t quantizeSrgb(float value) {
+    const float index = std::clamp(value, 0.0f, 1.0f) * static_cast<float>(ENCODE_TABLE_SIZE - 1);
+    return encodeTable()[static_cast<size_t>(std::lround(index))];
+}
+
+// 5:6:5 endpoints, expanded back to 8 bit the way the hardware does it
+uint16_t packColor(const Color &color) {
+    const auto quantize = [](float value, int maximum) {
+        const auto quantized = static_cast<int>(std::lround(value * static_cast<float>(maximum) / 255.0f));
+        return static_cast<uint16_t>(std::clamp(quantized, 0, maximum));
+    };
+    return static_cast<uint16_t>(quantize(color[0], 31) << 11 | quantize(color[1], 63) << 5 | quantize(color[2], 31));
+}
+
+Color unpackColor(uint16_t packed) {
+    const int red   = (packed >> 11) & 31;
+    const int green = (packed >> 5) & 63;
+    const int blue  = packed & 31;
+    return {static_cast<float>(red << 3 | red >> 2),
+            static_cast<float>(green << 2 | green >> 4),
+            static_cast<float>(blue << 3 | blue >> 2)};
+}
+
+float squaredDistance(const Color &a, const Color &b) {
+    const float red   = a[0] - b[0];
+    const float green = a[1] - b[1];
+    const float blue  = a[2] - b[2];
+    return red * red + green * green + blue * blue;
+}
+
+struct ColorBlock {
+    uint16_t color0  = 0;
+    uint16_t color1  = 0;
+    uint32_t indices = 0;
+    float    error   = std::numeric_limits<float>::max();
+};
+
+// Quantizes a pair of endpoints and assigns every texel its closest palette entry. color0 is kept above color1 so the
+// block decodes in four colour mode.
+ColorBlock fitEndpoints(const std::array<Color, BLOCK_TEXELS> &texels, const Color &endpoint0, const Color &endpoint1) {
+    ColorBlock block;
+    block.color0 = packColor(endpoint0);
+    block.color1 = packColor(endpoint1);
+    if (block.color0 < block.color1) {
+        std::swap(block.color0, block.color1);
+    }
+
+    const Color            first  = unpackColor(block.color0);
+    const Color            second = unpackColor(block.color1);
+    std::array<Color, 4> palette{first, second};
+    for (size_t channel = 0; channel < 3; channel++) {
+        palette[2].at(channel) = (2.0f * first.at(channel) + second.at(channel)) / 3.0f;
+        palette[3].at(channel) = (first.at(channel) + 2.0f * second.at(channel)) / 3.0f;
+    }
+
+    // equal endpoints decode in three colour mode, every texel uses the first entry
+    const size_t paletteSize = block.color0 == block.color1 ? 1 : palette.size();
+
+    block.error = 0.0f;
+    for (size_t i = 0; i < BLOCK_TEXELS; i++) {
+        uint32_t best         = 0;
+        float    bestDistance = std::numeric_limits<float>::max();
+        for (size_t entry = 0; entry < paletteSize; entry++) {
+            const float distance = squaredDistance(texels.at(i), palette.at(entry));
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                best         = static_cast<uint32_t>(entry);
+            }
+        }
+        block.indices |= best << (2 * i);
+        block.error += bestDistance;
+    }
+
+    return block;
+}
+
+// Endpoints along the principal axis of the block's colours, refined once by a least squares fit to the indices the
+// first guess produced
+ColorBlock encodeColors(const std::array<Color, BLOCK_TEXELS> &texels) {
+    Color mean{};
+    for (const auto &texel : texels) {
+        for (size_t channel = 0; channel < 3; channel++) {
+            mean.at(channel) += texel.at(channel) / static_cast<float>(BLOCK_TEXELS);
+        }
+    }
+
+    std::array<float, 6> covariance{}; // rr, rg, rb, gg, gb, bb
+    for (const auto &texel : texels) {
+        const float red   = texel[0] - mean[0];
+        const float green = texel[1] - mean[1];
+        const float blue  = texel[2] - mean[2];
+        covariance[0] += red * red;
+        covariance[1] += red * green;
+        covariance[2] += red * blue;
+        covariance[3] += green * green;
+        covariance[4] += green * blue;
+        covariance[5] += blue * blue;
+    }
+
+    Color axis{1.0f, 1.0f, 1.0f};
+    for (int iteration = 0; iteration < 8; iteration++) {
+        const Color next{covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+                         covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+                         covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2]};
+
+        const float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+        if (length < 1e-6f) {
+            axis = {};
+            break;
+        }
+        axis = {next[0] / length, next[1] / length, next[2] / length};
+    }
+
+    float minimum = 0.0f;
+    float maximum = 0.0f;
+    for (const auto &texel : texels) {
+        const float t = (texel[0] - mean[0]) * axis[0] + (texel[1] - mean[1]) * axis[1] +
+                        (texel[2] - mean[2]) * axis[2];
+        minimum = std::min(minimum, t);
+        maximum = std::max(maximum, t);
+    }
+
+    Color endpoint0{};
+    Color endpoint1{};
+    for (size_t channel = 0; channel < 3; channel++) {
+        endpoint0.at(channel) = std::clamp(mean.at(channel) + axis.at(channel) * maximum, 0.0f, 255.0f);
+        endpoint1.at(channel) = std::clamp(mean.at(channel) + axis.at(channel) * minimum, 0.0f, 255.0f);
+    }
+
+    ColorBlock best = fitEndpoints(texels, endpoint0, endpoint1);
+    if (best.color0 == best.color1) {
+        return best;
+    }
+
+    // weight of color0 for each index in four colour mode
+    static constexpr std::array<float, 4> WEIGHTS{1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+
+    float a = 0.0f;
+    float b = 0.0f;
+    float c = 0.0f;
+    Color x0{};
+    Color x1{};
+    for (size_t i = 0; i < BLOCK_TEXELS; i++) {
+        const float w0 = WEIGHTS.at((best.indices >> (2 * i)) & 3);
+        const float w1 = 1.0f - w0;
+        a += w0 * w0;
+        b += w0 * w1;
+        c += w1 * w1;
+        for (size_t channel = 0; channel < 3; channel++) {
+            x0.at(channel) += w0 * texels.at(i).at(channel);
+            x1.at(channel) += w1 * texels.at(i).at(channel);
+        }
+    }
+
+    const float determinant = a * c - b * b;
+    if (std::abs(determinant) < 1e-6f) {
+        return best;
+    }
+
+    for (size_t channel = 0; channel < 3; channel++) {
+        endpoint0.at(channel) = std::clamp((c * x0.at(channel) - b * x1.at(channel)) / determinant, 0.0f, 255.0f);
+        endpoint1.at(channel) = std::clamp((a * x1.at(channel) - b * x0.at(channel)) / determinant, 0.0f, 255.0f);
+    }
+
+    const ColorBlock refined = fitEndpoints(texels, endpoint0, endpoint1);
+    return refined.error < best.error ? refined : best;
+}
+
+template<typename T>
+void writeLittleEndian(std::span<std::byte> destination, T value, size_t bytes) {
+    for (size_t i = 0; i < bytes; i++) {
+        destination[i] = static_cast<std::byte>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+// Gathers the 4x4 block at x, y, texels past the right or top edge repeat the last row or column
+void gatherBlock(std::span<const uint8_t> pixels,
+                 int                      width,
+                 int                      height,
+                 int                      channels,
+                 int                      x,
+                 int                      y,
+                 std::span<uint8_t>       texels) {
+    for (int row = 0; row < BLOCK_DIMENSION; row++) {
+        const int sourceY = std::min(y + row, height - 1);
+        for (int column = 0; column < BLOCK_DIMENSION; column++) {
+            const int  sourceX = std::min(x + column, width - 1);
+            const auto source  = static_cast<size_t>((sourceY * width + sourceX) * channels);
+            const auto target  = static_cast<size_t>((row * BLOCK_DIMENSION + column) * channels);
+            std::copy_n(pixels.begin() + static_cast<std::ptrdiff_t>(source),
+                        channels,
+                        texels.begin() + static_cast<std::ptrdiff_t>(target));
+        }
+    }
+}
+
+std::vector<std::byte>
+encodeLevel(std::span<const uint8_t> pixels, int width, int height, int channels, GLenum format) {
+    const size_t           size = TextureCompression::blockSize(format);
+    std::vector<std::byte> blocks(TextureCompression::levelSize(format, width, height));
+
+    std::array<uint8_t, BLOCK_TEXELS * 4> texels{};
+    const std::span<uint8_t>              blockTexels(texels.data(), BLOCK_TEXELS * static_cast<size_t>(channels));
+
+    size_t offset = 0;
+    for (int y = 0; y < height; y += BLOCK_DIMENSION) {
+        for (int x = 0; x < width; x += BLOCK_DIMENSION) {
+            gatherBlock(pixels, width, height, channels, x, y, blockTexels);
+
+            const std::span<std::byte> block(blocks.data() + offset, size);
+            switch (format) {
+            case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+                TextureCompression::encodeBC1(blockTexels, channels, block.first<8>());
+                break;
+            case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+                TextureCompression::encodeBC3(blockTexels, block.first<16>());
+                break;
+            case GL_COMPRESSED_RED_RGTC1:
+                TextureCompression::encodeBC4(blockTexels, channels, 0, block.first<8>());
+                break;
+            case GL_COMPRESSED_RG_RGTC2:
+                TextureCompression::encodeBC5(blockTexels, channels, block.first<16>());
+                break;
+            default:
+                throw std::runtime_error(std::format("TextureCompression | Unsupported format: {:#x}", format));
+            }
+
+            offset += size;
+        }
+    }
+
+    return blocks;
+}
+} // namespace
+
+namespace TextureCompression {
+GLenum selectFormat(int channels) noexcept {
+    switch (channels) {
+    case 1:
+        return GL_COMPRESSED_RED_RGTC1;
+    case 2:
+        return GL_COMPRESSED_RG_RGTC2;
+    case 3:
+        return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case 4:
+        return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    default:
+        return 0;
+    }
+}
+
+const char *formatName(GLenum format) noexcept {
+    switch (format) {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        return "BC1";
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        return "BC3";
+    case GL_COMPRESSED_RED_RGTC1:
+        return "BC4";
+    case GL_COMPRESSED_RG_RGTC2:
+        return "BC5";
+    default:
+        return "uncompressed";
+    }
+}
+
+size_t blockSize(GLenum format) noexcept {
+    switch (format) {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RED_RGTC1:
+        return 8;
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+    case GL_COMPRESSED_RG_RGTC2:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+size_t levelSize(GLenum format, int width, int height) noexcept {
+    const auto blocksX = static_cast<size_t>((width + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION);
+    const auto blocksY = static_cast<size_t>((height + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION);
+    return blocksX * blocksY * blockSize(format);
+}
+
+int uncompressedChannels(GLenum format) noexcept {
+    switch (format) {
+    case GL_COMPRESSED_RED_RGTC1:
+        return 1;
+    case GL_COMPRESSED_RG_RGTC2:
+        return 2;
+    default:
+        return 4;
+    }
+}
+
+std::vector<Level> compress(const Image &image, GLenum format, bool color) {
+    const int  channels     = image.channels;
+    const auto colorChannel = [&](int channel) { return color && channel < 3; }; // alpha is always linear
+
+    int width  = image.width;
+    int height = image.height;
+
+    const std::span<const uint8_t> source(image.pixels.get(), image.size());
+    std::vector<float>             linear(source.size());
+    for (size_t i = 0; i < source.size(); i++) {
+        const auto channel = static_cast<int>(i % static_cast<size_t>(channels));
+        linear[i] = colorChannel(channel) ? decodeTable().at(source[i]) : static_cast<float>(source[i]) / 255.0f;
+    }
+
+    std::vector<Level>   levels;
+    std::vector<uint8_t> pixels(source.begin(), source.end());
+
+    while (true) {
+        levels.push_back({width, height, encodeLevel(pixels, width, height, channels, format)});
+
+        if (width == 1 && height == 1) {
+            break;
+        }
+
+        // 2x2 box filter, an odd last row or column is clamped onto its neighbour
+        const int          nextWidth  = std::max(1, width / 2);
+        const int          nextHeight = std::max(1, height / 2);
+        std::vector<float> next(static_cast<size_t>(nextWidth * nextHeight * channels));
+
+        for (int y = 0; y < nextHeight; y++) {
+            const int y0 = std::min(2 * y, height - 1);
+            const int y1 = std::min(2 * y + 1, height - 1);
+            for (int x = 0; x < nextWidth; x++) {
+                const int x0 = std::min(2 * x, width - 1);
+                const int x1 = std::min(2 * x + 1, width - 1);
+                for (int channel = 0; channel < channels; channel++) {
+                    const auto texel = [&](int sourceX, int sourceY) {
+                        return linear[static_cast<size_t>((sourceY * width + sourceX) * channels + channel)];
+                    };
+                    next[static_cast<size_t>((y * nextWidth + x) * channels + channel)] =
+                            0.25f * (texel(x0, y0) + texel(x1, y0) + texel(x0, y1) + texel(x1, y1));
+                }
+            }
+        }
+
+        width  = nextWidth;
+        height = nextHeight;
+        linear = std::move(next);
+
+        pixels.resize(linear.size());
+        for (size_t i = 0; i < linear.size(); i++) {
+            const auto channel = static_cast<int>(i % static_cast<size_t>(channels));
+            pixels[i]          = colorChannel(channel) ? quantizeSrgb(linear[i]) : quantizeUnorm(linear[i]);
+        }
+    }
+
+    return levels;
+}
+
+void encodeBC1(std::span<const uint8_t> texels, int channels, std::span<std::byte, 8> block) {
+    std::array<Color, BLOCK_TEXELS> colors{};
+    for (size_t i = 0; i < BLOCK_TEXELS; i++) {
+        for (size_t channel = 0; channel < 3; channel++) {
+            colors.at(i).at(channel) = static_cast<float>(texels[i * static_cast<size_t>(channels) + channel]);
+        }
+    }
+
+    const ColorBlock encoded = encodeColors(colors);
+    writeLittleEndian(block.subspan(0, 2), encoded.color0, 2);
+    writeLittleEndian(block.subspan(2, 2), encoded.color1, 2);
+    writeLittleEndian(block.subspan(4, 4), encoded.indices, 4);
+}
+
+void encodeBC3(std::span<const uint8_t> texels, std::span<std::byte, 16> block) {
+    encodeBC4(texels, 4, 3, block.first<8>());
+    encodeBC1(texels, 4, block.last<8>());
+}
+
+void encodeBC4(std::span<const uint8_t> texels, int channels, int channel, std::span<std::byte, 8> block) {
+    std::array<uint8_t, BLOCK_TEXELS> values{};
+    for (size_t i = 0; i < BLOCK_TEXELS; i++) {
+        values.at(i) = texels[i * static_cast<size_t>(channels) + static_cast<size_t>(channel)];
+    }
+
+    const auto [minimum, maximum] = std::minmax_element(values.begin(), values.end());
+
+    // with the first endpoint above the second the block has eight evenly spaced values, equal endpoints decode every
+    // index 0 texel to the first one
+    block[0] = static_cast<std::byte>(*maximum);
+    block[1] = static_cast<std::byte>(*minimum);
+
+    uint64_t indices = 0;
+    if (*maximum != *minimum) {
+        const float range = static_cast<float>(*maximum - *minimum);
+        for (size_t i = 0; i < BLOCK_TEXELS; i++) {
+            // t counts sevenths from the second endpoint, index 0 is the first endpoint and 1 the second
+            const auto     t     = std::lround(static_cast<float>(values.at(i) - *minimum) * 7.0f / range);
+            const uint64_t index = t == 7 ? 0 : t == 0 ? 1 : static_cast<uint64_t>(8 - t);
+            indices |= index << (3 * i);
+        }
+    }
+
+    writeLittleEndian(block.subspan(2, 6), indices, 6);
+}
+
+void encodeBC5(std::span<const uint8_t> texels, int channels, std::span<std::byte, 16> block) {
+    encodeBC4(texels, channels, 0, block.first<8>());
+    encodeBC4(texels, channels, 1, block.last<8>());
+}
+} // namespace TextureCompression
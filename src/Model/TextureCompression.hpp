@@ -0,0 +1,48 @@
+#pragma once
+
+#include <Utility/OpenGlHeaders.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Image.hpp"
+
+// Block compression of 8 bit images into the formats every desktop GPU samples natively.
+//
+// Each 4x4 block of texels is stored in 8 (BC1, BC4) or 16 (BC3, BC5) bytes. The format follows the channel count of
+// the source: RGB is BC1, RGBA is BC3, single channel maps are BC4 and two channel maps are BC5. Mip levels are
+// filtered on the CPU in linear space, colour textures are converted from sRGB first so dark texels don't swallow
+// bright ones.
+namespace TextureCompression {
+struct Level {
+    int                    width;
+    int                    height;
+    std::vector<std::byte> blocks;
+};
+
+// Compressed internal format for an image with the given channel count, 0 when there is none
+GLenum selectFormat(int channels) noexcept;
+
+// Short name such as "BC1" for reports
+const char *formatName(GLenum format) noexcept;
+
+// Bytes of a single 4x4 block, 0 for formats that aren't block compressed
+size_t blockSize(GLenum format) noexcept;
+
+// Bytes of a level, partial blocks at the edges take a whole block
+size_t levelSize(GLenum format, int width, int height) noexcept;
+
+// Channel count the GL driver stores an uncompressed texture of the format with, RGB is padded to RGBA
+int uncompressedChannels(GLenum format) noexcept;
+
+// Filters the full mip chain down to 1x1 and compresses every level. Colour images are filtered in linear space.
+std::vector<Level> compress(const Image &image, GLenum format, bool color);
+
+// Single block encoders, texels holds the 16 texels of the block row by row with the given number of channels
+void encodeBC1(std::span<const uint8_t> texels, int channels, std::span<std::byte, 8> block);
+void encodeBC3(std::span<const uint8_t> texels, std::span<std::byte, 16> block);
+void encodeBC4(std::span<const uint8_t> texels, int channels, int channel, std::span<std::byte, 8> block);
+void encodeBC5(std::span<const uint8_t> texels, int channels, std::span<std::byte, 16> block);
+} // namespace TextureCompression
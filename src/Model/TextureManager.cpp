@@ -0,0 +1,255 @@
+#include "TextureManager.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <span>
+
+TextureManager &TextureManager::shared() {
+    static TextureManager manager;
+    return manager;
+}
+
+GLuint TextureManager::find(const std::string &path) const {
+    auto iterator = m_byPath.find(path);
+    return iterator != m_byPath.end() ? iterator->second : 0;
+}
+
+GLuint TextureManager::add(const std::string &path, CompressedImage image) {
+    const auto levelCount = static_cast<uint32_t>(image.levels.size());
+
+    uint32_t tail = 0;
+    while (tail + 1 < levelCount && std::max(image.levels[tail].width, image.levels[tail].height) > TAIL_SIZE) {
+        tail++;
+    }
+
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levelCount - 1));
+
+    m_entries.push_back({texture, std::move(image), tail, levelCount, tail});
+    m_byTexture[texture] = m_entries.size() - 1;
+    m_byPath[path]       = texture;
+
+    Entry &entry = m_entries.back();
+    while (entry.resident > tail) {
+        uploadLevel(entry);
+    }
+
+    return texture;
+}
+
+void TextureManager::addPinned(const std::string &path, GLuint texture, size_t bytes) {
+    m_pinned[texture] = bytes;
+    m_byPath[path] = texture;
+    m_pinnedBytes += bytes;
+}
+
+void TextureManager::request(GLuint texture, float screenPixels) {
+    auto iterator = m_byTexture.find(texture);
+    if (iterator == m_byTexture.end()) {
+        return;
+    }
+
+    Entry &entry = m_entries[iterator->second];
+
+    // the finest level that still has at most one texel per pixel
+    const auto  size  = static_cast<float>(std::max(entry.image.width(), entry.image.height()));
+    const auto  tail  = static_cast<float>(entry.tail);
+    const float level = screenPixels > 0.0f ? std::clamp(std::floor(std::log2(size / screenPixels)), 0.0f, tail) : tail;
+
+    entry.wanted   = std::min(entry.wanted, static_cast<uint32_t>(level));
+    entry.lastUsed = m_frame;
+}
+
+size_t TextureManager::residentSize(const Entry &entry, uint32_t first) {
+    size_t size = 0;
+    for (size_t level = first; level < entry.image.levels.size(); level++) {
+        size += entry.image.levels[level].size;
+    }
+    return size;
+}
+
+void TextureManager::evict(Entry &entry, uint32_t level) {
+    glBindTexture(GL_TEXTURE_2D, entry.texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(level));
+
+    // an empty image releases the storage of a level, it is outside of the sampled range from now on
+    for (uint32_t dropped = entry.resident; dropped < level; dropped++) {
+        glCompressedTexImage2D(
+                GL_TEXTURE_2D, static_cast<GLint>(dropped), entry.image.internalFormat, 0, 0, 0, 0, nullptr);
+    }
+
+    m_evictions += level - entry.resident;
+    entry.resident = level;
+}
+
+void TextureManager::uploadLevel(Entry &entry) {
+    const uint32_t                   level  = entry.resident - 1;
+    const std::span<const std::byte> blocks = entry.image.level(level);
+
+    glBindTexture(GL_TEXTURE_2D, entry.texture);
+    glCompressedTexImage2D(GL_TEXTURE_2D,
+                           static_cast<GLint>(level),
+                           entry.image.internalFormat,
+                           entry.image.levels[level].width,
+                           entry.image.levels[level].height,
+                           0,
+                           static_cast<GLsizei>(blocks.size()),
+                           blocks.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(level));
+
+    entry.resident = level;
+}
+
+void TextureManager::update() {
+    // requested this frame first, then by the time of the last request
+    std::vector<size_t> order(m_entries.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return m_entries[a].lastUsed > m_entries[b].lastUsed;
+    });
+
+    // the tails are always resident, what is left of the budget goes to the finer levels
+    size_t tails = 0;
+    for (const auto &entry : m_entries) {
+        tails += residentSize(entry, entry.tail);
+    }
+    size_t available = m_budget > m_pinnedBytes + tails ? m_budget - m_pinnedBytes - tails : 0;
+
+    const auto extraSize = [](const Entry &entry, uint32_t level) {
+        return residentSize(entry, level) - residentSize(entry, entry.tail);
+    };
+
+    const auto requested = static_cast<size_t>(
+            std::find_if(order.begin(), order.end(), [&](size_t i) { return m_entries[i].lastUsed != m_frame; }) -
+            order.begin());
+
+    // every requested texture gives up the same number of levels until they fit together
+    m_requestedBytes = m_pinnedBytes;
+    uint32_t bias    = 0;
+    for (;; bias++) {
+        size_t needed   = 0;
+        bool   allTails = true;
+        for (size_t i = 0; i < requested; i++) {
+            const Entry   &entry = m_entries[order[i]];
+            const uint32_t level = std::min(entry.wanted + bias, entry.tail);
+            needed += extraSize(entry, level);
+            allTails = allTails && level == entry.tail;
+        }
+        if (bias == 0) {
+            m_requestedBytes += needed + tails;
+        }
+        if (needed <= available || allTails) {
+            available -= std::min(needed, available);
+            break;
+        }
+    }
+
+    std::vector<uint32_t> targets(m_entries.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        const Entry &entry = m_entries[order[i]];
+        if (i < requested) {
+            targets[order[i]] = std::min(entry.wanted + bias, entry.tail);
+            continue;
+        }
+
+        // textures that weren't requested keep what fits of their levels, the least recently used lose them first
+        uint32_t level = entry.resident;
+        while (level < entry.tail && extraSize(entry, level) > available) {
+            level++;
+        }
+        available -= std::min(extraSize(entry, level), available);
+        targets[order[i]] = level;
+    }
+
+    // free the memory before streaming anything in
+    for (size_t i = 0; i < m_entries.size(); i++) {
+        if (targets[i] > m_entries[i].resident) {
+            evict(m_entries[i], targets[i]);
+        }
+    }
+
+    // one level per texture and pass so the budget is shared, the first level always goes through even when it is
+    // larger than the budget
+    m_uploadedBytes = 0;
+    bool progress   = true;
+    while (progress && m_uploadedBytes < m_uploadBudget) {
+        progress = false;
+        for (size_t i = 0; i < requested && m_uploadedBytes < m_uploadBudget; i++) {
+            Entry &entry = m_entries[order[i]];
+            if (entry.resident <= targets[order[i]]) {
+                continue;
+            }
+
+            const size_t size = entry.image.levels[entry.resident - 1].size;
+            if (m_uploadedBytes != 0 && m_uploadedBytes + size > m_uploadBudget) {
+                continue;
+            }
+
+            uploadLevel(entry);
+            m_uploadedBytes += size;
+            progress = true;
+        }
+    }
+
+    for (auto &entry : m_entries) {
+        entry.wanted = entry.tail;
+    }
+    m_frame++;
+}
+
+TextureManager::Stats TextureManager::getStats() const {
+    size_t resident = m_pinnedBytes;
+    for (const auto &entry : m_entries) {
+        resident += residentSize(entry, entry.resident);
+    }
+
+    return {m_entries.size() + m_pinned.size(), resident, m_requestedBytes, m_budget, m_uploadedBytes, m_evictions};
+}
+
+std::optional<size_t> TextureManager::getResidentBytes(GLuint texture) const {
+    if (auto iterator = m_byTexture.find(texture); iterator != m_byTexture.end()) {
+        const Entry &entry = m_entries[iterator->second];
+        return residentSize(entry, entry.resident);
+    }
+    if (auto iterator = m_pinned.find(texture); iterator != m_pinned.end()) {
+        return iterator->second;
+    }
+    return std::nullopt;
+}
+
+MemoryUsage TextureManager::getMemoryUsage() const {
+    MemoryUsage usage;
+    usage.cpuBytes     = m_entries.capacity() * sizeof(Entry);
+    usage.textureBytes = getStats().residentBytes;
+    usage.glObjects    = m_entries.size() + m_pinned.size();
+
+    for (const auto &entry : m_entries) {
+        usage.cpuBytes += entry.image.levels.capacity() * sizeof(CompressedImage::Level);
+        usage.cpuBytes += entry.image.storage.capacity();
+        usage.mappedBytes += entry.image.mapping.size();
+    }
+    return usage;
+}
+
+void TextureManager::deleteTextures() {
+    for (const auto &entry : m_entries) {
+        glDeleteTextures(1, &entry.texture);
+    }
+    for (const auto &[texture, bytes] : m_pinned) {
+        glDeleteTextures(1, &texture);
+    }
+
+    m_entries.clear();
+    m_byTexture.clear();
+    m_byPath.clear();
+    m_pinned.clear();
+    m_pinnedBytes = 0;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <Utility/OpenGlHeaders.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <Utility/MemoryUsage.hpp>
+
+#include "CompressedImage.hpp"
+
+// Keeps the mip levels of the compressed textures on the GPU that the visible meshes need, within a memory budget.
+//
+// The models request the textures of every visible mesh each frame along with the size the mesh covers on screen,
+// which gives the finest level worth sampling. update() spends the budget on the textures requested this frame first,
+// all of them give up the same number of levels when they don't fit together, and the rest of the budget keeps the
+// levels of the least recently requested textures alive until it runs out. Dropped levels are released on the GPU and
+// streamed back in from the mapped KTX files when they are needed again. GL_TEXTURE_BASE_LEVEL limits sampling to the
+// resident levels, so a texture missing its finest levels is blurrier but never incomplete.
+class TextureManager {
+    public:
+    struct Stats {
+        size_t textures;       // managed and pinned
+        size_t residentBytes;  // on the GPU, pinned textures included
+        size_t requestedBytes; // what the requests of the last frame need without a budget, pinned textures included
+        size_t budgetBytes;
+        size_t uploadedBytes; // by the last update
+        size_t evictions;     // levels dropped so far
+    };
+
+    static constexpr size_t DEFAULT_BUDGET = 256 * 1024 * 1024;
+
+    // Levels up to this size are uploaded with the texture and never dropped
+    static constexpr int TAIL_SIZE = 64;
+
+    static TextureManager &shared();
+
+    void setBudget(size_t bytes) noexcept { m_budget = bytes; }
+    void setUploadBudget(size_t bytes) noexcept { m_uploadBudget = bytes; }
+
+    // The texture created for path, 0 when there is none yet
+    [[nodiscard]] GLuint find(const std::string &path) const;
+
+    // Creates a texture that only holds the tail of the mip chain, the finer levels follow once they are requested
+    GLuint add(const std::string &path, CompressedImage image);
+
+    // Counts a texture that always stays fully resident, used for uncompressed textures whose levels are generated
+    // by the driver and can't be brought back once dropped
+    void addPinned(const std::string &path, GLuint texture, size_t bytes);
+
+    // Asks for a texture drawn on a surface screenPixels across, unknown textures such as the material fallbacks are
+    // ignored. The textures are assumed to cover their mesh once.
+    void request(GLuint texture, float screenPixels);
+
+    // Drops and streams levels for this frame's requests, must be called on the context thread after the models
+    // submitted and before the draw calls
+    void update();
+
+    [[nodiscard]] Stats getStats() const;
+
+    // Bytes of a texture on the GPU, nullopt for textures it doesn't know such as the material fallbacks
+    [[nodiscard]] std::optional<size_t> getResidentBytes(GLuint texture) const;
+
+    // The resident levels of every texture, and the compressed images kept to stream levels back in. Images read from
+    // a KTX file are mapped, freshly transcoded ones stay on the heap.
+    [[nodiscard]] MemoryUsage getMemoryUsage() const;
+
+    void deleteTextures();
+
+    private:
+    struct Entry {
+        GLuint          texture;
+        CompressedImage image;
+        uint32_t        tail;         // first level that always stays resident
+        uint32_t        resident;     // finest level on the GPU
+        uint32_t        wanted;       // finest level requested this frame
+        uint64_t        lastUsed = 0; // frame of the last request
+    };
+
+    std::vector<Entry>                      m_entries;
+    std::unordered_map<GLuint, size_t>      m_byTexture; // into m_entries
+    std::unordered_map<std::string, GLuint> m_byPath;    // managed and pinned
+    std::unordered_map<GLuint, size_t>      m_pinned;    // texture -> bytes
+
+    size_t   m_budget         = DEFAULT_BUDGET;
+    size_t   m_uploadBudget   = 4 * 1024 * 1024;
+    size_t   m_pinnedBytes    = 0;
+    size_t   m_requestedBytes = 0;
+    size_t   m_uploadedBytes  = 0;
+    size_t   m_evictions      = 0;
+    uint64_t m_frame          = 1;
+
+    // Bytes of the levels from first to the end of the chain
+    static size_t residentSize(const Entry &entry, uint32_t first);
+
+    void evict(Entry &entry, uint32_t level);
+    void uploadLevel(Entry &entry);
+};
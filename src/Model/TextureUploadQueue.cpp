@@ -0,0 +1,155 @@
+#include "TextureUploadQueue.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <vector>
+
+void TextureUploadQueue::push(GLuint texture, Image image) {
+    m_queuedBytes += image.size();
+
+    const GLenum format = image.format();
+    m_jobs.push_back({texture, std::move(image), format});
+}
+
+GLuint TextureUploadQueue::createPlaceholder() {
+    static constexpr std::array<unsigned char, 4> grey{128, 128, 128, 255};
+
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, grey.data());
+
+    return texture;
+}
+
+MemoryUsage TextureUploadQueue::getMemoryUsage() const {
+    MemoryUsage usage;
+    for (const auto &job : m_jobs) {
+        usage.cpuBytes += job.image.size();
+    }
+
+    // a buffer only grows past the budget for a single row wider than it, which isn't tracked
+    if (m_pixelBuffers[0] != 0) {
+        usage.bufferBytes = m_pixelBuffers.size() * m_budget;
+        usage.glObjects   = m_pixelBuffers.size();
+    }
+    return usage;
+}
+
+size_t TextureUploadQueue::process() {
+    if (m_jobs.empty()) {
+        return 0;
+    }
+
+    if (m_pixelBuffers[0] == 0) {
+        glGenBuffers(static_cast<GLsizei>(m_pixelBuffers.size()), m_pixelBuffers.data());
+    }
+
+    struct Chunk {
+        GLuint texture;
+        GLenum format;
+        int    width;
+        int    height;
+        int    firstRow;
+        int    rowCount;
+        size_t offset;
+    };
+
+    std::vector<Chunk> chunks;
+    size_t             used = 0;
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pixelBuffers[m_currentBuffer]);
+    m_currentBuffer = (m_currentBuffer + 1) % m_pixelBuffers.size();
+
+    // orphan the previous storage, the driver keeps it alive until the pending uploads from it are done
+    const size_t firstRowSize = m_jobs.front().image.rowSize();
+    const size_t bufferSize   = std::max(m_budget, firstRowSize);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(bufferSize), nullptr, GL_STREAM_DRAW);
+
+    auto *mapping = static_cast<unsigned char *>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER,
+                                                                  0,
+                                                                  static_cast<GLsizeiptr>(bufferSize),
+                                                                  GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    if (mapping == nullptr) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return 0;
+    }
+
+    for (auto &job : m_jobs) {
+        const size_t rowSize = job.image.rowSize();
+
+        // a single row always goes through, even when it is larger than the budget
+        size_t rows = (bufferSize - used) / rowSize;
+        rows        = std::min(rows, static_cast<size_t>(job.image.height - job.nextRow));
+
+        if (rows == 0) {
+            break;
+        }
+
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        std::memcpy(mapping + used, job.image.pixels.get() + job.nextRow * rowSize, rows * rowSize);
+
+        chunks.push_back(
+                {job.texture, job.format, job.image.width, job.image.height, job.nextRow, static_cast<int>(rows), used});
+
+        job.nextRow += static_cast<int>(rows);
+        used += rows * rowSize;
+    }
+
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    // rows are tightly packed in the buffer
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    for (const auto &chunk : chunks) {
+        glBindTexture(GL_TEXTURE_2D, chunk.texture);
+
+        // the first chunk replaces the placeholder with storage of the full size
+        if (chunk.firstRow == 0) {
+            glTexImage2D(GL_TEXTURE_2D,
+                         0,
+                         static_cast<GLint>(chunk.format),
+                         chunk.width,
+                         chunk.height,
+                         0,
+                         chunk.format,
+                         GL_UNSIGNED_BYTE,
+                         nullptr);
+        }
+
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast, performance-no-int-to-ptr)
+        const auto *offset = reinterpret_cast<const void *>(chunk.offset);
+        glTexSubImage2D(
+                GL_TEXTURE_2D, 0, 0, chunk.firstRow, chunk.width, chunk.rowCount, chunk.format, GL_UNSIGNED_BYTE, offset);
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    // finished images build their mip chain and free their pixels
+    while (!m_jobs.empty() && m_jobs.front().nextRow == m_jobs.front().image.height) {
+        glBindTexture(GL_TEXTURE_2D, m_jobs.front().texture);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+
+        m_jobs.pop_front();
+    }
+
+    m_queuedBytes -= used;
+    return used;
+}
+
+void TextureUploadQueue::deleteBuffers() {
+    if (m_pixelBuffers[0] != 0) {
+        glDeleteBuffers(static_cast<GLsizei>(m_pixelBuffers.size()), m_pixelBuffers.data());
+        m_pixelBuffers = {};
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <Utility/OpenGlHeaders.hpp>
+
+#include <array>
+#include <cstddef>
+#include <deque>
+
+#include <Utility/MemoryUsage.hpp>
+
+#include "Image.hpp"
+
+// Streams decoded images into existing textures through pixel buffer objects.
+//
+// Every call to process() uploads at most budget() bytes, split into whole rows, so a large texture is spread over
+// several frames instead of stalling one. Until its last row arrives a texture only samples its base level, the mip
+// chain is generated once the image is complete.
+class TextureUploadQueue {
+    public:
+    explicit TextureUploadQueue(size_t budgetBytes) : m_budget(budgetBytes) {}
+
+    // Queues the pixels of a texture that currently holds a placeholder
+    void push(GLuint texture, Image image);
+
+    // Uploads the next chunk, must be called on the context thread. Returns the number of bytes uploaded.
+    size_t process();
+
+    void deleteBuffers();
+
+    [[nodiscard]] size_t budget() const noexcept { return m_budget; }
+    [[nodiscard]] size_t queuedBytes() const noexcept { return m_queuedBytes; }
+    [[nodiscard]] size_t queuedTextures() const noexcept { return m_jobs.size(); }
+
+    // The queued images, which are freed once their last row is uploaded, and the pixel buffers
+    [[nodiscard]] MemoryUsage getMemoryUsage() const;
+
+    // 1x1 texture shown while the real pixels are streaming in
+    static GLuint createPlaceholder();
+
+    private:
+    struct Job {
+        GLuint texture;
+        Image  image;
+        GLenum format;
+        int    nextRow = 0;
+    };
+
+    std::deque<Job> m_jobs;
+    size_t          m_budget;
+    size_t          m_queuedBytes = 0;
+
+    // alternate between two buffers so the driver can still be reading last frame's chunk
+    std::array<GLuint, 2> m_pixelBuffers{};
+    size_t                m_currentBuffer = 0;
+};
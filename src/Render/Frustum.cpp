@@ -0,0 +1,39 @@
+#include "Frustum.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+BoundingSphere BoundingSphere::transformed(const glm::mat4 &transform) const {
+    const float scaleX = glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0]));
+    const float scaleY = glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1]));
+    const float scaleZ = glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2]));
+
+    return {glm::vec3(transform * glm::vec4(center, 1.0f)), radius * std::sqrt(std::max({scaleX, scaleY, scaleZ}))};
+}
+
+Frustum Frustum::fromMatrix(const glm::mat4 &viewProjection) {
+    // glm is column major, row i of the matrix is (m[0][i], m[1][i], m[2][i], m[3][i])
+    auto row = [&viewProjection](int i) {
+        return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    };
+
+    Frustum frustum{};
+    frustum.planes[LEFT_PLANE]   = row(3) + row(0);
+    frustum.planes[RIGHT_PLANE]  = row(3) - row(0);
+    frustum.planes[BOTTOM_PLANE] = row(3) + row(1);
+    frustum.planes[TOP_PLANE]    = row(3) - row(1);
+    frustum.planes[NEAR_PLANE]   = row(3) + row(2);
+    frustum.planes[FAR_PLANE]    = row(3) - row(2);
+
+    for (auto &plane : frustum.planes) {
+        plane = plane / glm::length(glm::vec3(plane));
+    }
+
+    return frustum;
+}
+
+bool Frustum::intersects(const BoundingSphere &sphere) const {
+    return std::ranges::all_of(planes, [&sphere](const glm::vec4 &plane) {
+        return glm::dot(glm::vec3(plane), sphere.center) + plane.w >= -sphere.radius;
+    });
+}
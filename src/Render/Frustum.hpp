@@ -0,0 +1,26 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <array>
+
+struct BoundingSphere {
+    glm::vec3 center{0.0f};
+    float     radius = 0.0f;
+
+    // The radius grows with the largest axis scale of the transform, so the sphere stays conservative
+    [[nodiscard]] BoundingSphere transformed(const glm::mat4 &transform) const;
+};
+
+// Six planes pointing inwards, (normal, distance) with unit length normals
+struct Frustum {
+    // suffixed, windows.h defines NEAR and FAR
+    enum Plane { LEFT_PLANE, RIGHT_PLANE, BOTTOM_PLANE, TOP_PLANE, NEAR_PLANE, FAR_PLANE, PLANE_COUNT };
+
+    std::array<glm::vec4, PLANE_COUNT> planes;
+
+    // Gribb-Hartmann extraction, viewProjection is projection * view
+    static Frustum fromMatrix(const glm::mat4 &viewProjection);
+
+    [[nodiscard]] bool intersects(const BoundingSphere &sphere) const;
+};
@@ -0,0 +1,155 @@
+#include "FrustumCuller.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#include <Utility/JobSystem.hpp>
+
+#if defined(__AVX__) || defined(__SSE__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+void FrustumCuller::add(const BoundingSphere &sphere) {
+    m_centerX.push_back(sphere.center.x);
+    m_centerY.push_back(sphere.center.y);
+    m_centerZ.push_back(sphere.center.z);
+    m_radius.push_back(sphere.radius);
+}
+
+void FrustumCuller::reserve(size_t count) {
+    m_centerX.reserve(count);
+    m_centerY.reserve(count);
+    m_centerZ.reserve(count);
+    m_radius.reserve(count);
+}
+
+void FrustumCuller::clear() {
+    m_centerX.clear();
+    m_centerY.clear();
+    m_centerZ.clear();
+    m_radius.clear();
+}
+
+void FrustumCuller::resize(size_t count) {
+    m_centerX.resize(count);
+    m_centerY.resize(count);
+    m_centerZ.resize(count);
+    m_radius.resize(count);
+}
+
+void FrustumCuller::set(size_t index, const BoundingSphere &sphere) {
+    m_centerX[index] = sphere.center.x;
+    m_centerY[index] = sphere.center.y;
+    m_centerZ[index] = sphere.center.z;
+    m_radius[index]  = sphere.radius;
+}
+
+MemoryUsage FrustumCuller::getMemoryUsage() const {
+    MemoryUsage usage;
+    usage.cpuBytes = (m_centerX.capacity() + m_centerY.capacity() + m_centerZ.capacity() + m_radius.capacity()) *
+                     sizeof(float);
+    for (const auto &chunk : m_chunkVisible) {
+        usage.cpuBytes += chunk.capacity() * sizeof(uint32_t);
+    }
+    return usage;
+}
+
+void FrustumCuller::cull(const Frustum &frustum, std::vector<uint32_t> &visible) {
+    const auto   start         = std::chrono::steady_clock::now();
+    const size_t count         = size();
+    const size_t visibleBefore = visible.size();
+
+    if (count < 2 * CULL_CHUNK) {
+        cullRange(frustum, 0, count, visible);
+    } else {
+        // every chunk collects its own indices, appending them in chunk order keeps them ascending
+        const size_t chunks = (count + CULL_CHUNK - 1) / CULL_CHUNK;
+        m_chunkVisible.resize(chunks);
+
+        JobSystem::shared().parallelFor(chunks, [&](size_t chunk) {
+            m_chunkVisible[chunk].clear();
+            cullRange(frustum, chunk * CULL_CHUNK, std::min(count, (chunk + 1) * CULL_CHUNK), m_chunkVisible[chunk]);
+        });
+
+        for (size_t chunk = 0; chunk < chunks; chunk++) {
+            visible.insert(visible.end(), m_chunkVisible[chunk].begin(), m_chunkVisible[chunk].end());
+        }
+    }
+
+    m_stats.tested       = count;
+    m_stats.visible      = visible.size() - visibleBefore;
+    m_stats.culled       = count - m_stats.visible;
+    m_stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void FrustumCuller::cullRange(const Frustum &frustum, size_t first, size_t last, std::vector<uint32_t> &visible) const {
+    size_t i = first;
+
+#if defined(__AVX__)
+    // sphere i is outside when dot(normal, center) + distance < -radius for any plane
+    for (; i + 8 <= last; i += 8) {
+        const __m256 x      = _mm256_loadu_ps(&m_centerX[i]);
+        const __m256 y      = _mm256_loadu_ps(&m_centerY[i]);
+        const __m256 z      = _mm256_loadu_ps(&m_centerZ[i]);
+        const __m256 radius = _mm256_loadu_ps(&m_radius[i]);
+        const __m256 bound  = _mm256_sub_ps(_mm256_setzero_ps(), radius);
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+        for (const auto &plane : frustum.planes) {
+            __m256 distance = _mm256_mul_ps(_mm256_set1_ps(plane.x), x);
+            distance        = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane.y), y));
+            distance        = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane.z), z));
+            distance        = _mm256_add_ps(distance, _mm256_set1_ps(plane.w));
+
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, bound, _CMP_GE_OQ));
+        }
+
+        const auto mask = static_cast<unsigned int>(_mm256_movemask_ps(inside));
+        for (unsigned int lane = 0; lane < 8; lane++) {
+            if ((mask >> lane & 1U) != 0) {
+                visible.push_back(static_cast<uint32_t>(i + lane));
+            }
+        }
+    }
+#elif defined(__SSE__) || defined(_M_X64)
+    for (; i + 4 <= last; i += 4) {
+        const __m128 x      = _mm_loadu_ps(&m_centerX[i]);
+        const __m128 y      = _mm_loadu_ps(&m_centerY[i]);
+        const __m128 z      = _mm_loadu_ps(&m_centerZ[i]);
+        const __m128 radius = _mm_loadu_ps(&m_radius[i]);
+        const __m128 bound  = _mm_sub_ps(_mm_setzero_ps(), radius);
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+        for (const auto &plane : frustum.planes) {
+            __m128 distance = _mm_mul_ps(_mm_set1_ps(plane.x), x);
+            distance        = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.y), y));
+            distance        = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.z), z));
+            distance        = _mm_add_ps(distance, _mm_set1_ps(plane.w));
+
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, bound));
+        }
+
+        const auto mask = static_cast<unsigned int>(_mm_movemask_ps(inside));
+        for (unsigned int lane = 0; lane < 4; lane++) {
+            if ((mask >> lane & 1U) != 0) {
+                visible.push_back(static_cast<uint32_t>(i + lane));
+            }
+        }
+    }
+#endif
+
+    cullScalar(frustum, i, last, visible);
+}
+
+void FrustumCuller::cullScalar(const Frustum         &frustum,
+                               size_t                 first,
+                               size_t                 last,
+                               std::vector<uint32_t> &visible) const {
+    for (size_t i = first; i < last; i++) {
+        if (frustum.intersects({{m_centerX[i], m_centerY[i], m_centerZ[i]}, m_radius[i]})) {
+            visible.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <Utility/MemoryUsage.hpp>
+
+#include "Frustum.hpp"
+
+// Tests a batch of bounding spheres against a frustum.
+//
+// The spheres are kept as a structure of arrays so the test runs on 8 spheres at a time with AVX, 4 with SSE, and
+// falls back to scalar code for the tail and on other targets. Large batches are split into chunks tested on the
+// JobSystem.
+class FrustumCuller {
+    public:
+    struct Stats {
+        size_t tested       = 0;
+        size_t visible      = 0;
+        size_t culled       = 0;
+        double milliseconds = 0.0;
+    };
+
+    // spheres per job, batches smaller than two chunks are tested on the calling thread
+    static constexpr size_t CULL_CHUNK = 16384;
+
+    void add(const BoundingSphere &sphere);
+    void reserve(size_t count);
+    void clear();
+
+    // Grows or shrinks the batch, spheres added this way are filled in with set(), which may run on several threads
+    // for different indices
+    void resize(size_t count);
+    void set(size_t index, const BoundingSphere &sphere);
+
+    // Appends the indices of the visible spheres, in the order they were added
+    void cull(const Frustum &frustum, std::vector<uint32_t> &visible);
+
+    [[nodiscard]] size_t       size() const noexcept { return m_radius.size(); }
+    [[nodiscard]] const Stats &getStats() const noexcept { return m_stats; }
+    [[nodiscard]] MemoryUsage  getMemoryUsage() const;
+
+    private:
+    std::vector<float> m_centerX;
+    std::vector<float> m_centerY;
+    std::vector<float> m_centerZ;
+    std::vector<float> m_radius;
+
+    std::vector<std::vector<uint32_t>> m_chunkVisible; // per chunk of a threaded cull
+
+    Stats m_stats;
+
+    // tests spheres [first, last), 8 or 4 at a time
+    void cullRange(const Frustum &frustum, size_t first, size_t last, std::vector<uint32_t> &visible) const;
+
+    // tests spheres [first, last) one at a time
+    void cullScalar(const Frustum &frustum, size_t first, size_t last, std::vector<uint32_t> &visible) const;
+};
@@ -0,0 +1,40 @@
+#include "InstanceBuffer.hpp"
+
+#include <cstdint>
+
+static_assert(sizeof(InstanceBuffer::Instance) == 128, "InstanceBuffer::Instance must not contain padding");
+
+InstanceBuffer::Instance InstanceBuffer::Instance::create(const glm::mat4 &model, const glm::vec4 &tint) {
+    const glm::mat3 normal = glm::transpose(glm::inverse(glm::mat3(model)));
+
+    return {model, {glm::vec4(normal[0], 0.0f), glm::vec4(normal[1], 0.0f), glm::vec4(normal[2], 0.0f)}, tint};
+}
+
+void InstanceBuffer::upload(std::span<const Instance> instances) {
+    m_stream.beginFrame();
+    m_offset = m_stream.write(instances);
+}
+
+void InstanceBuffer::bindAttributes(size_t firstInstance) const {
+    glBindBuffer(GL_ARRAY_BUFFER, m_stream.getBuffer());
+
+    const size_t base   = m_offset + firstInstance * sizeof(Instance);
+    const auto   stride = static_cast<GLsizei>(sizeof(Instance));
+
+    auto pointer = [&](GLuint location, GLint size, size_t offset) {
+        glEnableVertexAttribArray(location);
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast, performance-no-int-to-ptr)
+        glVertexAttribPointer(location, size, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void *>(base + offset));
+        glVertexAttribDivisor(location, 1);
+    };
+
+    for (GLuint column = 0; column < 4; column++) {
+        pointer(MODEL_LOCATION + column, 4, offsetof(Instance, model) + column * sizeof(glm::vec4));
+    }
+    for (GLuint column = 0; column < 3; column++) {
+        pointer(NORMAL_MATRIX_LOCATION + column, 3, offsetof(Instance, normalMatrix) + column * sizeof(glm::vec4));
+    }
+    pointer(TINT_LOCATION, 4, offsetof(Instance, tint));
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
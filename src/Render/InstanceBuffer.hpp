@@ -0,0 +1,52 @@
+#pragma once
+
+#include <Utility/OpenGlHeaders.hpp>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <span>
+
+#include <Utility/MemoryUsage.hpp>
+
+#include "StreamBuffer.hpp"
+
+// Per-instance vertex data of the instanced draws, streamed once per frame through a StreamBuffer.
+//
+// Matches the attributes declared in the vertex shader:
+//     layout(location = 3) in mat4 aModel;         // locations 3 to 6
+//     layout(location = 7) in mat3 aNormalMatrix;  // locations 7 to 9
+//     layout(location = 10) in vec4 aTint;
+class InstanceBuffer {
+    public:
+    struct Instance {
+        glm::mat4                model;
+        std::array<glm::vec4, 3> normalMatrix; // mat3 columns padded to vec4
+        glm::vec4                tint;
+
+        // Precomputes the normal matrix, so the shader doesn't invert the model matrix per vertex
+        static Instance create(const glm::mat4 &model, const glm::vec4 &tint);
+    };
+
+    static constexpr GLuint MODEL_LOCATION         = 3;
+    static constexpr GLuint NORMAL_MATRIX_LOCATION = 7;
+    static constexpr GLuint TINT_LOCATION          = 10;
+
+    InstanceBuffer() : m_stream(GL_ARRAY_BUFFER, 0) {}
+
+    // Writes the instances of a frame into the next region of the stream
+    void upload(std::span<const Instance> instances);
+
+    // Points the instance attributes of the bound vertex array at the instances starting at firstInstance. GL 3.3 has
+    // no base instance, so every instanced batch calls this before drawing.
+    void bindAttributes(size_t firstInstance) const;
+
+    void deleteBuffer() { m_stream.deleteBuffer(); }
+
+    [[nodiscard]] const StreamBuffer::Stats &getStreamStats() const noexcept { return m_stream.getStats(); }
+    [[nodiscard]] MemoryUsage                getMemoryUsage() const { return m_stream.getMemoryUsage(); }
+
+    private:
+    StreamBuffer m_stream;
+    size_t       m_offset = 0; // of the instances of the current frame in the stream
+};
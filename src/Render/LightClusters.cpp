@@ -0,0 +1,351 @@
+#include "LightClusters.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#include <Utility/JobSystem.hpp>
+#include <Utility/Profiler.hpp>
+
+#if defined(__AVX__) || defined(__SSE__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+namespace {
+// Smallest sphere around the lit volume, the cone of a spot light or the sphere of a point light
+glm::vec4 boundingSphere(const LightClusters::Light &light) {
+    if (light.outerAngle <= 0.0f) {
+        return {light.position, light.range};
+    }
+
+    // wide cones are bounded by the circle at their base, narrow ones by the sphere through their apex
+    const float cosine = std::cos(light.outerAngle);
+    if (light.outerAngle > glm::radians(45.0f)) {
+        return {light.position + light.direction * cosine * light.range, std::sin(light.outerAngle) * light.range};
+    }
+
+    const float radius = light.range / (2.0f * cosine);
+    return {light.position + light.direction * radius, radius};
+}
+
+#if defined(__AVX__)
+// Distance of center to the ranges [min, max] of 8 froxels along one axis, 0 inside
+__m256 axisDistance(const float *min, const float *max, __m256 center) {
+    const __m256 below = _mm256_sub_ps(_mm256_loadu_ps(min), center);
+    const __m256 above = _mm256_sub_ps(center, _mm256_loadu_ps(max));
+    return _mm256_max_ps(_mm256_max_ps(below, above), _mm256_setzero_ps());
+}
+#elif defined(__SSE__) || defined(_M_X64)
+__m128 axisDistance(const float *min, const float *max, __m128 center) {
+    const __m128 below = _mm_sub_ps(_mm_loadu_ps(min), center);
+    const __m128 above = _mm_sub_ps(center, _mm_loadu_ps(max));
+    return _mm_max_ps(_mm_max_ps(below, above), _mm_setzero_ps());
+}
+#endif
+} // namespace
+
+LightClusters::LightClusters()
+        : m_minX(FROXEL_COUNT), m_minY(FROXEL_COUNT), m_minZ(FROXEL_COUNT), m_maxX(FROXEL_COUNT),
+          m_maxY(FROXEL_COUNT), m_maxZ(FROXEL_COUNT), m_counts(FROXEL_COUNT),
+          m_froxelLists(size_t{FROXEL_COUNT} * MAX_LIGHTS_PER_FROXEL), m_ranges(FROXEL_COUNT) {
+    GLint maxTexels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    m_maxIndices = static_cast<size_t>(std::max(maxTexels, 0));
+
+    glGenBuffers(static_cast<GLsizei>(m_buffers.size()), m_buffers.data());
+    glGenTextures(static_cast<GLsizei>(m_textures.size()), m_textures.data());
+
+    constexpr std::array<GLenum, 3> formats{GL_RGBA32F, GL_RG32UI, GL_R32UI};
+    for (size_t i = 0; i < m_buffers.size(); i++) {
+        glBindBuffer(GL_TEXTURE_BUFFER, m_buffers.at(i));
+        glBindTexture(GL_TEXTURE_BUFFER, m_textures.at(i));
+        glTexBuffer(GL_TEXTURE_BUFFER, formats.at(i), m_buffers.at(i));
+    }
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void LightClusters::attach(const Shader &shader) {
+    shader.use();
+    shader.setInt("clusterLightData", LIGHT_DATA_UNIT);
+    shader.setInt("clusterRanges", RANGES_UNIT);
+    shader.setInt("clusterLightIndices", INDICES_UNIT);
+}
+
+void LightClusters::buildFroxels(const glm::mat4 &projection, float near, float far) {
+    m_projection = projection;
+    m_near       = near;
+    m_far        = far;
+
+    // slice k starts where log(depth) * scale + bias reaches k, the first one starts at the near plane
+    const float first = std::max(FIRST_SLICE_DEPTH, near);
+    m_sliceScale      = static_cast<float>(GRID_Z - 1) / std::log(far / first);
+    m_sliceBias       = 1.0f - std::log(first) * m_sliceScale;
+
+    std::array<float, GRID_Z + 1> depths{};
+    depths.front() = near;
+    depths.back()  = far;
+    for (uint32_t k = 1; k < GRID_Z; k++) {
+        depths.at(k) = std::exp((static_cast<float>(k) - m_sliceBias) / m_sliceScale);
+    }
+
+    const glm::mat4 inverse = glm::inverse(projection);
+
+    // rays through the tile corners, scaled to a view depth of 1
+    std::array<glm::vec3, (GRID_X + 1) * (GRID_Y + 1)> rays{};
+    for (uint32_t y = 0; y <= GRID_Y; y++) {
+        for (uint32_t x = 0; x <= GRID_X; x++) {
+            const glm::vec4 ndc(2.0f * static_cast<float>(x) / GRID_X - 1.0f,
+                                2.0f * static_cast<float>(y) / GRID_Y - 1.0f,
+                                -1.0f,
+                                1.0f);
+            const glm::vec4 point         = inverse * ndc;
+            rays.at(y * (GRID_X + 1) + x) = glm::vec3(point) / (-point.z);
+        }
+    }
+
+    // a froxel is convex, the bounds of its 8 corners bound all of it
+    for (uint32_t z = 0; z < GRID_Z; z++) {
+        for (uint32_t y = 0; y < GRID_Y; y++) {
+            for (uint32_t x = 0; x < GRID_X; x++) {
+                glm::vec3 min(std::numeric_limits<float>::max());
+                glm::vec3 max(std::numeric_limits<float>::lowest());
+                for (uint32_t corner = 0; corner < 8; corner++) {
+                    const glm::vec3 &ray   = rays.at((y + (corner >> 1 & 1)) * (GRID_X + 1) + x + (corner & 1));
+                    const glm::vec3  point = ray * depths.at(z + (corner >> 2));
+                    min                    = glm::min(min, point);
+                    max                    = glm::max(max, point);
+                }
+
+                const size_t froxel = z * SLICE_SIZE + y * GRID_X + x;
+                m_minX[froxel]      = min.x;
+                m_minY[froxel]      = min.y;
+                m_minZ[froxel]      = min.z;
+                m_maxX[froxel]      = max.x;
+                m_maxY[froxel]      = max.y;
+                m_maxZ[froxel]      = max.z;
+            }
+        }
+    }
+}
+
+uint32_t LightClusters::sliceOf(float depth) const {
+    if (depth <= 0.0f) {
+        return 0;
+    }
+    const float slice = std::floor(std::log(depth) * m_sliceScale + m_sliceBias);
+    return static_cast<uint32_t>(std::clamp(slice, 0.0f, static_cast<float>(GRID_Z - 1)));
+}
+
+void LightClusters::build(const glm::mat4 &view, const glm::mat4 &projection, float near, float far) {
+    PROFILE_ZONE("LightClusters::build");
+    const auto start = std::chrono::steady_clock::now();
+
+    if (projection != m_projection || near != m_near || far != m_far) {
+        buildFroxels(projection, near, far);
+    }
+
+    for (auto &lights : m_sliceLights) {
+        lights.clear();
+    }
+
+    m_spheres.resize(m_lights.size());
+    m_lightData.resize(m_lights.size() * TEXELS_PER_LIGHT);
+
+    for (size_t i = 0; i < m_lights.size(); i++) {
+        const Light &light = m_lights[i];
+
+        // the shader lights in world space, with the spot cone as a scale and offset of the cosine to the axis
+        float spotScale  = 0.0f;
+        float spotOffset = 1.0f;
+        if (light.outerAngle > 0.0f) {
+            const float cosOuter = std::cos(light.outerAngle);
+            const float cosInner = std::cos(std::min(light.innerAngle, light.outerAngle));
+            spotScale            = 1.0f / std::max(cosInner - cosOuter, 1e-4f);
+            spotOffset           = -cosOuter * spotScale;
+        }
+        m_lightData[i * TEXELS_PER_LIGHT]     = glm::vec4(light.position, light.range);
+        m_lightData[i * TEXELS_PER_LIGHT + 1] = glm::vec4(light.color, spotScale);
+        m_lightData[i * TEXELS_PER_LIGHT + 2] = glm::vec4(glm::normalize(light.direction), spotOffset);
+
+        const glm::vec4 sphere = boundingSphere(light);
+        const glm::vec3 center = view * glm::vec4(glm::vec3(sphere), 1.0f);
+        m_spheres[i]           = glm::vec4(center, sphere.w);
+
+        // behind the camera or past the far plane
+        const float depth = -center.z;
+        if (depth + sphere.w <= 0.0f || depth - sphere.w >= far) {
+            continue;
+        }
+
+        const uint32_t last = sliceOf(depth + sphere.w);
+        for (uint32_t slice = sliceOf(depth - sphere.w); slice <= last; slice++) {
+            m_sliceLights.at(slice).push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    std::fill(m_counts.begin(), m_counts.end(), 0);
+
+    // every slice owns its froxels, the threads never write to the same list
+    if (m_threaded) {
+        JobSystem::shared().parallelFor(GRID_Z, [this](size_t slice) { binSlice(static_cast<uint32_t>(slice)); });
+    } else {
+        for (uint32_t slice = 0; slice < GRID_Z; slice++) {
+            binSlice(slice);
+        }
+    }
+
+    m_stats = {};
+    for (const size_t dropped : m_sliceDropped) {
+        m_stats.dropped += dropped;
+    }
+
+    // one index list after the other, in froxel order
+    m_indices.clear();
+    for (size_t froxel = 0; froxel < FROXEL_COUNT; froxel++) {
+        const size_t room  = m_maxIndices - std::min(m_indices.size(), m_maxIndices);
+        const size_t count = std::min<size_t>(m_counts[froxel], room);
+        const auto   list  = m_froxelLists.begin() + static_cast<std::ptrdiff_t>(froxel * MAX_LIGHTS_PER_FROXEL);
+
+        m_ranges[froxel] = glm::uvec2(m_indices.size(), count);
+        m_indices.insert(m_indices.end(), list, list + static_cast<std::ptrdiff_t>(count));
+
+        m_stats.dropped += m_counts[froxel] - count;
+        m_stats.occupied += count != 0 ? 1 : 0;
+        m_stats.maxPerFroxel = std::max(m_stats.maxPerFroxel, count);
+    }
+
+    m_stats.lights       = m_lights.size();
+    m_stats.references   = m_indices.size();
+    m_stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void LightClusters::binSlice(uint32_t slice) {
+    const size_t first   = size_t{slice} * SLICE_SIZE;
+    const size_t end     = first + SLICE_SIZE;
+    size_t       dropped = 0;
+
+    const auto append = [&](size_t froxel, uint32_t light) {
+        uint32_t &count = m_counts[froxel];
+        if (count < MAX_LIGHTS_PER_FROXEL) {
+            m_froxelLists[froxel * MAX_LIGHTS_PER_FROXEL + count++] = light;
+        } else {
+            dropped++;
+        }
+    };
+
+    for (const uint32_t light : m_sliceLights.at(slice)) {
+        const glm::vec4 &sphere  = m_spheres[light];
+        const float      radius2 = sphere.w * sphere.w;
+
+        size_t i = first;
+
+#if defined(__AVX__)
+        // the sphere touches froxel i when the squared distance from its center to the bounds is at most radius^2
+        const __m256 x     = _mm256_set1_ps(sphere.x);
+        const __m256 y     = _mm256_set1_ps(sphere.y);
+        const __m256 z     = _mm256_set1_ps(sphere.z);
+        const __m256 bound = _mm256_set1_ps(radius2);
+
+        for (; i + 8 <= end; i += 8) {
+            const __m256 dx = axisDistance(&m_minX[i], &m_maxX[i], x);
+            const __m256 dy = axisDistance(&m_minY[i], &m_maxY[i], y);
+            const __m256 dz = axisDistance(&m_minZ[i], &m_maxZ[i], z);
+
+            __m256 distance = _mm256_mul_ps(dx, dx);
+            distance        = _mm256_add_ps(distance, _mm256_mul_ps(dy, dy));
+            distance        = _mm256_add_ps(distance, _mm256_mul_ps(dz, dz));
+
+            const auto mask = static_cast<unsigned int>(_mm256_movemask_ps(_mm256_cmp_ps(distance, bound, _CMP_LE_OQ)));
+            for (unsigned int lane = 0; lane < 8; lane++) {
+                if ((mask >> lane & 1U) != 0) {
+                    append(i + lane, light);
+                }
+            }
+        }
+#elif defined(__SSE__) || defined(_M_X64)
+        const __m128 x     = _mm_set1_ps(sphere.x);
+        const __m128 y     = _mm_set1_ps(sphere.y);
+        const __m128 z     = _mm_set1_ps(sphere.z);
+        const __m128 bound = _mm_set1_ps(radius2);
+
+        for (; i + 4 <= end; i += 4) {
+            const __m128 dx = axisDistance(&m_minX[i], &m_maxX[i], x);
+            const __m128 dy = axisDistance(&m_minY[i], &m_maxY[i], y);
+            const __m128 dz = axisDistance(&m_minZ[i], &m_maxZ[i], z);
+
+            __m128 distance = _mm_mul_ps(dx, dx);
+            distance        = _mm_add_ps(distance, _mm_mul_ps(dy, dy));
+            distance        = _mm_add_ps(distance, _mm_mul_ps(dz, dz));
+
+            const auto mask = static_cast<unsigned int>(_mm_movemask_ps(_mm_cmple_ps(distance, bound)));
+            for (unsigned int lane = 0; lane < 4; lane++) {
+                if ((mask >> lane & 1U) != 0) {
+                    append(i + lane, light);
+                }
+            }
+        }
+#endif
+
+        for (; i < end; i++) {
+            const float dx = std::max({m_minX[i] - sphere.x, sphere.x - m_maxX[i], 0.0f});
+            const float dy = std::max({m_minY[i] - sphere.y, sphere.y - m_maxY[i], 0.0f});
+            const float dz = std::max({m_minZ[i] - sphere.z, sphere.z - m_maxZ[i], 0.0f});
+            if (dx * dx + dy * dy + dz * dz <= radius2) {
+                append(i, light);
+            }
+        }
+    }
+
+    m_sliceDropped.at(slice) = dropped;
+}
+
+void LightClusters::upload() const {
+    PROFILE_ZONE("LightClusters::upload");
+
+    const auto stream = [](GLuint buffer, const void *data, size_t size) {
+        glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+        glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(size), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, static_cast<GLsizeiptr>(size), data);
+    };
+
+    stream(m_buffers[0], m_lightData.data(), m_lightData.size() * sizeof(glm::vec4));
+    stream(m_buffers[1], m_ranges.data(), m_ranges.size() * sizeof(glm::uvec2));
+    stream(m_buffers[2], m_indices.data(), m_indices.size() * sizeof(uint32_t));
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    constexpr std::array<int, 3> units{LIGHT_DATA_UNIT, RANGES_UNIT, INDICES_UNIT};
+    for (size_t i = 0; i < units.size(); i++) {
+        glActiveTexture(GL_TEXTURE0 + units.at(i));
+        glBindTexture(GL_TEXTURE_BUFFER, m_textures.at(i));
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+glm::vec4 LightClusters::getShaderParameters(int width, int height) const {
+    return {static_cast<float>(width) / GRID_X, static_cast<float>(height) / GRID_Y, m_sliceScale, m_sliceBias};
+}
+
+MemoryUsage LightClusters::getMemoryUsage() const {
+    MemoryUsage usage;
+    usage.bufferBytes = m_lightData.size() * sizeof(glm::vec4) + m_ranges.size() * sizeof(glm::uvec2) +
+                        m_indices.size() * sizeof(uint32_t);
+    usage.glObjects   = m_buffers.size() + m_textures.size();
+
+    usage.cpuBytes = m_lights.capacity() * sizeof(Light) + m_ranges.capacity() * sizeof(glm::uvec2) +
+                     (m_spheres.capacity() + m_lightData.capacity()) * sizeof(glm::vec4) +
+                     (m_counts.capacity() + m_froxelLists.capacity() + m_indices.capacity()) * sizeof(uint32_t);
+    for (const auto *bounds : {&m_minX, &m_minY, &m_minZ, &m_maxX, &m_maxY, &m_maxZ}) {
+        usage.cpuBytes += bounds->capacity() * sizeof(float);
+    }
+    for (const auto &lights : m_sliceLights) {
+        usage.cpuBytes += lights.capacity() * sizeof(uint32_t);
+    }
+    return usage;
+}
+
+void LightClusters::deleteBuffers() const {
+    glDeleteTextures(static_cast<GLsizei>(m_textures.size()), m_textures.data());
+    glDeleteBuffers(static_cast<GLsizei>(m_buffers.size()), m_buffers.data());
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <Utility/OpenGlHeaders.hpp>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <Shader.hpp>
+#include <Utility/MemoryUsage.hpp>
+
+// Clustered forward lighting for many point and spot lights.
+//
+// The view frustum is split into a grid of froxels, screen tiles along x and y and exponential depth slices along z.
+// build() bins the bounding sphere of every light into the froxels it touches and packs one light index list per
+// froxel, upload() streams them to three texture buffers, and the fragment shader only loops over the list of the
+// froxel it lies in. Every depth slice is binned on its own thread, testing 8 froxels at a time with AVX.
+//
+// Matches the samplers and the grid declared in the fragment shader:
+//     uniform samplerBuffer clusterLightData;      // 3 texels per light, see getShaderParameters for the rest
+//     uniform usamplerBuffer clusterRanges;        // first index and light count per froxel
+//     uniform usamplerBuffer clusterLightIndices;
+class LightClusters {
+    public:
+    struct Light {
+        glm::vec3 position;
+        float     range; // the light fades out to nothing at this distance
+        glm::vec3 color;
+        glm::vec3 direction{0.0f, 0.0f, -1.0f}; // spot lights only
+
+        // Half angles of the cone in radians, the light fades between them. An outer angle of 0 makes a point light.
+        float innerAngle = 0.0f;
+        float outerAngle = 0.0f;
+    };
+
+    struct Stats {
+        size_t lights       = 0;
+        size_t references   = 0; // entries of all the lists
+        size_t occupied     = 0; // froxels with at least one light
+        size_t maxPerFroxel = 0;
+        size_t dropped      = 0; // references that didn't fit in MAX_LIGHTS_PER_FROXEL
+        double milliseconds = 0.0;
+    };
+
+    static constexpr uint32_t GRID_X       = 16;
+    static constexpr uint32_t GRID_Y       = 9;
+    static constexpr uint32_t GRID_Z       = 24;
+    static constexpr uint32_t SLICE_SIZE   = GRID_X * GRID_Y;
+    static constexpr uint32_t FROXEL_COUNT = SLICE_SIZE * GRID_Z;
+
+    static constexpr uint32_t MAX_LIGHTS_PER_FROXEL = 256;
+
+    // The first slice covers everything up to this depth, the others are spread exponentially up to the far plane
+    static constexpr float FIRST_SLICE_DEPTH = 1.0f;
+
+    // Texture units of the light buffers, after the material maps
+    static constexpr int LIGHT_DATA_UNIT  = 3;
+    static constexpr int RANGES_UNIT      = 4;
+    static constexpr int INDICES_UNIT     = 5;
+    static constexpr int TEXELS_PER_LIGHT = 3;
+
+    LightClusters();
+
+    // Points the program's samplers at the light buffer units, the program must be in use
+    static void attach(const Shader &shader);
+
+    [[nodiscard]] std::vector<Light>       &getLights() noexcept { return m_lights; }
+    [[nodiscard]] const std::vector<Light> &getLights() const noexcept { return m_lights; }
+
+    // Bins on the shared JobSystem, or on the calling thread only
+    void setThreaded(bool threaded) noexcept { m_threaded = threaded; }
+
+    // Bins the lights for a camera, doesn't touch the GL context
+    void build(const glm::mat4 &view, const glm::mat4 &projection, float near, float far);
+
+    // Streams the lists of the last build and binds the buffers to their units
+    void upload() const;
+
+    // Tile size in pixels for a viewport of width x height, then the scale and bias that map log(view depth) to the
+    // depth slice. Goes into FrameUniforms::Data::clusterParameters.
+    [[nodiscard]] glm::vec4 getShaderParameters(int width, int height) const;
+
+    [[nodiscard]] const Stats &getStats() const noexcept { return m_stats; }
+
+    // The froxel bounds and lists on the CPU, the buffers as large as the last upload made them
+    [[nodiscard]] MemoryUsage getMemoryUsage() const;
+
+    void deleteBuffers() const;
+
+    private:
+    std::vector<Light> m_lights;
+    bool               m_threaded = true;
+
+    // view space bounds of every froxel, rebuilt when the projection changes
+    std::vector<float> m_minX;
+    std::vector<float> m_minY;
+    std::vector<float> m_minZ;
+    std::vector<float> m_maxX;
+    std::vector<float> m_maxY;
+    std::vector<float> m_maxZ;
+    glm::mat4          m_projection{0.0f};
+    float              m_near       = 0.0f;
+    float              m_far        = 0.0f;
+    float              m_sliceScale = 0.0f;
+    float              m_sliceBias  = 0.0f;
+
+    // view space bounding spheres of the lights and the lights reaching into every slice
+    std::vector<glm::vec4>                    m_spheres;
+    std::array<std::vector<uint32_t>, GRID_Z> m_sliceLights;
+    std::array<size_t, GRID_Z>                m_sliceDropped{};
+    std::vector<uint32_t>                     m_counts;      // per froxel
+    std::vector<uint32_t>                     m_froxelLists; // MAX_LIGHTS_PER_FROXEL entries per froxel
+
+    // what upload() streams
+    std::vector<glm::vec4>  m_lightData;
+    std::vector<glm::uvec2> m_ranges;
+    std::vector<uint32_t>   m_indices;
+    size_t                  m_maxIndices = 0; // texels a buffer texture can address
+
+    std::array<GLuint, 3> m_buffers{};
+    std::array<GLuint, 3> m_textures{};
+
+    Stats m_stats;
+
+    void buildFroxels(const glm::mat4 &projection, float near, float far);
+
+    // Slice of a view depth, the same mapping as the fragment shader
+    [[nodiscard]] uint32_t sliceOf(float depth) const;
+
+    // Appends the lights of m_sliceLights[slice] to the lists of the froxels their sphere touches
+    void binSlice(uint32_t slice);
+};
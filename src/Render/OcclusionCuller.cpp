@@ -0,0 +1,360 @@
+#include "OcclusionCuller.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#include <Utility/JobSystem.hpp>
+#include <Utility/Profiler.hpp>
+
+#if defined(__AVX__) || defined(__SSE__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+static_assert(OcclusionCuller::WIDTH % OcclusionCuller::TILE_WIDTH == 0 &&
+                      OcclusionCuller::HEIGHT % OcclusionCuller::TILE_HEIGHT == 0,
+              "OcclusionCuller tiles must cover the depth buffer");
+static_assert(OcclusionCuller::TILE_WIDTH % 8 == 0, "OcclusionCuller spans are 8 pixels wide");
+static_assert((OcclusionCuller::WIDTH >> (OcclusionCuller::LEVEL_COUNT - 1)) == 1,
+              "The last OcclusionCuller level must be a single texel");
+
+namespace {
+// Spheres tested per job
+constexpr size_t CULL_CHUNK = 256;
+} // namespace
+
+OcclusionCuller::OcclusionCuller() {
+    for (int level = 0; level < LEVEL_COUNT; level++) {
+        m_levels.at(level).resize(static_cast<size_t>(levelWidth(level)) * static_cast<size_t>(levelHeight(level)));
+    }
+}
+
+void OcclusionCuller::begin(const glm::mat4 &viewProjection) {
+    m_viewProjection = viewProjection;
+    m_occluders.clear();
+}
+
+void OcclusionCuller::addOccluder(const Mesh &mesh, const glm::mat4 &transform) {
+    if (!mesh.getOccluderIndices().empty()) {
+        m_occluders.push_back({&mesh, m_viewProjection * transform});
+    }
+}
+
+MemoryUsage OcclusionCuller::getMemoryUsage() const {
+    MemoryUsage usage;
+    usage.cpuBytes = m_occluders.capacity() * sizeof(Occluder) + m_occludedFlags.capacity() +
+                     m_triangles.capacity() * sizeof(std::vector<Triangle>);
+    for (const auto &triangles : m_triangles) {
+        usage.cpuBytes += triangles.capacity() * sizeof(Triangle);
+    }
+    for (const auto &level : m_levels) {
+        usage.cpuBytes += level.capacity() * sizeof(float);
+    }
+    return usage;
+}
+
+void OcclusionCuller::render() {
+    PROFILE_ZONE("OcclusionCuller::render");
+    const auto start = std::chrono::steady_clock::now();
+
+    if (m_triangles.size() < m_occluders.size()) {
+        m_triangles.resize(m_occluders.size());
+    }
+
+    JobSystem &jobs = JobSystem::shared();
+    jobs.parallelFor(m_occluders.size(), [this](size_t occluder) { setupTriangles(occluder); });
+
+    std::fill(m_levels[0].begin(), m_levels[0].end(), 0.0f);
+    jobs.parallelFor(TILES_X * TILES_Y, [this](size_t tile) { rasterizeTile(static_cast<int>(tile)); });
+
+    buildPyramid();
+
+    m_stats.occluders = m_occluders.size();
+    m_stats.triangles = 0;
+    for (size_t i = 0; i < m_occluders.size(); i++) {
+        m_stats.triangles += m_triangles[i].size();
+    }
+    m_stats.rasterMilliseconds =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void OcclusionCuller::setupTriangles(size_t occluder) {
+    const Mesh                      &mesh      = *m_occluders[occluder].mesh;
+    const glm::mat4                 &transform = m_occluders[occluder].transform;
+    const std::span<const glm::vec3> vertices  = mesh.getOccluderVertices();
+    const std::span<const uint32_t>  indices   = mesh.getOccluderIndices();
+
+    std::vector<Triangle> &triangles = m_triangles[occluder];
+    triangles.clear();
+
+    // window position and 1/w, w is 0 for the vertices behind the near plane
+    std::vector<glm::vec3> screen(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++) {
+        const glm::vec4 clip = transform * glm::vec4(vertices[i], 1.0f);
+        if (clip.z < -clip.w) {
+            screen[i] = glm::vec3(0.0f);
+            continue;
+        }
+
+        const float inverseW = 1.0f / clip.w;
+        const float x        = (clip.x * inverseW * 0.5f + 0.5f) * WIDTH;
+        const float y        = (clip.y * inverseW * 0.5f + 0.5f) * HEIGHT;
+        screen[i]            = glm::vec3(x, y, inverseW);
+    }
+
+    // first and last pixel whose center lies within a bound, clamped before the conversion so far off vertices can't
+    // overflow
+    const auto firstPixel = [](float bound, int size) {
+        return static_cast<int>(std::clamp(std::ceil(bound - 0.5f), 0.0f, static_cast<float>(size)));
+    };
+    const auto lastPixel = [](float bound, int size) {
+        return static_cast<int>(std::clamp(std::floor(bound - 0.5f), -1.0f, static_cast<float>(size - 1)));
+    };
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        const std::array<glm::vec3, 3> v{screen[indices[i]], screen[indices[i + 1]], screen[indices[i + 2]]};
+        if (v[0].z == 0.0f || v[1].z == 0.0f || v[2].z == 0.0f) {
+            continue;
+        }
+
+        // counter-clockwise triangles face the camera, the others are hidden behind the front of a closed mesh
+        const float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[2].x - v[0].x) * (v[1].y - v[0].y);
+        if (area <= 0.0f) {
+            continue;
+        }
+
+        Triangle triangle{};
+        triangle.minX = firstPixel(std::min({v[0].x, v[1].x, v[2].x}), WIDTH);
+        triangle.minY = firstPixel(std::min({v[0].y, v[1].y, v[2].y}), HEIGHT);
+        triangle.maxX = lastPixel(std::max({v[0].x, v[1].x, v[2].x}), WIDTH);
+        triangle.maxY = lastPixel(std::max({v[0].y, v[1].y, v[2].y}), HEIGHT);
+        if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) {
+            continue;
+        }
+
+        // edge k runs from vertex k to the next one, divided by the area it is the weight of the opposite vertex
+        for (size_t k = 0; k < 3; k++) {
+            const glm::vec3 &from = v.at(k);
+            const glm::vec3 &to   = v.at((k + 1) % 3);
+            triangle.edgeA.at(k)  = from.y - to.y;
+            triangle.edgeB.at(k)  = to.x - from.x;
+            triangle.edgeC.at(k)  = from.x * to.y - from.y * to.x;
+        }
+
+        // 1/w interpolated with the vertex weights
+        const auto plane = [&](const std::array<float, 3> &edge) {
+            return (edge[1] * v[0].z + edge[2] * v[1].z + edge[0] * v[2].z) / area;
+        };
+        triangle.depthA = plane(triangle.edgeA);
+        triangle.depthB = plane(triangle.edgeB);
+        triangle.depthC = plane(triangle.edgeC);
+
+        triangles.push_back(triangle);
+    }
+}
+
+void OcclusionCuller::rasterizeTile(int tile) {
+    const int tileMinX = tile % TILES_X * TILE_WIDTH;
+    const int tileMinY = tile / TILES_X * TILE_HEIGHT;
+    const int tileMaxX = tileMinX + TILE_WIDTH - 1;
+    const int tileMaxY = tileMinY + TILE_HEIGHT - 1;
+
+    float *depth = m_levels[0].data();
+
+    for (size_t occluder = 0; occluder < m_occluders.size(); occluder++) {
+        for (const Triangle &triangle : m_triangles[occluder]) {
+            const int minX = std::max(triangle.minX, tileMinX);
+            const int minY = std::max(triangle.minY, tileMinY);
+            const int maxX = std::min(triangle.maxX, tileMaxX);
+            const int maxY = std::min(triangle.maxY, tileMaxY);
+            if (minX > maxX || minY > maxY) {
+                continue;
+            }
+
+            // pixel centers on an edge are inside, so the triangles sharing it leave no gap between them
+            for (int y = minY; y <= maxY; y++) {
+                const float centerY = static_cast<float>(y) + 0.5f;
+                const float row0    = triangle.edgeB[0] * centerY + triangle.edgeC[0];
+                const float row1    = triangle.edgeB[1] * centerY + triangle.edgeC[1];
+                const float row2    = triangle.edgeB[2] * centerY + triangle.edgeC[2];
+                const float rowZ    = triangle.depthB * centerY + triangle.depthC;
+
+                // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                float *line = depth + static_cast<ptrdiff_t>(y) * WIDTH;
+
+#if defined(__AVX__)
+                const __m256 offsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+                const __m256 zero    = _mm256_setzero_ps();
+
+                // the spans start at a multiple of 8 and the tiles end at one, a span never leaves its tile
+                for (int x = minX & ~7; x <= maxX; x += 8) {
+                    const __m256 centerX = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), offsets);
+
+                    const __m256 edge0 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(triangle.edgeA[0]), centerX),
+                                                       _mm256_set1_ps(row0));
+                    const __m256 edge1 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(triangle.edgeA[1]), centerX),
+                                                       _mm256_set1_ps(row1));
+                    const __m256 edge2 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(triangle.edgeA[2]), centerX),
+                                                       _mm256_set1_ps(row2));
+
+                    __m256 inside = _mm256_cmp_ps(edge0, zero, _CMP_GE_OQ);
+                    inside        = _mm256_and_ps(inside, _mm256_cmp_ps(edge1, zero, _CMP_GE_OQ));
+                    inside        = _mm256_and_ps(inside, _mm256_cmp_ps(edge2, zero, _CMP_GE_OQ));
+
+                    const __m256 z = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(triangle.depthA), centerX),
+                                                   _mm256_set1_ps(rowZ));
+
+                    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                    float       *pixels  = line + x;
+                    const __m256 current = _mm256_loadu_ps(pixels);
+                    _mm256_storeu_ps(pixels, _mm256_blendv_ps(current, _mm256_max_ps(current, z), inside));
+                }
+#elif defined(__SSE__) || defined(_M_X64)
+                const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+                const __m128 zero    = _mm_setzero_ps();
+
+                for (int x = minX & ~3; x <= maxX; x += 4) {
+                    const __m128 centerX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), offsets);
+
+                    const __m128 edge0 =
+                            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.edgeA[0]), centerX), _mm_set1_ps(row0));
+                    const __m128 edge1 =
+                            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.edgeA[1]), centerX), _mm_set1_ps(row1));
+                    const __m128 edge2 =
+                            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.edgeA[2]), centerX), _mm_set1_ps(row2));
+
+                    __m128 inside = _mm_cmpge_ps(edge0, zero);
+                    inside        = _mm_and_ps(inside, _mm_cmpge_ps(edge1, zero));
+                    inside        = _mm_and_ps(inside, _mm_cmpge_ps(edge2, zero));
+
+                    const __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.depthA), centerX), _mm_set1_ps(rowZ));
+
+                    // SSE2 has no blend, the mask selects between the old and the new depth
+                    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                    float       *pixels  = line + x;
+                    const __m128 current = _mm_loadu_ps(pixels);
+                    const __m128 closer  = _mm_max_ps(current, z);
+                    _mm_storeu_ps(pixels, _mm_or_ps(_mm_and_ps(inside, closer), _mm_andnot_ps(inside, current)));
+                }
+#else
+                for (int x = minX; x <= maxX; x++) {
+                    const float centerX = static_cast<float>(x) + 0.5f;
+                    if (triangle.edgeA[0] * centerX + row0 >= 0.0f && triangle.edgeA[1] * centerX + row1 >= 0.0f &&
+                        triangle.edgeA[2] * centerX + row2 >= 0.0f) {
+                        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                        line[x] = std::max(line[x], triangle.depthA * centerX + rowZ);
+                    }
+                }
+#endif
+            }
+        }
+    }
+}
+
+void OcclusionCuller::buildPyramid() {
+    for (int level = 1; level < LEVEL_COUNT; level++) {
+        const std::vector<float> &source       = m_levels.at(level - 1);
+        std::vector<float>       &target       = m_levels.at(level);
+        const int                 sourceWidth  = levelWidth(level - 1);
+        const int                 sourceHeight = levelHeight(level - 1);
+        const int                 width        = levelWidth(level);
+        const int                 height       = levelHeight(level);
+
+        // the farthest of the 2x2 texels below, a level with an odd size repeats its last row or column
+        for (int y = 0; y < height; y++) {
+            const auto row0 = static_cast<size_t>(std::min(2 * y, sourceHeight - 1) * sourceWidth);
+            const auto row1 = static_cast<size_t>(std::min(2 * y + 1, sourceHeight - 1) * sourceWidth);
+            for (int x = 0; x < width; x++) {
+                const auto column0 = static_cast<size_t>(std::min(2 * x, sourceWidth - 1));
+                const auto column1 = static_cast<size_t>(std::min(2 * x + 1, sourceWidth - 1));
+
+                target[static_cast<size_t>(y * width + x)] = std::min({source[row0 + column0],
+                                                                       source[row0 + column1],
+                                                                       source[row1 + column0],
+                                                                       source[row1 + column1]});
+            }
+        }
+    }
+}
+
+bool OcclusionCuller::isOccluded(const BoundingSphere &sphere) const {
+    // the corners of the box around the sphere give its window rectangle and its closest depth
+    glm::vec2 min(std::numeric_limits<float>::max());
+    glm::vec2 max(std::numeric_limits<float>::lowest());
+    float     closest = 0.0f;
+
+    for (int corner = 0; corner < 8; corner++) {
+        const glm::vec3 offset((corner & 1) != 0 ? sphere.radius : -sphere.radius,
+                               (corner & 2) != 0 ? sphere.radius : -sphere.radius,
+                               (corner & 4) != 0 ? sphere.radius : -sphere.radius);
+        const glm::vec4 clip = m_viewProjection * glm::vec4(sphere.center + offset, 1.0f);
+
+        // reaching behind the camera, the rectangle is unbounded
+        if (clip.w <= std::numeric_limits<float>::epsilon()) {
+            return false;
+        }
+
+        const float     inverseW = 1.0f / clip.w;
+        const glm::vec2 window((clip.x * inverseW * 0.5f + 0.5f) * WIDTH, (clip.y * inverseW * 0.5f + 0.5f) * HEIGHT);
+        min     = glm::min(min, window);
+        max     = glm::max(max, window);
+        closest = std::max(closest, inverseW);
+    }
+
+    // off screen, that is up to the frustum culling
+    if (max.x < 0.0f || max.y < 0.0f || min.x >= WIDTH || min.y >= HEIGHT) {
+        return false;
+    }
+
+    const int minX = static_cast<int>(std::max(min.x, 0.0f));
+    const int minY = static_cast<int>(std::max(min.y, 0.0f));
+    const int maxX = static_cast<int>(std::min(max.x, static_cast<float>(WIDTH - 1)));
+    const int maxY = static_cast<int>(std::min(max.y, static_cast<float>(HEIGHT - 1)));
+
+    // the finest level where the rectangle spans at most 2x2 texels
+    int level = 0;
+    while (level + 1 < LEVEL_COUNT &&
+           ((maxX >> level) - (minX >> level) > 1 || (maxY >> level) - (minY >> level) > 1)) {
+        level++;
+    }
+
+    const std::vector<float> &depth    = m_levels.at(level);
+    const int                 width    = levelWidth(level);
+    const int                 height   = levelHeight(level);
+    float                     farthest = std::numeric_limits<float>::max();
+
+    for (int y = minY >> level; y <= std::min(maxY >> level, height - 1); y++) {
+        for (int x = minX >> level; x <= std::min(maxX >> level, width - 1); x++) {
+            farthest = std::min(farthest, depth[static_cast<size_t>(y * width + x)]);
+        }
+    }
+
+    return closest < farthest;
+}
+
+void OcclusionCuller::cull(std::span<const BoundingSphere> spheres, std::vector<uint32_t> &visible) {
+    PROFILE_ZONE("OcclusionCuller::cull");
+    const auto start = std::chrono::steady_clock::now();
+
+    m_occludedFlags.resize(visible.size());
+    JobSystem::shared().parallelFor((visible.size() + CULL_CHUNK - 1) / CULL_CHUNK, [&](size_t chunk) {
+        const size_t end = std::min(visible.size(), (chunk + 1) * CULL_CHUNK);
+        for (size_t i = chunk * CULL_CHUNK; i < end; i++) {
+            m_occludedFlags[i] = isOccluded(spheres[visible[i]]) ? 1 : 0;
+        }
+    });
+
+    size_t kept = 0;
+    for (size_t i = 0; i < visible.size(); i++) {
+        if (m_occludedFlags[i] == 0) {
+            visible[kept++] = visible[i];
+        }
+    }
+
+    m_stats.tested   = visible.size();
+    m_stats.occluded = visible.size() - kept;
+    visible.resize(kept);
+
+    m_stats.testMilliseconds =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <Model/Mesh.hpp>
+#include <Utility/MemoryUsage.hpp>
+
+#include "Frustum.hpp"
+
+// Drops draws hidden behind large meshes without reading anything back from the GPU.
+//
+// The occluders, the coarsest level of detail of the meshes that cover a large part of the screen, are rasterized into
+// a small CPU depth buffer. The buffer is split into tiles that are filled in parallel, 8 pixels at a time with AVX and
+// 4 with SSE. A hierarchical-Z pyramid keeps the farthest depth of every 2x2 block of the level below, so the screen
+// rectangle of any bounding sphere is tested by reading at most 2x2 texels of the level that fits it.
+//
+// The depth is 1/w, which is linear in screen space and larger for closer surfaces. Occluder triangles crossing the
+// near plane are skipped, so the buffer only ever holds less occlusion than the scene really has.
+class OcclusionCuller {
+    public:
+    struct Stats {
+        size_t occluders          = 0;
+        size_t triangles          = 0; // front facing and in front of the near plane
+        size_t tested             = 0;
+        size_t occluded           = 0;
+        double rasterMilliseconds = 0.0; // setup, rasterization and the pyramid
+        double testMilliseconds   = 0.0;
+    };
+
+    static constexpr int WIDTH       = 256;
+    static constexpr int HEIGHT      = 128;
+    static constexpr int TILE_WIDTH  = 64; // a multiple of 8, the SIMD spans never leave their tile
+    static constexpr int TILE_HEIGHT = 32;
+    static constexpr int TILES_X     = WIDTH / TILE_WIDTH;
+    static constexpr int TILES_Y     = HEIGHT / TILE_HEIGHT;
+    static constexpr int LEVEL_COUNT = 9; // down to 1x1
+
+    // Meshes covering a smaller radius on screen aren't worth rasterizing as occluders
+    static constexpr float MIN_OCCLUDER_PIXELS = 32.0f;
+
+    OcclusionCuller();
+
+    // Starts a frame seen through viewProjection, dropping the occluders of the last one
+    void begin(const glm::mat4 &viewProjection);
+
+    // Queues the occluder of a mesh, meshes without one are ignored. The mesh must outlive the frame.
+    void addOccluder(const Mesh &mesh, const glm::mat4 &transform);
+
+    // Rasterizes the queued occluders and builds the pyramid
+    void render();
+
+    // Removes the indices of the spheres hidden behind the occluders from visible, keeping the order of the rest
+    void cull(std::span<const BoundingSphere> spheres, std::vector<uint32_t> &visible);
+
+    [[nodiscard]] bool isOccluded(const BoundingSphere &sphere) const;
+
+    [[nodiscard]] const Stats &getStats() const noexcept { return m_stats; }
+
+    // The depth pyramid and the triangles of the last frame, the occluder geometry belongs to the meshes
+    [[nodiscard]] MemoryUsage getMemoryUsage() const;
+
+    private:
+    struct Occluder {
+        const Mesh *mesh;
+        glm::mat4   transform; // model space to clip space
+    };
+
+    // Edge functions are positive inside, depth is a plane over the screen as well
+    struct Triangle {
+        std::array<float, 3> edgeA;
+        std::array<float, 3> edgeB;
+        std::array<float, 3> edgeC;
+        float                depthA;
+        float                depthB;
+        float                depthC;
+        int                  minX;
+        int                  minY;
+        int                  maxX;
+        int                  maxY;
+    };
+
+    glm::mat4 m_viewProjection{1.0f};
+
+    std::vector<Occluder>              m_occluders;
+    std::vector<std::vector<Triangle>> m_triangles; // per occluder
+
+    // level 0 is the depth buffer, every level is half the size of the one before
+    std::array<std::vector<float>, LEVEL_COUNT> m_levels;
+
+    std::vector<uint8_t> m_occludedFlags; // per tested sphere
+
+    Stats m_stats;
+
+    void setupTriangles(size_t occluder);
+    void rasterizeTile(int tile);
+    void buildPyramid();
+
+    [[nodiscard]] static int levelWidth(int level) { return std::max(WIDTH >> level, 1); }
+    [[nodiscard]] static int levelHeight(int level) { return std::max(HEIGHT >> level, 1); }
+};
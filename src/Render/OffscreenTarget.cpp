@@ -0,0 +1,62 @@
+#include "OffscreenTarget.hpp"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb/stb_image_write.h>
+
+#include <format>
+#include <stdexcept>
+
+OffscreenTarget::OffscreenTarget(int width, int height) : m_width(width), m_height(height) {
+    glGenRenderbuffers(1, &m_color);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+    glGenRenderbuffers(1, &m_depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &m_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_color);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depth);
+
+    const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        deleteTarget();
+        throw std::runtime_error(
+                std::format("OffscreenTarget::OffscreenTarget | Incomplete framebuffer 0x{:x}", status));
+    }
+}
+
+void OffscreenTarget::bind() const {
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glViewport(0, 0, m_width, m_height);
+}
+
+std::vector<uint8_t> OffscreenTarget::readPixels() const {
+    std::vector<uint8_t> pixels(static_cast<size_t>(m_width) * static_cast<size_t>(m_height) * 4);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_framebuffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+    return pixels;
+}
+
+void OffscreenTarget::savePng(const std::filesystem::path &path) const {
+    const std::vector<uint8_t> pixels = readPixels();
+
+    stbi_flip_vertically_on_write(1);
+    if (stbi_write_png(path.string().c_str(), m_width, m_height, 4, pixels.data(), m_width * 4) == 0) {
+        throw std::runtime_error(std::format("OffscreenTarget::savePng | Failed to write {}", path.string()));
+    }
+}
+
+void OffscreenTarget::deleteTarget() const {
+    glDeleteFramebuffers(1, &m_framebuffer);
+    glDeleteRenderbuffers(1, &m_color);
+    glDeleteRenderbuffers(1, &m_depth);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <Utility/OpenGlHeaders.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+// Framebuffer with its own color and depth storage, so headless runs don't depend on the default framebuffer of a
+// hidden window, which drivers are free to leave undefined.
+class OffscreenTarget {
+    public:
+    OffscreenTarget(int width, int height);
+
+    // Binds the framebuffer for drawing and sets the viewport to cover it
+    void bind() const;
+
+    // RGBA8 pixels, bottom row first like glReadPixels returns them
+    [[nodiscard]] std::vector<uint8_t> readPixels() const;
+
+    // Writes the current contents as a PNG, top row first
+    void savePng(const std::filesystem::path &path) const;
+
+    void deleteTarget() const;
+
+    [[nodiscard]] int getWidth() const noexcept { return m_width; }
+    [[nodiscard]] int getHeight() const noexcept { return m_height; }
+
+    private:
+    int m_width;
+    int m_height;
+
+    GLuint m_framebuffer = 0;
+    GLuint m_color       = 0;
+    GLuint m_depth       = 0;
+};
@@ -0,0 +1,256 @@
+#include "RenderQueue.hpp"
+
+#include <algorithm>
+#include <array>
+
+#include <Utility/JobSystem.hpp>
+#include <Utility/Profiler.hpp>
+
+namespace {
+
+constexpr uint64_t PROGRAM_BITS      = 10;
+constexpr uint64_t MATERIAL_BITS     = 20;
+constexpr uint64_t VERTEX_ARRAY_BITS = 18;
+constexpr uint64_t DEPTH_BITS        = 16;
+
+// the instanced order is vertex array | mesh id | level of detail within the vertex array and depth bits. There are
+// only a few arena vertex arrays, the bits they don't need let the mesh ids go past the 14 the depth bits would leave
+constexpr uint64_t LOD_BITS                    = 2;
+constexpr uint64_t INSTANCED_VERTEX_ARRAY_BITS = 4;
+constexpr uint64_t MESH_BITS = VERTEX_ARRAY_BITS + DEPTH_BITS - INSTANCED_VERTEX_ARRAY_BITS - LOD_BITS;
+
+static_assert(Mesh::MAX_LODS <= uint64_t{1} << LOD_BITS);
+
+// instances copied per job when they are packed in draw order
+constexpr size_t PACK_GRAIN = 8192;
+
+static_assert(PROGRAM_BITS + MATERIAL_BITS + VERTEX_ARRAY_BITS + DEPTH_BITS == 64);
+
+constexpr uint64_t mask(uint64_t bits) {
+    return (uint64_t{1} << bits) - 1;
+}
+
+uint64_t denseId(std::unordered_map<GLuint, uint64_t> &ids, GLuint name) {
+    return ids.try_emplace(name, ids.size()).first->second;
+}
+
+} // namespace
+
+void RenderQueue::submit(const Shader         &shader,
+                         const Mesh           &mesh,
+                         const glm::mat4      &transform,
+                         float                 depth,
+                         const BoundingSphere &bounds,
+                         uint32_t              lod,
+                         const glm::vec4      &tint) {
+    registerDraw(shader, mesh);
+    submitAt(allocate(1), shader, mesh, transform, depth, bounds, lod, tint);
+}
+
+void RenderQueue::registerDraw(const Shader &shader, const Mesh &mesh) {
+    denseId(m_programIds, shader.getProgramID());
+    denseId(m_vertexArrayIds, mesh.getVertexArray());
+    m_meshIds.try_emplace(&mesh, m_meshIds.size());
+}
+
+size_t RenderQueue::allocate(size_t count) {
+    const size_t first = m_items.size();
+    m_items.resize(first + count);
+    m_bounds.resize(first + count);
+    m_culler.resize(first + count);
+    return first;
+}
+
+void RenderQueue::submitAt(size_t                slot,
+                           const Shader         &shader,
+                           const Mesh           &mesh,
+                           const glm::mat4      &transform,
+                           float                 depth,
+                           const BoundingSphere &bounds,
+                           uint32_t              lod,
+                           const glm::vec4      &tint) {
+    // only reads the id maps, registerDraw filled them
+    const auto program     = m_programIds.at(shader.getProgramID()) & mask(PROGRAM_BITS);
+    const auto vertexArray = m_vertexArrayIds.at(mesh.getVertexArray()) & mask(VERTEX_ARRAY_BITS);
+    const auto material    = uint64_t{mesh.getMaterialId()} & mask(MATERIAL_BITS);
+
+    // instanced items of the same mesh and level have to be adjacent after the sort, the depth order is given up for that
+    uint64_t state = 0;
+    if (m_instancing) {
+        const uint64_t meshId = m_meshIds.at(&mesh) & mask(MESH_BITS);
+        state = (vertexArray & mask(INSTANCED_VERTEX_ARRAY_BITS)) << (MESH_BITS + LOD_BITS) | meshId << LOD_BITS | lod;
+    } else {
+        const float clamped = std::clamp(depth, 0.0f, 1.0f);
+        const auto  order   = static_cast<uint64_t>(clamped * static_cast<float>(mask(DEPTH_BITS)));
+        state               = vertexArray << DEPTH_BITS | order;
+    }
+
+    const uint64_t key = program << (MATERIAL_BITS + VERTEX_ARRAY_BITS + DEPTH_BITS) |
+                         material << (VERTEX_ARRAY_BITS + DEPTH_BITS) | state;
+
+    m_items[slot]  = {key, &shader, &mesh, lod, InstanceBuffer::Instance::create(transform, tint)};
+    m_bounds[slot] = bounds;
+    m_culler.set(slot, bounds);
+}
+
+// LSD radix sort of the keys, one byte per pass. Only the indices move, passes where every key has the same byte
+// are skipped, which is the common case for the program bits.
+void RenderQueue::sort() {
+    const size_t count = m_items.size();
+
+    m_keys.resize(count);
+    m_order.resize(count);
+    m_scratch.resize(count);
+
+    for (size_t i = 0; i < count; i++) {
+        m_keys[i]  = m_items[i].key;
+        m_order[i] = static_cast<uint32_t>(i);
+    }
+
+    constexpr size_t RADIX = 256;
+
+    for (uint64_t shift = 0; shift < 64; shift += 8) {
+        std::array<uint32_t, RADIX> histogram{};
+
+        for (const uint64_t key : m_keys) {
+            histogram.at((key >> shift) & 0xFF)++;
+        }
+
+        if (histogram.at((m_keys[0] >> shift) & 0xFF) == count) {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (auto &bucket : histogram) {
+            const uint32_t size = bucket;
+            bucket              = offset;
+            offset += size;
+        }
+
+        for (const uint32_t index : m_order) {
+            m_scratch[histogram.at((m_keys[index] >> shift) & 0xFF)++] = index;
+        }
+
+        std::swap(m_order, m_scratch);
+    }
+}
+
+void RenderQueue::prepare(const Frustum &frustum, OcclusionCuller *occlusion) {
+    PROFILE_ZONE("RenderQueue::prepare");
+    m_stats = {};
+
+    m_visible.clear();
+    m_culler.cull(frustum, m_visible);
+    m_culler.clear();
+
+    if (occlusion != nullptr) {
+        occlusion->cull(m_bounds, m_visible);
+    }
+    m_bounds.clear();
+
+    // the visible indices are ascending, so the items can be compacted in place
+    size_t kept = 0;
+    for (const uint32_t index : m_visible) {
+        m_items[kept++] = m_items[index];
+    }
+    m_items.resize(kept);
+
+    if (m_items.empty()) {
+        m_order.clear();
+        return;
+    }
+
+    sort();
+
+    // one upload for the whole frame, every draw reads its instances from a range of the buffer
+    m_instances.resize(m_order.size());
+    JobSystem::shared().parallelFor(m_order.size(), PACK_GRAIN, [this](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            m_instances[i] = m_items[m_order[i]].instance;
+        }
+    });
+}
+
+void RenderQueue::draw() {
+    if (m_order.empty()) {
+        clear();
+        return;
+    }
+
+    m_instanceBuffer.upload(m_instances);
+
+    MaterialLibrary &materials = MaterialLibrary::shared();
+
+    GLuint                 program     = 0;
+    GLuint                 vertexArray = 0;
+    const ProgramUniforms *uniforms    = nullptr;
+
+    for (size_t first = 0; first < m_order.size();) {
+        const Item &item = m_items[m_order[first]];
+
+        // the run of items drawn together, a single item when instancing is off
+        size_t last = first + 1;
+        if (m_instancing) {
+            while (last < m_order.size() && m_items[m_order[last]].shader == item.shader &&
+                   m_items[m_order[last]].mesh == item.mesh && m_items[m_order[last]].lod == item.lod) {
+                last++;
+            }
+        }
+
+        if (item.shader->getProgramID() != program) {
+            program = item.shader->getProgramID();
+            item.shader->use();
+
+            auto [iterator, inserted] = m_preparedPrograms.try_emplace(program);
+            if (inserted) {
+                iterator->second = {Material::prepareShader(*item.shader), Mesh::prepareShader(*item.shader)};
+            }
+            uniforms = &iterator->second;
+
+            // the material uniforms belong to the program
+            materials.invalidate();
+            m_stats.programSwitches++;
+        }
+
+        m_stats.textureBinds += materials.bind(item.mesh->getMaterialId(), uniforms->material);
+
+        if (item.mesh->getVertexArray() != vertexArray) {
+            vertexArray = item.mesh->getVertexArray();
+            glBindVertexArray(vertexArray);
+            m_stats.vaoBinds++;
+        }
+
+        m_instanceBuffer.bindAttributes(first);
+        item.mesh->bindUniforms(uniforms->mesh);
+        item.mesh->drawElements(static_cast<GLsizei>(last - first), item.lod);
+        m_stats.draws++;
+        m_stats.instances += last - first;
+        m_stats.triangles += (last - first) * item.mesh->getTriangleCount(item.lod);
+        m_stats.fullTriangles += (last - first) * item.mesh->getTriangleCount();
+
+        first = last;
+    }
+
+    glBindVertexArray(0);
+    glActiveTexture(GL_TEXTURE0);
+
+    clear();
+}
+
+MemoryUsage RenderQueue::getMemoryUsage() const {
+    MemoryUsage usage = m_instanceBuffer.getMemoryUsage();
+    usage += m_culler.getMemoryUsage();
+
+    usage.cpuBytes += m_items.capacity() * sizeof(Item) + m_keys.capacity() * sizeof(uint64_t) +
+                      (m_order.capacity() + m_scratch.capacity() + m_visible.capacity()) * sizeof(uint32_t) +
+                      m_bounds.capacity() * sizeof(BoundingSphere) +
+                      m_instances.capacity() * sizeof(InstanceBuffer::Instance);
+    return usage;
+}
+
+void RenderQueue::clear() {
+    m_items.clear();
+    m_bounds.clear();
+    m_culler.clear();
+    m_order.clear();
+}
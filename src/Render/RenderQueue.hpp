@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <Model/Material.hpp>
+#include <Model/Mesh.hpp>
+#include <Shader.hpp>
+
+#include "Frustum.hpp"
+#include "FrustumCuller.hpp"
+#include "InstanceBuffer.hpp"
+#include "OcclusionCuller.hpp"
+
+// Collects the draws of a frame, sorts them by state and executes them with as few state changes as possible.
+//
+// Every item carries a 64 bit key, from the most to the least significant bits:
+//     program (10) | material (20) | vertex array (18) | depth (16)
+// so a radix sort of the keys groups draws by program first, then by material and vertex array, and draws sharing
+// all of them front to back. Items outside the frustum are dropped in one batch before the sort, followed by the items
+// an occlusion culler finds hidden when one is given.
+//
+// The transforms of the visible items are streamed into an instance buffer in sorted order. With instancing enabled
+// the vertex array and depth bits hold
+//     vertex array (4) | mesh (28) | level of detail (2)
+// instead, so every run of items sharing program, material, mesh and level becomes a single glDrawElementsInstanced
+// call. The meshes share the few arena vertex arrays, past 16 vertex arrays or 2^28 registered meshes the ids wrap
+// around and only cost extra binds and split draws, never a wrong draw.
+class RenderQueue {
+    public:
+    struct Stats {
+        size_t draws           = 0;
+        size_t instances       = 0;
+        size_t triangles       = 0; // at the selected levels of detail
+        size_t fullTriangles   = 0; // had everything been drawn at level 0
+        size_t programSwitches = 0;
+        size_t textureBinds    = 0;
+        size_t vaoBinds        = 0;
+    };
+
+    // transform is the model matrix of the draw, depth the view distance normalized by the far plane and bounds are in
+    // world space
+    void submit(const Shader         &shader,
+                const Mesh           &mesh,
+                const glm::mat4      &transform,
+                float                 depth,
+                const BoundingSphere &bounds,
+                uint32_t              lod  = 0,
+                const glm::vec4      &tint = glm::vec4(1.0f));
+
+    // For submitting from several threads at once. Every shader and mesh pair is registered first, then allocate()
+    // makes room for count draws and returns the first slot. Each slot is filled by one submitAt() call, those may run
+    // concurrently. Registering and allocating have to happen on one thread.
+    void   registerDraw(const Shader &shader, const Mesh &mesh);
+    size_t allocate(size_t count);
+    void   submitAt(size_t                slot,
+                    const Shader         &shader,
+                    const Mesh           &mesh,
+                    const glm::mat4      &transform,
+                    float                 depth,
+                    const BoundingSphere &bounds,
+                    uint32_t              lod  = 0,
+                    const glm::vec4      &tint = glm::vec4(1.0f));
+
+    // Culls and sorts everything submitted since the last call and packs the instances in draw order, without touching
+    // the GL context. The occluders have to be rendered already.
+    void prepare(const Frustum &frustum, OcclusionCuller *occlusion = nullptr);
+
+    // Uploads the instances of the last prepare() and draws them, then clears the queue
+    void draw();
+
+    void execute(const Frustum &frustum, OcclusionCuller *occlusion = nullptr) {
+        prepare(frustum, occlusion);
+        draw();
+    }
+
+    // Drops the draws submitted or prepared since the last draw()
+    void clear();
+
+    void deleteBuffers() { m_instanceBuffer.deleteBuffer(); }
+
+    // The draw lists, which keep their capacity from frame to frame, and the instance buffer
+    [[nodiscard]] MemoryUsage getMemoryUsage() const;
+
+    // Trades the front to back order within a state group for one draw call per mesh, on by default
+    void setInstancing(bool enabled) noexcept { m_instancing = enabled; }
+
+    [[nodiscard]] bool                        isInstancing() const noexcept { return m_instancing; }
+    [[nodiscard]] const Stats                &getStats() const noexcept { return m_stats; }
+    [[nodiscard]] const FrustumCuller::Stats &getCullStats() const noexcept { return m_culler.getStats(); }
+
+    // the instance stream, how long its writes waited for the GPU
+    [[nodiscard]] const StreamBuffer::Stats &getStreamStats() const noexcept {
+        return m_instanceBuffer.getStreamStats();
+    }
+
+    private:
+    struct Item {
+        uint64_t      key;
+        const Shader *shader;
+        const Mesh   *mesh;
+        uint32_t      lod;
+
+        InstanceBuffer::Instance instance;
+    };
+
+    // uniform handles of a program, resolved the first time it is drawn with
+    struct ProgramUniforms {
+        Material::Uniforms material;
+        Mesh::Uniforms     mesh;
+    };
+
+    std::vector<Item>     m_items;
+    std::vector<uint64_t> m_keys;
+    std::vector<uint32_t> m_order;
+    std::vector<uint32_t> m_scratch;
+    std::vector<uint32_t> m_visible;
+
+    std::vector<BoundingSphere> m_bounds; // per item, for the occlusion test
+
+    std::vector<InstanceBuffer::Instance> m_instances; // in draw order
+    InstanceBuffer                        m_instanceBuffer;
+
+    FrustumCuller m_culler;
+    bool          m_instancing = true;
+
+    // dense ids for the GL names that go into the key
+    std::unordered_map<GLuint, uint64_t>        m_programIds;
+    std::unordered_map<GLuint, uint64_t>        m_vertexArrayIds;
+    std::unordered_map<const Mesh *, uint64_t>  m_meshIds;
+    std::unordered_map<GLuint, ProgramUniforms> m_preparedPrograms;
+
+    Stats m_stats;
+
+    void sort();
+};
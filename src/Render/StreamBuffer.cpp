@@ -0,0 +1,165 @@
+#include "StreamBuffer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+bool persistentMapping = true;
+
+// how long a single wait for a fence may block before it is checked again, in nanoseconds
+constexpr GLuint64 WAIT_TIMEOUT = 1'000'000;
+
+} // namespace
+
+StreamBuffer::StreamBuffer(GLenum target, size_t regionSize) : m_target(target) {
+    if (target == GL_UNIFORM_BUFFER) {
+        GLint alignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        m_alignment = std::max(m_alignment, static_cast<size_t>(alignment));
+    }
+
+    if (regionSize > 0) {
+        create(regionSize);
+    }
+}
+
+void StreamBuffer::setPersistentMapping(bool enabled) { persistentMapping = enabled; }
+
+void StreamBuffer::create(size_t regionSize) {
+    deleteBuffer();
+
+    // every region starts aligned
+    m_regionSize = (regionSize + m_alignment - 1) / m_alignment * m_alignment;
+    m_region     = 0;
+    m_head       = 0;
+
+    const auto size = static_cast<GLsizeiptr>(m_regionSize * REGION_COUNT);
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(m_target, m_buffer);
+
+    m_stats.persistent = persistentMapping && GLAD_GL_ARB_buffer_storage != 0;
+    if (m_stats.persistent) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(m_target, size, nullptr, flags);
+        m_mapping = static_cast<std::byte *>(glMapBufferRange(m_target, 0, size, flags));
+
+        if (m_mapping == nullptr) {
+            glBindBuffer(m_target, 0);
+            throw std::runtime_error("StreamBuffer::create | Failed to map the buffer persistently");
+        }
+    } else {
+        glBufferData(m_target, size, nullptr, GL_STREAM_DRAW);
+    }
+
+    glBindBuffer(m_target, 0);
+}
+
+void StreamBuffer::beginFrame() {
+    m_stats.frameBytes       = 0;
+    m_stats.waitMilliseconds = 0.0;
+
+    // a region nothing was written to can be used again right away
+    if (m_head == 0) {
+        return;
+    }
+
+    m_fences.at(m_region) = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_region              = (m_region + 1) % REGION_COUNT;
+    m_head                = 0;
+
+    waitForRegion();
+}
+
+void StreamBuffer::waitForRegion() {
+    GLsync &fence = m_fences.at(m_region);
+    if (fence == nullptr) {
+        return;
+    }
+
+    const auto start  = std::chrono::steady_clock::now();
+    GLenum     result = glClientWaitSync(fence, 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED) {
+        m_stats.stalls++;
+
+        // the first wait flushes, the fence may still be sitting in the command queue
+        result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, WAIT_TIMEOUT);
+        while (result == GL_TIMEOUT_EXPIRED) {
+            result = glClientWaitSync(fence, 0, WAIT_TIMEOUT);
+        }
+    }
+
+    glDeleteSync(fence);
+    fence = nullptr;
+
+    m_stats.waitMilliseconds =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    m_stats.totalWaitMilliseconds += m_stats.waitMilliseconds;
+
+    if (result == GL_WAIT_FAILED) {
+        throw std::runtime_error("StreamBuffer::beginFrame | Failed to wait for the GPU");
+    }
+}
+
+size_t StreamBuffer::write(const void *data, size_t bytes) {
+    if (bytes == 0) {
+        return m_region * m_regionSize + m_head;
+    }
+
+    size_t start = (m_head + m_alignment - 1) / m_alignment * m_alignment;
+    if (m_buffer == 0 || start + bytes > m_regionSize) {
+        create(std::max(m_regionSize * 2, bytes));
+        start = 0;
+    }
+
+    const size_t offset = m_region * m_regionSize + start;
+
+    if (m_mapping != nullptr) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        std::memcpy(m_mapping + offset, data, bytes);
+    } else {
+        // the fences keep the GPU out of the region, the driver doesn't have to synchronize
+        glBindBuffer(m_target, m_buffer);
+        void *mapping = glMapBufferRange(m_target,
+                                         static_cast<GLintptr>(offset),
+                                         static_cast<GLsizeiptr>(bytes),
+                                         GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+        if (mapping == nullptr) {
+            glBindBuffer(m_target, 0);
+            throw std::runtime_error("StreamBuffer::write | Failed to map the buffer");
+        }
+
+        std::memcpy(mapping, data, bytes);
+        glUnmapBuffer(m_target);
+        glBindBuffer(m_target, 0);
+    }
+
+    m_head = start + bytes;
+    m_stats.frameBytes += bytes;
+    return offset;
+}
+
+MemoryUsage StreamBuffer::getMemoryUsage() const {
+    if (m_buffer == 0) {
+        return {};
+    }
+    return {.bufferBytes = m_regionSize * REGION_COUNT, .glObjects = 1};
+}
+
+void StreamBuffer::deleteBuffer() {
+    for (auto &fence : m_fences) {
+        if (fence != nullptr) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+
+    // deleting a mapped buffer unmaps it
+    if (m_buffer != 0) {
+        glDeleteBuffers(1, &m_buffer);
+        m_buffer  = 0;
+        m_mapping = nullptr;
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <Utility/OpenGlHeaders.hpp>
+
+#include <array>
+#include <cstddef>
+#include <span>
+
+#include <Utility/MemoryUsage.hpp>
+
+// Buffer for data rewritten every frame, split into REGION_COUNT regions that are written in turn.
+//
+// beginFrame() moves on to the next region and waits for the fence of the frame that last used it, so the GPU is never
+// read from a region while the CPU writes it and the driver never has to copy or rename the buffer. With
+// ARB_buffer_storage (core in 4.4) the buffer is mapped once, persistently and coherently, and write() is a plain
+// memcpy. The 3.3 context falls back to mapping the written range unsynchronized, which the fences make safe as well.
+//
+// A frame that writes more than a region holds grows the buffer. The old storage is orphaned, so offsets returned
+// earlier in the same frame refer to a buffer that getBuffer() no longer returns.
+class StreamBuffer {
+    public:
+    static constexpr size_t REGION_COUNT = 3;
+
+    struct Stats {
+        double waitMilliseconds      = 0.0; // spent in the last beginFrame() waiting for the GPU
+        double totalWaitMilliseconds = 0.0;
+        size_t stalls                = 0; // frames whose region was still in use by the GPU
+        size_t frameBytes            = 0; // written since the last beginFrame()
+        bool   persistent            = false;
+    };
+
+    // target is what the buffer is bound to while it is created and written, write() aligns the data for it
+    StreamBuffer(GLenum target, size_t regionSize);
+
+    // Persistent mapping is used when the driver supports it unless turned off here, only affects buffers created later
+    static void setPersistentMapping(bool enabled);
+
+    // Fences the region of the last frame and waits until the next one is free, call it before the first write() of a
+    // frame and after the draws of the previous one are issued
+    void beginFrame();
+
+    // Copies the data into the current region and returns its offset in the buffer
+    size_t write(const void *data, size_t bytes);
+
+    template <typename T> size_t write(std::span<const T> data) { return write(data.data(), data.size_bytes()); }
+
+    [[nodiscard]] GLuint       getBuffer() const noexcept { return m_buffer; }
+    [[nodiscard]] const Stats &getStats() const noexcept { return m_stats; }
+    [[nodiscard]] MemoryUsage  getMemoryUsage() const;
+
+    void deleteBuffer();
+
+    private:
+    GLenum m_target;
+    size_t m_alignment  = 16;
+    size_t m_regionSize = 0;
+    size_t m_region     = 0;
+    size_t m_head       = 0; // next free byte in the current region
+
+    GLuint     m_buffer  = 0;
+    std::byte *m_mapping = nullptr; // the whole buffer, only when it is persistent
+
+    std::array<GLsync, REGION_COUNT> m_fences{};
+
+    Stats m_stats;
+
+    void create(size_t regionSize);
+    void waitForRegion();
+};
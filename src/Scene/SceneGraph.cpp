@@ -0,0 +1,123 @@
+#include "SceneGraph.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#include <Utility/JobSystem.hpp>
+
+SceneGraph::NodeId SceneGraph::add(NodeId parent, const glm::mat4 &local) {
+    const uint32_t parentIndex = parent == NONE ? NONE : m_indices.at(parent);
+    const auto     position    = parent == NONE ? static_cast<uint32_t>(size())
+                                                : parentIndex + m_subtreeSizes[parentIndex];
+
+    // everything from the insertion point on moves up by one
+    if (position < size()) {
+        for (auto &index : m_parents) {
+            if (index != NONE && index >= position) {
+                index++;
+            }
+        }
+        for (size_t i = position; i < size(); i++) {
+            m_indices[m_ids[i]]++;
+        }
+    }
+
+    const auto offset = static_cast<std::ptrdiff_t>(position);
+    const auto id     = static_cast<NodeId>(m_indices.size());
+
+    m_parents.insert(m_parents.begin() + offset, parentIndex);
+    m_subtreeSizes.insert(m_subtreeSizes.begin() + offset, 1);
+    m_locals.insert(m_locals.begin() + offset, local);
+    m_worlds.insert(m_worlds.begin() + offset, local);
+    m_dirtyFlags.insert(m_dirtyFlags.begin() + offset, 0);
+    m_ids.insert(m_ids.begin() + offset, id);
+    m_indices.push_back(position);
+
+    for (uint32_t ancestor = parentIndex; ancestor != NONE; ancestor = m_parents[ancestor]) {
+        m_subtreeSizes[ancestor]++;
+    }
+
+    markDirty(position);
+    return id;
+}
+
+void SceneGraph::setLocal(NodeId node, const glm::mat4 &local) {
+    const uint32_t index = m_indices.at(node);
+    m_locals[index]      = local;
+    markDirty(index);
+}
+
+SceneGraph::NodeId SceneGraph::getParent(NodeId node) const {
+    const uint32_t parent = m_parents[m_indices.at(node)];
+    return parent == NONE ? NONE : m_ids[parent];
+}
+
+void SceneGraph::markDirty(uint32_t index) {
+    if (m_dirtyFlags[index] == 0) {
+        m_dirtyFlags[index] = 1;
+        m_dirty.push_back(m_ids[index]);
+    }
+}
+
+void SceneGraph::update() {
+    const auto start = std::chrono::steady_clock::now();
+
+    m_stats       = {};
+    m_stats.nodes = size();
+
+    m_dirtyIndices.clear();
+    for (const NodeId node : m_dirty) {
+        const uint32_t index = m_indices[node];
+        m_dirtyIndices.push_back(index);
+        m_dirtyFlags[index] = 0;
+    }
+    m_dirty.clear();
+
+    // in ascending order a dirty node inside an already recomputed subtree is skipped
+    std::ranges::sort(m_dirtyIndices);
+
+    m_dirtyRanges.clear();
+
+    uint32_t coveredEnd = 0;
+    for (const uint32_t root : m_dirtyIndices) {
+        if (root < coveredEnd) {
+            continue;
+        }
+
+        coveredEnd = root + m_subtreeSizes[root];
+        m_dirtyRanges.emplace_back(root, coveredEnd);
+        m_stats.dirtyRoots++;
+        m_stats.updatedNodes += coveredEnd - root;
+    }
+
+    // a subtree too large for one job loses its root, which is recomputed here, and its children become subtrees of
+    // their own. Every range then only reads parents that are computed already or inside the range itself.
+    for (size_t i = 0; i < m_dirtyRanges.size(); i++) {
+        const auto [root, end] = m_dirtyRanges[i];
+        if (end - root <= UPDATE_GRAIN) {
+            continue;
+        }
+
+        updateWorld(root);
+        m_dirtyRanges[i] = {end, end};
+
+        for (uint32_t child = root + 1; child < end; child += m_subtreeSizes[child]) {
+            m_dirtyRanges.emplace_back(child, child + m_subtreeSizes[child]);
+        }
+    }
+
+    // ranges per job for about UPDATE_GRAIN nodes each
+    const size_t nodes = std::max<size_t>(m_stats.updatedNodes, 1);
+    const size_t grain = std::max<size_t>(1, m_dirtyRanges.size() * UPDATE_GRAIN / nodes);
+
+    JobSystem::shared().parallelFor(m_dirtyRanges.size(), grain, [this](size_t begin, size_t end) {
+        for (size_t range = begin; range < end; range++) {
+            // parents come before their children, so every parent world matrix is up to date when it is read
+            for (uint32_t i = m_dirtyRanges[range].first; i < m_dirtyRanges[range].second; i++) {
+                updateWorld(i);
+            }
+        }
+    });
+
+    m_stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Hierarchy of transforms with cached world matrices.
+//
+// Nodes are stored in preorder in flat arrays, so the subtree of a node is the contiguous range
+// [index, index + subtree size) and a parent always comes before its children. Changing a local transform marks the
+// node dirty, update() then recomputes the world matrices of each dirty subtree in one linear pass over that range
+// and never touches the rest of the scene. The subtrees are independent, so they are recomputed on the JobSystem, and
+// one too large for a single job is split into the subtrees of its children.
+//
+// Nodes are referred to by id, ids stay valid when later insertions move nodes around in the arrays.
+class SceneGraph {
+    public:
+    using NodeId = uint32_t;
+
+    static constexpr NodeId NONE = std::numeric_limits<NodeId>::max();
+
+    // nodes recomputed per job
+    static constexpr size_t UPDATE_GRAIN = 4096;
+
+    struct Stats {
+        size_t nodes        = 0;
+        size_t dirtyRoots   = 0; // dirty subtrees recomputed by the last update
+        size_t updatedNodes = 0; // world matrices recomputed by the last update
+        double milliseconds = 0.0;
+    };
+
+    // Adds a node as the last child of parent, or as a root when parent is NONE. Adding to the subtree that ends the
+    // arrays doesn't move any node, so building a hierarchy in preorder is linear.
+    NodeId add(NodeId parent, const glm::mat4 &local = glm::mat4(1.0f));
+
+    void setLocal(NodeId node, const glm::mat4 &local);
+
+    [[nodiscard]] const glm::mat4 &getLocal(NodeId node) const { return m_locals[m_indices.at(node)]; }
+    [[nodiscard]] const glm::mat4 &getWorld(NodeId node) const { return m_worlds[m_indices.at(node)]; }
+    [[nodiscard]] NodeId           getParent(NodeId node) const;
+    [[nodiscard]] size_t           getSubtreeSize(NodeId node) const { return m_subtreeSizes[m_indices.at(node)]; }
+
+    // Recomputes the world matrices of every dirty subtree
+    void update();
+
+    [[nodiscard]] size_t       size() const noexcept { return m_ids.size(); }
+    [[nodiscard]] const Stats &getStats() const noexcept { return m_stats; }
+
+    private:
+    // per node, in preorder
+    std::vector<uint32_t>  m_parents; // array index of the parent, NONE for roots
+    std::vector<uint32_t>  m_subtreeSizes;
+    std::vector<glm::mat4> m_locals;
+    std::vector<glm::mat4> m_worlds;
+    std::vector<uint8_t>   m_dirtyFlags;
+    std::vector<NodeId>    m_ids;
+
+    // id -> array index
+    std::vector<uint32_t> m_indices;
+
+    // nodes whose local transform changed since the last update, by id
+    std::vector<NodeId>   m_dirty;
+    std::vector<uint32_t> m_dirtyIndices;
+
+    std::vector<std::pair<uint32_t, uint32_t>> m_dirtyRanges; // [first, end) of the subtrees to recompute
+
+    Stats m_stats;
+
+    void markDirty(uint32_t index);
+
+    void updateWorld(uint32_t index) {
+        const uint32_t parent = m_parents[index];
+        m_worlds[index]       = parent == NONE ? m_locals[index] : m_worlds[parent] * m_locals[index];
+    }
+};
@@ -3,46 +3,293 @@
 #include <glad/glad.h>
 
 #include <array>
+#include <chrono>
+#include <cstdint>
 #include <cstring>
+#include <filesystem>
 #include <format>
 #include <fstream>
+#include <iostream>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <stdexcept>
 
 #include <Utility/fs_helpers.hpp>
+#include <Utility/Profiler.hpp>
 
-void Shader::add(const std::string& shaderName, const Shader::Type& type) const {
+namespace {
+constexpr std::array<char, 4> MAGIC{'P', 'B', 'I', 'N'};
+constexpr uint32_t            VERSION = 1;
+
+// Header of a program binary cache file, followed by size bytes of the binary
+struct BinaryHeader {
+    std::array<char, 4> magic;
+    uint32_t            version;
+    uint64_t            key;
+    uint32_t            format; // as returned by glGetProgramBinary
+    uint32_t            size;
+};
+
+// FNV-1a
+uint64_t hashString(std::string_view string, uint64_t hash = 14695981039346656037ULL) {
+    for (const char character : string) {
+        hash ^= static_cast<unsigned char>(character);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+std::string_view glString(GLenum name) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    const auto *string = reinterpret_cast<const char *>(glGetString(name));
+    return string != nullptr ? string : "";
+}
+
+// Drivers may expose the entry points and still accept no binary formats
+bool isBinaryCacheSupported() {
+    static const bool supported = [] {
+        if (GLAD_GL_ARB_get_program_binary == 0) {
+            return false;
+        }
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        return formats > 0;
+    }();
+    return supported;
+}
+
+std::filesystem::path getBinaryPath(const std::string &name) {
+    return fs_helpers::getPathToCacheDirectory() / "programs" / (name + ".bin");
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+} // namespace
+
+void Shader::add(const std::string& shaderName, const Shader::Type& type) {
+    PROFILE_ZONE("Shader::add");
 
     if (type == Type::PROGRAM) {
         throw std::runtime_error("Shader::add | Type can't be program");
     }
 
-    std::string   path = fs_helpers::getPathToShader(shaderName).string();
-    std::ifstream file;
-    file.open(path);
+    // packed shaders are read straight from the archive, loose ones are mapped
+    const std::filesystem::path               path   = fs_helpers::getPathToShader(shaderName);
+    const std::optional<fs_helpers::Resource> source = fs_helpers::openResource(path);
+
+    if (!source.has_value()) {
+        throw std::runtime_error(std::format("Shader::add | Failed to open file: {}", path.string()));
+    }
+
+    // the only copy, the defines are inserted into it
+    std::string text(source->text());
+
+    // #version has to stay the first statement, the defines go right below it
+    const size_t version = text.find("#version");
+    const size_t lineEnd = version != std::string::npos ? text.find('\n', version) : std::string::npos;
+    text.insert(lineEnd != std::string::npos ? lineEnd + 1 : 0, m_defines);
 
+    m_sources.push_back({static_cast<GLenum>(type), shaderName, std::move(text)});
+}
+
+void Shader::define(const std::string &name, int value) {
+    m_defines += std::format("#define {} {}\n", name, value);
+}
+
+void Shader::link() {
+    PROFILE_ZONE("Shader::link");
+    const auto start = std::chrono::steady_clock::now();
+
+    const bool     cacheable = isBinaryCacheSupported();
+    const uint64_t key       = cacheable ? cacheKey() : 0;
+
+    if (cacheable && loadBinary(key)) {
+        std::cout << std::format("Shader | {} | cache hit | {:.2f} ms", cacheName(), millisecondsSince(start))
+                  << std::endl;
+    } else {
+        for (const auto &source : m_sources) {
+            const GLuint shader = glCreateShader(source.type);
+
+            const GLchar* text = source.text.c_str();
+            glShaderSource(shader, 1, &text, nullptr);
+            glCompileShader(shader);
+
+            try {
+                Shader::checkCompileErrors(shader, static_cast<Type>(source.type));
+            } catch (const std::runtime_error &error) {
+                glDeleteShader(shader);
+                throw std::runtime_error(std::format("{}: {}", source.name, error.what()));
+            }
+
+            glAttachShader(m_programID, shader);
+            glDeleteShader(shader);
+        }
+
+        if (cacheable) {
+            glProgramParameteri(m_programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+        glLinkProgram(m_programID);
+        Shader::checkCompileErrors(m_programID, Type::PROGRAM);
+
+        const double compileTime = millisecondsSince(start);
+        if (cacheable) {
+            storeBinary(key);
+        }
+
+        std::cout << std::format("Shader | {} | compiled and linked | {:.2f} ms", cacheName(), compileTime)
+                  << std::endl;
+    }
+
+    m_linked = true;
+    m_sources.clear();
+    reflect();
+}
+
+std::string Shader::cacheName() const {
+    std::string name;
+    for (const auto &source : m_sources) {
+        name += name.empty() ? source.name : "+" + source.name;
+    }
+
+    // every set of defines is a program of its own
+    if (!m_defines.empty()) {
+        name += std::format("-{:016x}", hashString(m_defines));
+    }
+    return name;
+}
+
+uint64_t Shader::cacheKey() const {
+    uint64_t key = hashString(glString(GL_VENDOR));
+    key          = hashString(glString(GL_RENDERER), key);
+    key          = hashString(glString(GL_VERSION), key);
+
+    for (const auto &source : m_sources) {
+        key = hashString(std::to_string(source.type), key);
+        key = hashString(source.text, key);
+    }
+    return key;
+}
+
+bool Shader::loadBinary(uint64_t key) {
+    const std::filesystem::path path = getBinaryPath(cacheName());
+
+    std::ifstream file(path, std::ios::binary);
+    if (file.fail()) {
+        return false;
+    }
+
+    BinaryHeader header{};
+    file.read(reinterpret_cast<char *>(&header), sizeof(header)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+
+    // the sources or the driver changed since the binary was written, it gets replaced after the build from source
+    if (file.fail() || header.magic != MAGIC || header.version != VERSION || header.key != key) {
+        return false;
+    }
+
+    std::vector<char> binary(header.size);
+    file.read(binary.data(), static_cast<std::streamsize>(binary.size()));
     if (file.fail()) {
-        const std::string errorMessage =
-                std::format("Shader::add | Failed to open file: {} | System Error: {}", path, std::to_string(errno));
-        throw std::runtime_error(errorMessage);
+        return false;
+    }
+    file.close();
+
+    glProgramBinary(m_programID, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+    GLint success = GL_FALSE;
+    glGetProgramiv(m_programID, GL_LINK_STATUS, &success);
+    if (success == GL_FALSE) {
+        std::cerr << "Shader::loadBinary | Driver rejected the cached program, rebuilding: " << path.string()
+                  << std::endl;
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        return false;
+    }
+
+    return true;
+}
+
+void Shader::storeBinary(uint64_t key) const {
+    GLint length = 0;
+    glGetProgramiv(m_programID, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
     }
 
-    std::stringstream sourceBuffer;
-    sourceBuffer << file.rdbuf();
+    BinaryHeader header{MAGIC, VERSION, key, 0, 0};
+
+    std::vector<char> binary(static_cast<size_t>(length));
+    GLsizei           written = 0;
+    glGetProgramBinary(m_programID, length, &written, &header.format, binary.data());
+    header.size = static_cast<uint32_t>(written);
+
+    const std::filesystem::path path = getBinaryPath(cacheName());
+
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+
+    // write to a temporary file first so a crash never leaves a half written binary behind
+    std::filesystem::path temporaryPath = path;
+    temporaryPath += ".tmp";
+
+    std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(binary.data(), written);
     file.close();
 
-    const std::string sourceString = sourceBuffer.str();
+    if (file.fail()) {
+        std::cerr << "Shader::storeBinary | Failed to write file: " << temporaryPath.string() << std::endl;
+        return;
+    }
+
+    std::filesystem::rename(temporaryPath, path, error);
+}
+
+void Shader::reflect() {
+    m_uniforms.clear();
+    m_uniformBlocks.clear();
 
-    const GLuint shader = glCreateShader(type);
+    GLint count     = 0;
+    GLint maxLength = 0;
 
-    const GLchar* source = sourceString.c_str();
-    glShaderSource(shader, 1, &source, nullptr);
-    glCompileShader(shader);
+    glGetProgramiv(m_programID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(m_programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
 
-    Shader::checkCompileErrors(shader, type);
+    std::string name(static_cast<size_t>(maxLength), '\0');
 
-    glAttachShader(m_programID, shader);
-    glDeleteShader(shader);
+    for (GLint i = 0; i < count; i++) {
+        GLsizei length = 0;
+        GLint   size   = 0;
+        GLenum  type   = 0;
+        glGetActiveUniform(m_programID, i, maxLength, &length, &size, &type, name.data());
+
+        std::string uniformName(name.data(), static_cast<size_t>(length));
+
+        // members of uniform blocks have no location
+        const GLint location = glGetUniformLocation(m_programID, uniformName.c_str());
+        if (location < 0) {
+            continue;
+        }
+
+        // arrays are reported as "name[0]", make them reachable by their plain name as well
+        if (uniformName.ends_with("[0]")) {
+            m_uniforms.emplace(uniformName.substr(0, uniformName.size() - 3), location);
+        }
+        m_uniforms.emplace(std::move(uniformName), location);
+    }
+
+    glGetProgramiv(m_programID, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+    glGetProgramiv(m_programID, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength);
+
+    name.assign(static_cast<size_t>(maxLength), '\0');
+
+    for (GLint i = 0; i < count; i++) {
+        GLsizei length = 0;
+        glGetActiveUniformBlockName(m_programID, i, maxLength, &length, name.data());
+        m_uniformBlocks.emplace(std::string(name.data(), static_cast<size_t>(length)), i);
+    }
 }
 
 void Shader::checkCompileErrors(GLuint shader, Shader::Type type) {
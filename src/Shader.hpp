@@ -5,24 +5,61 @@
 
 #include <string>
 #include <stdexcept>
+#include <unordered_map>
+#include <vector>
 
+// GLSL program built from shader files.
+//
+// add() only reads the sources, link() compiles and links them. Linked programs are kept in a binary cache in the
+// cache directory, keyed on a hash of the sources and the driver's vendor, renderer and version strings, so later runs
+// skip compiling and linking when nothing changed. A binary the driver rejects is deleted and the program is built
+// from source again.
 class Shader {
     private:
+    struct Source {
+        GLenum      type;
+        std::string name;
+        std::string text;
+    };
+
     GLuint m_programID;
     bool   m_linked = false;
 
+    std::vector<Source> m_sources; // added since the last link
+    std::string         m_defines; // #define lines inserted after the #version line of every source
+
+    // cache file of the program, the key identifies its exact sources and driver
+    [[nodiscard]] std::string cacheName() const;
+    [[nodiscard]] uint64_t    cacheKey() const;
+
+    bool loadBinary(uint64_t key);
+    void storeBinary(uint64_t key) const;
+
+    // filled by reflect() when the program is linked
+    std::unordered_map<std::string, GLint>  m_uniforms;
+    std::unordered_map<std::string, GLuint> m_uniformBlocks;
+
+    void reflect();
+
     public:
     enum Type { VERTEX = GL_VERTEX_SHADER, FRAGMENT = GL_FRAGMENT_SHADER, PROGRAM = GL_PROGRAM };
 
+    // Pre-resolved uniform location, resolve it once with getUniform and keep it around.
+    // Uniforms the program doesn't use resolve to -1, which GL silently ignores.
+    struct Uniform {
+        GLint location = -1;
+    };
+
     Shader() noexcept : m_programID(glCreateProgram()) {}
     void deleteShader() const { glDeleteProgram(m_programID); }
 
-    void add(const std::string &shaderName, const Type &type) const;
-    void link() {
-        m_linked = true;
-        glLinkProgram(m_programID);
-        Shader::checkCompileErrors(m_programID, Type::PROGRAM);
-    }
+    void add(const std::string &shaderName, const Type &type);
+
+    // Compiles the shaders added from here on with #define name value
+    void define(const std::string &name, int value = 1);
+
+    // Compile errors of the added shaders are thrown from here
+    void link();
 
     void use() const {
         if (!m_linked) {
@@ -36,22 +73,32 @@ class Shader {
 
     static void checkCompileErrors(GLuint shader, Type type);
 
-    void setBool(const std::string &name, bool value) const {
-        glUniform1i(glGetUniformLocation(m_programID, name.c_str()), (int)value);
-    }
-    void setInt(const std::string &name, int value) const {
-        glUniform1i(glGetUniformLocation(m_programID, name.c_str()), value);
-    }
-    void setUInt(const std::string &name, unsigned int value) const {
-        glUniform1ui(glGetUniformLocation(m_programID, name.c_str()), value);
+    [[nodiscard]] Uniform getUniform(const std::string &name) const {
+        auto iterator = m_uniforms.find(name);
+        return {iterator != m_uniforms.end() ? iterator->second : -1};
     }
-    void setFloat(const std::string &name, float value) const {
-        glUniform1f(glGetUniformLocation(m_programID, name.c_str()), value);
-    }
-    void setVec3(const std::string &name, const glm::vec3 &value) const {
-        glUniform3fv(glGetUniformLocation(m_programID, name.c_str()), 1, &value[0]);
+
+    // GL_INVALID_INDEX if the program has no block with that name
+    [[nodiscard]] GLuint getUniformBlockIndex(const std::string &name) const {
+        auto iterator = m_uniformBlocks.find(name);
+        return iterator != m_uniformBlocks.end() ? iterator->second : GL_INVALID_INDEX;
     }
-    void setMat4(const std::string &name, const glm::mat4 &mat) const {
-        glUniformMatrix4fv(glGetUniformLocation(m_programID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+
+    // the setters apply to the program currently in use
+    static void setBool(Uniform uniform, bool value) { glUniform1i(uniform.location, (int)value); }
+    static void setInt(Uniform uniform, int value) { glUniform1i(uniform.location, value); }
+    static void setUInt(Uniform uniform, unsigned int value) { glUniform1ui(uniform.location, value); }
+    static void setFloat(Uniform uniform, float value) { glUniform1f(uniform.location, value); }
+    static void setVec3(Uniform uniform, const glm::vec3 &value) { glUniform3fv(uniform.location, 1, &value[0]); }
+    static void setMat4(Uniform uniform, const glm::mat4 &mat) {
+        glUniformMatrix4fv(uniform.location, 1, GL_FALSE, &mat[0][0]);
     }
+
+    // convenience overloads for setup code, they go through the reflected locations
+    void setBool(const std::string &name, bool value) const { setBool(getUniform(name), value); }
+    void setInt(const std::string &name, int value) const { setInt(getUniform(name), value); }
+    void setUInt(const std::string &name, unsigned int value) const { setUInt(getUniform(name), value); }
+    void setFloat(const std::string &name, float value) const { setFloat(getUniform(name), value); }
+    void setVec3(const std::string &name, const glm::vec3 &value) const { setVec3(getUniform(name), value); }
+    void setMat4(const std::string &name, const glm::mat4 &mat) const { setMat4(getUniform(name), mat); }
 };
\ No newline at end of file
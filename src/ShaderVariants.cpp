@@ -0,0 +1,64 @@
+#include "ShaderVariants.hpp"
+
+#include <array>
+#include <format>
+#include <iostream>
+
+namespace {
+constexpr std::array<const char *, ShaderVariants::FEATURE_COUNT> FEATURE_NAMES{
+        "HAS_DIFFUSE_MAP", "HAS_SPECULAR_MAP", "HAS_ROUGHNESS_MAP"};
+} // namespace
+
+const Shader &ShaderVariants::get(uint32_t features) {
+    features &= ALL_FEATURES;
+
+    auto iterator = m_variants.find(features);
+    if (iterator != m_variants.end()) {
+        return iterator->second;
+    }
+
+    Shader shader;
+    for (uint32_t bit = 0; bit < FEATURE_COUNT; bit++) {
+        if ((features & (1U << bit)) != 0) {
+            shader.define(FEATURE_NAMES.at(bit));
+        }
+    }
+
+    try {
+        shader.add(m_vertexName, Shader::VERTEX);
+        shader.add(m_fragmentName, Shader::FRAGMENT);
+        shader.link();
+    } catch (const std::runtime_error &error) {
+        shader.deleteShader();
+        throw std::runtime_error(std::format("ShaderVariants::get | {} | {}", describe(features), error.what()));
+    }
+
+    if (m_prepare) {
+        m_prepare(shader);
+    }
+
+    std::cout << std::format("ShaderVariants | {} | variant {} built | {} in use",
+                             m_fragmentName,
+                             describe(features),
+                             m_variants.size() + 1)
+              << std::endl;
+
+    return m_variants.emplace(features, std::move(shader)).first->second;
+}
+
+std::string ShaderVariants::describe(uint32_t features) {
+    std::string names;
+    for (uint32_t bit = 0; bit < FEATURE_COUNT; bit++) {
+        if ((features & (1U << bit)) != 0) {
+            names += names.empty() ? FEATURE_NAMES.at(bit) : std::string(" | ") + FEATURE_NAMES.at(bit);
+        }
+    }
+    return names.empty() ? "none" : names;
+}
+
+void ShaderVariants::deleteShaders() {
+    for (const auto &[features, shader] : m_variants) {
+        shader.deleteShader();
+    }
+    m_variants.clear();
+}
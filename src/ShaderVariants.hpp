@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <Shader.hpp>
+#include <Utility/MemoryUsage.hpp>
+
+// Programs built from the same pair of shader files with different features compiled in.
+//
+// Every feature bit becomes a #define right after the #version line, so the shaders only declare the samplers and
+// compute the terms a material actually has. A variant is compiled the first time its mask is asked for, the program
+// binary cache makes that cheap on later runs.
+class ShaderVariants {
+    public:
+    enum Feature : uint32_t {
+        HAS_DIFFUSE_MAP   = 1 << 0,
+        HAS_SPECULAR_MAP  = 1 << 1,
+        HAS_ROUGHNESS_MAP = 1 << 2,
+    };
+
+    static constexpr uint32_t FEATURE_COUNT = 3;
+    static constexpr uint32_t ALL_FEATURES  = (1 << FEATURE_COUNT) - 1;
+
+    // prepare runs once on every variant after it is linked, e.g. to bind its uniform blocks
+    ShaderVariants(std::string vertexName, std::string fragmentName, std::function<void(const Shader &)> prepare = {})
+            : m_vertexName(std::move(vertexName)), m_fragmentName(std::move(fragmentName)),
+              m_prepare(std::move(prepare)) {}
+
+    // The variant for a feature mask, compiled on first use. Throws when it doesn't compile.
+    const Shader &get(uint32_t features);
+
+    [[nodiscard]] size_t size() const noexcept { return m_variants.size(); }
+
+    // Only the program objects, the driver doesn't tell how large they are
+    [[nodiscard]] MemoryUsage getMemoryUsage() const { return {.glObjects = m_variants.size()}; }
+
+    // Names of the features in a mask, "none" for an empty one
+    static std::string describe(uint32_t features);
+
+    void deleteShaders();
+
+    private:
+    std::string                         m_vertexName;
+    std::string                         m_fragmentName;
+    std::function<void(const Shader &)> m_prepare;
+
+    // references stay valid while the map grows, the render queue keeps pointers to the programs
+    std::unordered_map<uint32_t, Shader> m_variants;
+};
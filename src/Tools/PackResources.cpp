@@ -0,0 +1,33 @@
+// Bakes a resources directory into the archive that fs_helpers mounts at startup:
+//     packResources <resources directory> <archive>
+// The app looks for the archive as resources.pak next to its binary.
+
+#include <format>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include <Utility/ResourceArchive.hpp>
+
+int main(int argc, char **argv) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    const std::vector<std::string_view> arguments(argv + 1, argv + argc);
+    if (arguments.size() != 2) {
+        std::cerr << "Usage: packResources <resources directory> <archive>" << std::endl;
+        return 1;
+    }
+
+    try {
+        const ResourceArchive::Stats stats = ResourceArchive::write(arguments[0], arguments[1]);
+        std::cout << std::format("PackResources | {} files | {:.2f} MiB | {}",
+                                 stats.files,
+                                 static_cast<double>(stats.bytes) / (1024.0 * 1024.0),
+                                 arguments[1])
+                  << std::endl;
+    } catch (const std::exception &error) {
+        std::cerr << "Error packing resources:\n" << error.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,24 @@
+#include "BinaryIO.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace BinaryIO {
+
+void writeBytes(std::ostream &file, std::span<const std::byte> bytes) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    file.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+}
+
+void writePadding(std::ostream &file, uint64_t target) {
+    static constexpr std::array<char, 64> zeros{};
+
+    auto position = static_cast<uint64_t>(file.tellp());
+    while (position < target) {
+        const uint64_t size = std::min<uint64_t>(target - position, zeros.size());
+        file.write(zeros.data(), static_cast<std::streamsize>(size));
+        position += size;
+    }
+}
+
+} // namespace BinaryIO
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+#include "MappedFile.hpp"
+
+// Helpers for the binary formats the app writes itself and maps back, the mesh cache, the KTX files and the resource
+// archive. Values are copied in and out as they are in memory, so the files are only read on the machine that wrote
+// them.
+namespace BinaryIO {
+
+constexpr uint64_t alignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Copy of the T stored at offset, throws when it doesn't fit in the file
+template<typename T>
+T readAt(const MappedFile &file, uint64_t offset) {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    if (offset > file.size() || sizeof(T) > file.size() - offset) {
+        throw std::runtime_error("BinaryIO::readAt | Truncated file");
+    }
+    T value{};
+    std::memcpy(&value, file.data() + offset, sizeof(T)); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    return value;
+}
+
+void writeBytes(std::ostream &file, std::span<const std::byte> bytes);
+
+template<typename T>
+void writeRaw(std::ostream &file, const T &value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    writeBytes(file, std::as_bytes(std::span(&value, 1)));
+}
+
+// Zeros up to the given absolute position
+void writePadding(std::ostream &file, uint64_t target);
+
+} // namespace BinaryIO
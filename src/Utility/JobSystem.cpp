@@ -0,0 +1,239 @@
+#include "JobSystem.hpp"
+
+#include <algorithm>
+
+namespace {
+
+// the scheduler a worker thread belongs to and the index of its queue
+thread_local const JobSystem *t_system = nullptr;
+thread_local size_t           t_queue  = 0;
+
+} // namespace
+
+JobSystem::JobSystem(size_t threadCount) {
+    m_queues.reserve(threadCount + 1);
+    for (size_t i = 0; i <= threadCount; i++) {
+        m_queues.push_back(std::make_unique<Queue>());
+    }
+
+    m_activeWorkers = threadCount;
+
+    m_workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++) {
+        m_workers.emplace_back([this, i]() { workerLoop(i); });
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        const std::lock_guard lock(m_sleepMutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    for (auto &worker : m_workers) {
+        worker.join();
+    }
+}
+
+JobSystem &JobSystem::shared() {
+    // the thread that waits takes part in the work, the workers get the other cores
+    static JobSystem system(std::max(2U, std::thread::hardware_concurrency()) - 1);
+    return system;
+}
+
+void JobSystem::setThreadLimit(size_t threads) {
+    {
+        const std::lock_guard lock(m_sleepMutex);
+        m_activeWorkers = threads == 0 ? m_workers.size() : std::min(threads - 1, m_workers.size());
+    }
+    m_wake.notify_all();
+}
+
+size_t JobSystem::currentQueue() const {
+    return t_system == this ? t_queue : m_workers.size();
+}
+
+void JobSystem::run(Job job, Counter &counter) {
+    counter.m_pending++;
+    push({std::move(job), &counter});
+}
+
+void JobSystem::runAfter(Counter &dependency, Job job, Counter &counter) {
+    counter.m_pending++;
+    {
+        // finish() takes the continuations under the same lock, so the job is either taken by it or started here
+        const std::lock_guard lock(dependency.m_mutex);
+        if (!dependency.isDone()) {
+            dependency.m_continuations.emplace_back(std::move(job), &counter);
+            return;
+        }
+    }
+    push({std::move(job), &counter});
+}
+
+void JobSystem::wait(Counter &counter) {
+    const size_t queue = currentQueue();
+    while (!counter.isDone()) {
+        if (!tryRunOne(queue)) {
+            std::this_thread::yield();
+        }
+    }
+
+    // the job that ended last may still hold the lock
+    std::exception_ptr error;
+    {
+        const std::lock_guard lock(counter.m_mutex);
+        std::swap(error, counter.m_error);
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void JobSystem::parallelFor(size_t count, size_t grain, const RangeFunction &function) {
+    grain = std::max<size_t>(grain, 1);
+    if (count == 0) {
+        return;
+    }
+    if (count <= grain || activeThreads() == 1) {
+        function(0, count);
+        return;
+    }
+
+    // even the first piece runs as a job, so an exception can't leave the others running after the counter is gone
+    Counter counter;
+    run([this, count, grain, &function, &counter]() { splitRange(0, count, grain, function, counter); }, counter);
+    wait(counter);
+}
+
+void JobSystem::parallelFor(size_t count, const std::function<void(size_t)> &function) {
+    parallelFor(count, 1, [&function](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            function(i);
+        }
+    });
+}
+
+void JobSystem::splitRange(size_t begin, size_t end, size_t grain, const RangeFunction &function, Counter &counter) {
+    // the upper halves are queued and the lower one kept, so the front of the deque always holds the largest piece
+    while (end - begin > grain) {
+        const size_t middle = begin + (end - begin) / 2;
+        run([this, middle, end, grain, &function, &counter]() { splitRange(middle, end, grain, function, counter); },
+            counter);
+        end = middle;
+    }
+    function(begin, end);
+}
+
+void JobSystem::push(Task task) {
+    // counted before it can be taken, a worker woken early looks again instead of going back to sleep
+    m_queued++;
+    {
+        Queue                &queue = *m_queues[currentQueue()];
+        const std::lock_guard lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+
+    if (m_sleeping.load() > 0) {
+        {
+            // a worker that checked m_queued before the increment is inside wait() once we get the lock
+            const std::lock_guard lock(m_sleepMutex);
+        }
+        // a worker past the thread limit would swallow a single notification
+        if (m_activeWorkers.load() < m_workers.size()) {
+            m_wake.notify_all();
+        } else {
+            m_wake.notify_one();
+        }
+    }
+}
+
+bool JobSystem::tryRunOne(size_t queue) {
+    if (m_queued.load() == 0) {
+        return false;
+    }
+
+    Task task;
+    bool found = false;
+
+    // the newest job of our own queue, then the oldest of any other
+    {
+        Queue                &own = *m_queues[queue];
+        const std::lock_guard lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            found = true;
+        }
+    }
+
+    for (size_t offset = 1; !found && offset < m_queues.size(); offset++) {
+        Queue                &victim = *m_queues[(queue + offset) % m_queues.size()];
+        const std::lock_guard lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            found = true;
+        }
+    }
+
+    if (!found) {
+        return false;
+    }
+
+    m_queued--;
+    execute(task);
+    return true;
+}
+
+void JobSystem::execute(Task &task) {
+    try {
+        task.job();
+    } catch (...) {
+        const std::lock_guard lock(task.counter->m_mutex);
+        if (!task.counter->m_error) {
+            task.counter->m_error = std::current_exception();
+        }
+    }
+    finish(*task.counter);
+}
+
+void JobSystem::finish(Counter &counter) {
+    std::vector<std::pair<Job, Counter *>> continuations;
+    {
+        // the counter may be gone as soon as the lock is released after the last job
+        const std::lock_guard lock(counter.m_mutex);
+        if (--counter.m_pending != 0) {
+            return;
+        }
+        std::swap(continuations, counter.m_continuations);
+    }
+
+    for (auto &[job, next] : continuations) {
+        push({std::move(job), next});
+    }
+}
+
+void JobSystem::workerLoop(size_t index) {
+    t_system = this;
+    t_queue  = index;
+
+    while (true) {
+        if (index < m_activeWorkers.load() && tryRunOne(index)) {
+            continue;
+        }
+
+        std::unique_lock lock(m_sleepMutex);
+        m_sleeping++;
+        m_wake.wait(lock, [this, index]() {
+            return m_stopping || (index < m_activeWorkers.load() && m_queued.load() > 0);
+        });
+        m_sleeping--;
+
+        if (m_stopping) {
+            return;
+        }
+    }
+}
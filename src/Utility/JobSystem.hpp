@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Work stealing scheduler for the CPU work of a frame.
+//
+// Every worker owns a deque of jobs. It pushes and pops its own jobs at the back, so the piece of work it split last is
+// still in its cache, and idle workers steal from the front of the other deques, where the largest pieces of a
+// recursively split range are. Threads outside the pool share one more deque.
+//
+// Every job belongs to a Counter that drops to zero once all its jobs ended. wait() runs other jobs until then, so
+// jobs can wait on the jobs they started without blocking a worker, and runAfter() chains a job behind a group.
+//
+// Long running work like asset imports stays on the ThreadPool, so it never sits in front of the jobs of a frame.
+class JobSystem {
+    public:
+    using Job           = std::function<void()>;
+    using RangeFunction = std::function<void(size_t begin, size_t end)>;
+
+    // Jobs of a group that haven't ended yet. It has to outlive them, waiting on it before it goes out of scope does.
+    class Counter {
+        public:
+        Counter() = default;
+
+        Counter(const Counter &)            = delete;
+        Counter &operator=(const Counter &) = delete;
+
+        [[nodiscard]] bool isDone() const noexcept { return m_pending.load() == 0; }
+
+        private:
+        friend class JobSystem;
+
+        std::atomic<size_t>                    m_pending{0};
+        std::mutex                             m_mutex;
+        std::vector<std::pair<Job, Counter *>> m_continuations; // jobs of runAfter and their counters
+        std::exception_ptr                     m_error;         // the first exception thrown by a job of the group
+    };
+
+    explicit JobSystem(size_t threadCount);
+    ~JobSystem();
+
+    JobSystem(const JobSystem &)            = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    // Scheduler shared by the whole application, sized to the hardware
+    static JobSystem &shared();
+
+    [[nodiscard]] size_t threadCount() const noexcept { return m_workers.size(); }
+
+    // Lets only threads - 1 workers run jobs, the thread that waits counts as one. 0 lifts the limit. For measuring how
+    // the frame scales, the idle workers sleep.
+    void setThreadLimit(size_t threads);
+
+    // Threads taking part in the work, the calling thread included
+    [[nodiscard]] size_t activeThreads() const noexcept { return m_activeWorkers.load() + 1; }
+
+    void run(Job job, Counter &counter);
+
+    // Queues job once every job of dependency ended, job counts towards counter right away
+    void runAfter(Counter &dependency, Job job, Counter &counter);
+
+    // Runs queued jobs until every job of counter ended, then rethrows the first exception one of them threw
+    void wait(Counter &counter);
+
+    // Calls function(begin, end) on ranges of at most grain items covering [0, count) and waits for all of them. The
+    // range is split in halves, so a thief takes half of what is left in one go. Calls function(0, count) on the
+    // calling thread when it is alone or the range is a single piece.
+    void parallelFor(size_t count, size_t grain, const RangeFunction &function);
+
+    // Calls function(i) for every i in [0, count), one item per job
+    void parallelFor(size_t count, const std::function<void(size_t)> &function);
+
+    private:
+    struct Task {
+        Job      job;
+        Counter *counter = nullptr;
+    };
+
+    struct Queue {
+        std::mutex       mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::thread>            m_workers;
+    std::vector<std::unique_ptr<Queue>> m_queues; // one per worker, then the one of the outside threads
+
+    std::atomic<size_t>     m_activeWorkers{0};
+    std::atomic<size_t>     m_queued{0};   // tasks in all the queues
+    std::atomic<size_t>     m_sleeping{0}; // workers waiting on m_wake
+    std::mutex              m_sleepMutex;
+    std::condition_variable m_wake;
+    bool                    m_stopping = false;
+
+    // queue of the calling thread, the shared one for threads outside the pool
+    [[nodiscard]] size_t currentQueue() const;
+
+    void push(Task task);
+    bool tryRunOne(size_t queue);
+    void execute(Task &task);
+    void finish(Counter &counter);
+    void workerLoop(size_t index);
+
+    void splitRange(size_t begin, size_t end, size_t grain, const RangeFunction &function, Counter &counter);
+};
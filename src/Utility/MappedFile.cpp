@@ -0,0 +1,114 @@
+#include "MappedFile.hpp"
+
+#include <format>
+#include <stdexcept>
+#include <utility>
+
+#ifdef __WIN32__
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::filesystem::path &path) {
+#ifdef __WIN32__
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error(std::format("MappedFile | Failed to open file: {}", path.string()));
+    }
+
+    LARGE_INTEGER fileSize{};
+    GetFileSizeEx(file, &fileSize);
+    m_size       = static_cast<size_t>(fileSize.QuadPart);
+    m_fileHandle = file;
+
+    if (m_size == 0) {
+        return;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        unmap();
+        throw std::runtime_error(std::format("MappedFile | Failed to map file: {}", path.string()));
+    }
+
+    m_mappingHandle = mapping;
+    m_data          = static_cast<const std::byte *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+    const int fd = open(path.c_str(), O_RDONLY); // NOLINT(cppcoreguidelines-pro-type-vararg)
+    if (fd < 0) {
+        throw std::runtime_error(
+                std::format("MappedFile | Failed to open file: {} | System Error: {}", path.string(), errno));
+    }
+
+    struct stat fileStat {};
+    if (fstat(fd, &fileStat) != 0) {
+        close(fd);
+        throw std::runtime_error(std::format("MappedFile | Failed to stat file: {}", path.string()));
+    }
+
+    m_size = static_cast<size_t>(fileStat.st_size);
+
+    if (m_size > 0) {
+        void *mapping = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) { // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+            close(fd);
+            throw std::runtime_error(
+                    std::format("MappedFile | Failed to map file: {} | System Error: {}", path.string(), errno));
+        }
+        m_data = static_cast<const std::byte *>(mapping);
+    }
+
+    // the mapping keeps its own reference to the file
+    close(fd);
+#endif
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+        : m_data(std::exchange(other.m_data, nullptr)),
+          m_size(std::exchange(other.m_size, 0))
+#ifdef __WIN32__
+          ,
+          m_fileHandle(std::exchange(other.m_fileHandle, nullptr)),
+          m_mappingHandle(std::exchange(other.m_mappingHandle, nullptr))
+#endif
+{
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+        unmap();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+#ifdef __WIN32__
+        m_fileHandle    = std::exchange(other.m_fileHandle, nullptr);
+        m_mappingHandle = std::exchange(other.m_mappingHandle, nullptr);
+#endif
+    }
+    return *this;
+}
+
+void MappedFile::unmap() noexcept {
+#ifdef __WIN32__
+    if (m_data != nullptr) {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mappingHandle != nullptr) {
+        CloseHandle(m_mappingHandle);
+    }
+    if (m_fileHandle != nullptr) {
+        CloseHandle(m_fileHandle);
+    }
+    m_fileHandle    = nullptr;
+    m_mappingHandle = nullptr;
+#else
+    if (m_data != nullptr) {
+        munmap(const_cast<std::byte *>(m_data), m_size); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+    }
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
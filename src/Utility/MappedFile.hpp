@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+// Read-only memory mapping of a whole file. The mapping lives as long as the object.
+class MappedFile {
+    public:
+    MappedFile() = default;
+    explicit MappedFile(const std::filesystem::path &path);
+    ~MappedFile() { unmap(); }
+
+    MappedFile(const MappedFile &)            = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    [[nodiscard]] bool                        isOpen() const noexcept { return m_data != nullptr; }
+    [[nodiscard]] const std::byte            *data() const noexcept { return m_data; }
+    [[nodiscard]] size_t                      size() const noexcept { return m_size; }
+    [[nodiscard]] std::span<const std::byte> bytes() const noexcept { return {m_data, m_size}; }
+
+    private:
+    const std::byte *m_data = nullptr;
+    size_t           m_size = 0;
+
+#ifdef __WIN32__
+    void *m_fileHandle    = nullptr;
+    void *m_mappingHandle = nullptr;
+#endif
+
+    void unmap() noexcept;
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+
+// Memory held by a part of the renderer. The GPU sizes are what was asked of the driver, which may pad them, and
+// objects shared by several owners, like the geometry arenas, are only counted by the one that creates them.
+struct MemoryUsage {
+    size_t cpuBytes     = 0; // heap allocations
+    size_t mappedBytes  = 0; // mapped cache files, paged in on demand and backed by the file
+    size_t bufferBytes  = 0; // GPU buffer objects
+    size_t textureBytes = 0; // every resident mip level
+    size_t glObjects    = 0; // buffers, textures, vertex arrays, programs and framebuffer objects
+
+    MemoryUsage &operator+=(const MemoryUsage &other) noexcept {
+        cpuBytes += other.cpuBytes;
+        mappedBytes += other.mappedBytes;
+        bufferBytes += other.bufferBytes;
+        textureBytes += other.textureBytes;
+        glObjects += other.glObjects;
+        return *this;
+    }
+};
@@ -0,0 +1,141 @@
+#include "Profiler.hpp"
+
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+Profiler &Profiler::shared() {
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler::Profiler() : m_epoch(std::chrono::steady_clock::now()), m_slots(CAPACITY) {}
+
+uint64_t Profiler::now() const {
+    return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_epoch).count());
+}
+
+uint32_t Profiler::threadId() {
+    static std::atomic<uint32_t> next{GPU_THREAD + 1};
+    thread_local const uint32_t  id = next.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+void Profiler::record(const char *name, uint64_t start, uint64_t duration, uint32_t thread) {
+    const uint64_t index = m_head.fetch_add(1, std::memory_order_relaxed);
+    Slot          &slot  = m_slots[index % CAPACITY];
+
+    // invalidate first, so a reader never pairs the old sequence with the new fields
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.start.store(start, std::memory_order_relaxed);
+    slot.duration.store(duration, std::memory_order_relaxed);
+    slot.thread.store(thread, std::memory_order_relaxed);
+    slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+bool Profiler::beginGpu(const char *name, uint64_t start) {
+    if (m_gpuActive) {
+        return false;
+    }
+
+    QueryPool &pool  = m_pools.at(m_currentPool);
+    GLuint     query = 0;
+    if (pool.free.empty()) {
+        glGenQueries(1, &query);
+    } else {
+        query = pool.free.back();
+        pool.free.pop_back();
+    }
+
+    glBeginQuery(GL_TIME_ELAPSED, query);
+    pool.pending.push_back({query, name, start});
+    m_gpuActive = true;
+    return true;
+}
+
+void Profiler::endGpu() {
+    glEndQuery(GL_TIME_ELAPSED);
+    m_gpuActive = false;
+}
+
+void Profiler::endFrame() {
+    // the other pool holds the queries of the previous frame, the GPU had a whole frame to finish them
+    m_currentPool   = 1 - m_currentPool;
+    QueryPool &pool = m_pools.at(m_currentPool);
+
+    for (const auto &pending : pool.pending) {
+        GLint available = 0;
+        glGetQueryObjectiv(pending.query, GL_QUERY_RESULT_AVAILABLE, &available);
+
+        if (available == GL_TRUE) {
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(pending.query, GL_QUERY_RESULT, &elapsed);
+            record(pending.name, pending.start, elapsed, GPU_THREAD);
+            pool.free.push_back(pending.query);
+        } else {
+            // the query can't be reused until it finished, let it go instead
+            glDeleteQueries(1, &pending.query);
+            m_droppedGpuZones++;
+        }
+    }
+    pool.pending.clear();
+}
+
+void Profiler::exportChromeTrace(const std::filesystem::path &path) const {
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error(std::format("Profiler::exportChromeTrace | Failed to open {}", path.string()));
+    }
+
+    file << R"({"displayTimeUnit": "ms", "traceEvents": [)" << '\n';
+    file << std::format(R"({{"name": "thread_name", "ph": "M", "pid": 1, "tid": {}, "args": {{"name": "GPU"}}}})",
+                        GPU_THREAD);
+
+    const uint64_t head  = m_head.load(std::memory_order_acquire);
+    const uint64_t first = head > CAPACITY ? head - CAPACITY : 0;
+
+    for (uint64_t index = first; index < head; index++) {
+        const Slot &slot = m_slots[index % CAPACITY];
+
+        if (slot.sequence.load(std::memory_order_acquire) != index + 1) {
+            continue;
+        }
+        const char    *name     = slot.name.load(std::memory_order_relaxed);
+        const uint64_t start    = slot.start.load(std::memory_order_relaxed);
+        const uint64_t duration = slot.duration.load(std::memory_order_relaxed);
+        const uint32_t thread   = slot.thread.load(std::memory_order_relaxed);
+
+        // skip the slot if a writer took it over while it was read
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != index + 1) {
+            continue;
+        }
+
+        file << std::format(",\n"
+                            R"({{"name": "{}", "ph": "X", "pid": 1, "tid": {}, "ts": {:.3f}, "dur": {:.3f}}})",
+                            name,
+                            thread,
+                            static_cast<double>(start) / 1000.0,
+                            static_cast<double>(duration) / 1000.0);
+    }
+
+    file << "\n]}\n";
+}
+
+void Profiler::deleteQueries() {
+    for (auto &pool : m_pools) {
+        for (const GLuint query : pool.free) {
+            glDeleteQueries(1, &query);
+        }
+        for (const auto &pending : pool.pending) {
+            glDeleteQueries(1, &pending.query);
+        }
+        pool.free.clear();
+        pool.pending.clear();
+    }
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <Utility/OpenGlHeaders.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+// Scoped CPU and GPU timing zones, recorded into a ring buffer and exported in the Chrome trace event format
+// (chrome://tracing or https://ui.perfetto.dev).
+//
+// CPU zones can be opened on any thread, recording is lock free and the oldest events are overwritten once the ring is
+// full. GPU zones wrap a GL_TIME_ELAPSED query and must only be used on the context thread. Those queries can't nest,
+// a GPU zone opened inside another one only records its CPU side. Their results are read one frame late from a double
+// buffered query pool, a result that still isn't available then is dropped instead of waiting for the GPU.
+//
+// Use the PROFILE_* macros, with ENABLE_PROFILER undefined they expand to nothing.
+class Profiler {
+    public:
+    static constexpr size_t CAPACITY = size_t{1} << 16; // events
+
+    // GPU events are shown on their own track with this thread id
+    static constexpr uint32_t GPU_THREAD = 0;
+
+    static Profiler &shared();
+
+    Profiler(const Profiler &)            = delete;
+    Profiler &operator=(const Profiler &) = delete;
+
+    // Nanoseconds since the profiler was created
+    [[nodiscard]] uint64_t now() const;
+
+    // name has to outlive the profiler, zones are named with string literals
+    void record(const char *name, uint64_t start, uint64_t duration, uint32_t thread);
+
+    // Opens and closes the GL_TIME_ELAPSED query of a GPU zone, beginGpu returns false if a query is already running
+    bool beginGpu(const char *name, uint64_t start);
+    void endGpu();
+
+    // Collects the GPU results of the previous frame and switches the query pools, call once per frame on the context
+    // thread
+    void endFrame();
+
+    // Writes the events still in the ring, oldest first
+    void exportChromeTrace(const std::filesystem::path &path) const;
+
+    [[nodiscard]] size_t droppedGpuZones() const noexcept { return m_droppedGpuZones; }
+
+    void deleteQueries();
+
+    // Small dense id of the calling thread, starting at 1
+    static uint32_t threadId();
+
+    class Zone {
+        public:
+        explicit Zone(const char *name) : m_name(name), m_start(shared().now()) {}
+        ~Zone() { shared().record(m_name, m_start, shared().now() - m_start, threadId()); }
+
+        Zone(const Zone &)            = delete;
+        Zone &operator=(const Zone &) = delete;
+
+        private:
+        const char *m_name;
+        uint64_t    m_start;
+    };
+
+    class GpuZone {
+        public:
+        explicit GpuZone(const char *name) : m_cpu(name), m_active(shared().beginGpu(name, shared().now())) {}
+        ~GpuZone() {
+            if (m_active) {
+                shared().endGpu();
+            }
+        }
+
+        GpuZone(const GpuZone &)            = delete;
+        GpuZone &operator=(const GpuZone &) = delete;
+
+        private:
+        Zone m_cpu;
+        bool m_active;
+    };
+
+    private:
+    Profiler();
+
+    // every field is atomic so the exporter can read slots that are being overwritten, sequence tells it whether the
+    // slot holds the event it expects
+    struct Slot {
+        std::atomic<uint64_t>     sequence{0}; // index + 1 of the event once it is completely written
+        std::atomic<const char *> name{nullptr};
+        std::atomic<uint64_t>     start{0};
+        std::atomic<uint64_t>     duration{0};
+        std::atomic<uint32_t>     thread{0};
+    };
+
+    struct PendingQuery {
+        GLuint      query;
+        const char *name;
+        uint64_t    start;
+    };
+
+    // queries issued during one frame, the pool of a frame is reused two frames later
+    struct QueryPool {
+        std::vector<GLuint>       free;
+        std::vector<PendingQuery> pending;
+    };
+
+    std::chrono::steady_clock::time_point m_epoch;
+
+    std::vector<Slot>     m_slots;
+    std::atomic<uint64_t> m_head{0};
+
+    std::array<QueryPool, 2> m_pools;
+    size_t                   m_currentPool     = 0;
+    bool                     m_gpuActive       = false;
+    size_t                   m_droppedGpuZones = 0;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b)       PROFILE_CONCAT_INNER(a, b)
+
+#ifdef ENABLE_PROFILER
+#define PROFILE_ZONE(name)     const Profiler::Zone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_GPU_ZONE(name) const Profiler::GpuZone PROFILE_CONCAT(profileGpuZone, __LINE__)(name)
+#define PROFILE_FRAME()        Profiler::shared().endFrame()
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_GPU_ZONE(name)
+#define PROFILE_FRAME()
+#endif
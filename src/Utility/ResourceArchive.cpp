@@ -0,0 +1,169 @@
+#include "ResourceArchive.hpp"
+
+#include <algorithm>
+#include <array>
+#include <format>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+#include "BinaryIO.hpp"
+
+namespace {
+
+using BinaryIO::alignUp;
+using BinaryIO::readAt;
+using BinaryIO::writePadding;
+using BinaryIO::writeRaw;
+
+constexpr std::array<char, 4> MAGIC{'R', 'P', 'A', 'K'};
+constexpr uint32_t            VERSION = 1;
+
+struct FileHeader {
+    std::array<char, 4> magic;
+    uint32_t            version;
+    uint64_t            entryCount;
+    uint64_t            entryTableOffset;
+    uint64_t            namesOffset;
+    uint64_t            namesSize;
+    uint64_t            fileSize;
+};
+
+} // namespace
+
+ResourceArchive::ResourceArchive(const std::filesystem::path &path) : m_file(path) {
+    const auto header = readAt<FileHeader>(m_file, 0);
+    if (header.magic != MAGIC || header.version != VERSION || header.fileSize != m_file.size()) {
+        throw std::runtime_error(std::format("ResourceArchive | Not a resource archive: {}", path.string()));
+    }
+
+    // checked without overflowing, a corrupted count must not reach reserve()
+    const uint64_t size = m_file.size();
+    if (header.namesOffset > size || header.namesSize > size - header.namesOffset ||
+        header.entryTableOffset > size || header.entryCount > (size - header.entryTableOffset) / sizeof(Entry)) {
+        throw std::runtime_error("ResourceArchive | Truncated archive");
+    }
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast, cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    m_names = {reinterpret_cast<const char *>(m_file.data() + header.namesOffset), header.namesSize};
+
+    m_entries.reserve(header.entryCount);
+    for (uint64_t i = 0; i < header.entryCount; i++) {
+        const auto entry = readAt<Entry>(m_file, header.entryTableOffset + i * sizeof(Entry));
+        if (entry.offset > size || entry.size > size - entry.offset ||
+            static_cast<uint64_t>(entry.nameOffset) + entry.nameLength > m_names.size()) {
+            throw std::runtime_error(std::format("ResourceArchive | Entry out of bounds in {}", path.string()));
+        }
+        m_entries.push_back(entry);
+    }
+}
+
+ResourceArchive::Stats ResourceArchive::write(const std::filesystem::path &directory,
+                                              const std::filesystem::path &path) {
+    std::vector<std::filesystem::path> files;
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(directory)) {
+        if (entry.is_regular_file()) {
+            files.push_back(entry.path());
+        }
+    }
+
+    std::vector<std::string> names;
+    names.reserve(files.size());
+    for (const auto &file : files) {
+        names.push_back(file.lexically_relative(directory).generic_string());
+    }
+
+    // the lookup is a binary search over the names
+    std::vector<size_t> order(files.size());
+    std::iota(order.begin(), order.end(), size_t{0});
+    std::ranges::sort(order, [&names](size_t a, size_t b) { return names[a] < names[b]; });
+
+    std::string        namesBlob;
+    std::vector<Entry> entries;
+    entries.reserve(files.size());
+    for (const size_t index : order) {
+        Entry entry{};
+        const auto modified = std::filesystem::last_write_time(files[index]).time_since_epoch().count();
+
+        entry.size       = std::filesystem::file_size(files[index]);
+        entry.modified   = static_cast<int64_t>(modified);
+        entry.nameOffset = static_cast<uint32_t>(namesBlob.size());
+        entry.nameLength = static_cast<uint32_t>(names[index].size());
+        namesBlob += names[index];
+        entries.push_back(entry);
+    }
+
+    FileHeader header{};
+    header.magic            = MAGIC;
+    header.version          = VERSION;
+    header.entryCount       = entries.size();
+    header.entryTableOffset = sizeof(FileHeader);
+    header.namesOffset      = header.entryTableOffset + entries.size() * sizeof(Entry);
+    header.namesSize        = namesBlob.size();
+
+    uint64_t offset = header.namesOffset + header.namesSize;
+    for (auto &entry : entries) {
+        entry.offset = alignUp(offset, DATA_ALIGNMENT);
+        offset       = entry.offset + entry.size;
+    }
+    header.fileSize = offset;
+
+    // write to a temporary file first so a crash never leaves a half written archive behind
+    std::filesystem::path temporaryPath = path;
+    temporaryPath += ".tmp";
+
+    std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+    if (file.fail()) {
+        throw std::runtime_error(
+                std::format("ResourceArchive::write | Failed to open file: {}", temporaryPath.string()));
+    }
+
+    writeRaw(file, header);
+    for (const auto &entry : entries) {
+        writeRaw(file, entry);
+    }
+    file.write(namesBlob.data(), static_cast<std::streamsize>(namesBlob.size()));
+
+    for (size_t i = 0; i < entries.size(); i++) {
+        const std::filesystem::path &source = files[order[i]];
+
+        // mapped so a large model doesn't have to fit into a buffer, empty files have nothing to map
+        writePadding(file, entries[i].offset);
+        if (entries[i].size > 0) {
+            const MappedFile contents(source);
+            if (contents.size() != entries[i].size) {
+                throw std::runtime_error(
+                        std::format("ResourceArchive::write | File changed while packing: {}", source.string()));
+            }
+            BinaryIO::writeBytes(file, contents.bytes());
+        }
+    }
+
+    file.close();
+    if (file.fail()) {
+        throw std::runtime_error(
+                std::format("ResourceArchive::write | Failed to write file: {}", temporaryPath.string()));
+    }
+
+    std::filesystem::rename(temporaryPath, path);
+    return {entries.size(), header.fileSize};
+}
+
+std::optional<ResourceArchive::Entry> ResourceArchive::find(std::string_view name) const {
+    const auto iterator = std::ranges::lower_bound(m_entries, name, {}, [this](const Entry &entry) {
+        return this->name(entry);
+    });
+    if (iterator == m_entries.end() || this->name(*iterator) != name) {
+        return std::nullopt;
+    }
+    return *iterator;
+}
+
+std::span<const std::byte> ResourceArchive::contents(const Entry &entry) const {
+    return m_file.bytes().subspan(entry.offset, entry.size);
+}
+
+std::string_view ResourceArchive::name(const Entry &entry) const {
+    return m_names.substr(entry.nameOffset, entry.nameLength);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "MappedFile.hpp"
+
+// Single file holding a whole resources directory, built by the packResources tool.
+//
+// The file starts with a header and a table of the files sorted by name, names are paths relative to the packed
+// directory with '/' separators. The contents follow, every file aligned to DATA_ALIGNMENT. The archive is memory
+// mapped and a lookup returns a span into the mapping, nothing is copied or decompressed.
+class ResourceArchive {
+    public:
+    static constexpr uint64_t DATA_ALIGNMENT = 64;
+
+    struct Entry {
+        uint64_t offset;
+        uint64_t size;
+        int64_t  modified; // last write time of the packed file, in ticks of std::filesystem::file_time_type
+        uint32_t nameOffset;
+        uint32_t nameLength;
+    };
+
+    struct Stats {
+        size_t files = 0;
+        size_t bytes = 0; // of the archive
+    };
+
+    // Maps an archive, throws when it isn't one or it is truncated
+    explicit ResourceArchive(const std::filesystem::path &path);
+
+    // Packs every regular file below directory, the archive is written to a temporary file and renamed when complete
+    static Stats write(const std::filesystem::path &directory, const std::filesystem::path &path);
+
+    // name is relative to the packed directory, with '/' separators
+    [[nodiscard]] std::optional<Entry>        find(std::string_view name) const;
+    [[nodiscard]] std::span<const std::byte> contents(const Entry &entry) const;
+
+    [[nodiscard]] size_t size() const noexcept { return m_entries.size(); }
+
+    private:
+    MappedFile         m_file;
+    std::vector<Entry> m_entries; // sorted by name
+    std::string_view   m_names;
+
+    [[nodiscard]] std::string_view name(const Entry &entry) const;
+};
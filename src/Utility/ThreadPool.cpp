@@ -0,0 +1,108 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <exception>
+
+ThreadPool::ThreadPool(size_t threadCount) {
+    m_workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++) {
+        m_workers.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        const std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+
+    for (auto &worker : m_workers) {
+        worker.join();
+    }
+}
+
+ThreadPool &ThreadPool::shared() {
+    // leave one core to the thread that owns the GL context
+    static ThreadPool pool(std::max(2U, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+    {
+        const std::lock_guard lock(m_mutex);
+        m_tasks.push(std::move(task));
+    }
+    m_condition.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+
+            if (m_stopping && m_tasks.empty()) {
+                return;
+            }
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)> &function) {
+    if (count == 0) {
+        return;
+    }
+
+    // helpers may still be queued after the call returned, so everything they touch is reference counted
+    struct State {
+        std::function<void(size_t)> function;
+        size_t                      count;
+        std::atomic<size_t>         next{0};
+        std::atomic<size_t>         finished{0};
+        std::exception_ptr          error;
+        std::mutex                  mutex;
+        std::condition_variable     done;
+    };
+
+    auto state      = std::make_shared<State>();
+    state->function = function;
+    state->count    = count;
+
+    auto work = [](State &shared) {
+        for (size_t i = shared.next.fetch_add(1); i < shared.count; i = shared.next.fetch_add(1)) {
+            try {
+                shared.function(i);
+            } catch (...) {
+                const std::lock_guard lock(shared.mutex);
+                if (!shared.error) {
+                    shared.error = std::current_exception();
+                }
+            }
+
+            if (shared.finished.fetch_add(1) + 1 == shared.count) {
+                const std::lock_guard lock(shared.mutex);
+                shared.done.notify_all();
+            }
+        }
+    };
+
+    const size_t helpers = std::min(count - 1, m_workers.size());
+    for (size_t i = 0; i < helpers; i++) {
+        enqueue([state, work]() { work(*state); });
+    }
+
+    work(*state);
+
+    std::unique_lock lock(state->mutex);
+    state->done.wait(lock, [&state]() { return state->finished.load() == state->count; });
+
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
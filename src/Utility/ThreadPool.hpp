@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed size pool of worker threads for CPU work that doesn't touch the GL context
+class ThreadPool {
+    public:
+    explicit ThreadPool(size_t threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &)            = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Pool shared by the whole application, sized to the hardware
+    static ThreadPool &shared();
+
+    [[nodiscard]] size_t threadCount() const noexcept { return m_workers.size(); }
+
+    template<typename F>
+    std::future<std::invoke_result_t<F>> submit(F &&function) {
+        using Result = std::invoke_result_t<F>;
+
+        auto task   = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(function));
+        auto future = task->get_future();
+        enqueue([task]() { (*task)(); });
+        return future;
+    }
+
+    // Calls function(i) for every i in [0, count). The calling thread takes part in the work, so it is safe to call
+    // from inside a task running on this pool. The first exception thrown by a call is rethrown once all calls ended.
+    void parallelFor(size_t count, const std::function<void(size_t)> &function);
+
+    private:
+    std::vector<std::thread>          m_workers;
+    std::queue<std::function<void()>> m_tasks;
+    std::mutex                        m_mutex;
+    std::condition_variable           m_condition;
+    bool                              m_stopping = false;
+
+    void enqueue(std::function<void()> task);
+    void workerLoop();
+};
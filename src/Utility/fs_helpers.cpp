@@ -1,7 +1,11 @@
 #include "fs_helpers.hpp"
 
 #include <filesystem>
+#include <iostream>
 #include <string>
+#include <utility>
+
+#include "ResourceArchive.hpp"
 
 #ifdef __WIN32__
 #include <Windows.h>
@@ -40,6 +44,14 @@ std::filesystem::path getPathToModelsDirectory() {
     return getPathToResourcesDirectory() / "models";
 }
 
+std::filesystem::path getPathToCacheDirectory() {
+    return getPathToBinaryDirectory() / "cache";
+}
+
+std::filesystem::path getPathToBenchmarksDirectory() {
+    return getPathToResourcesDirectory() / "benchmarks";
+}
+
 std::filesystem::path getPathToShader(const std::string& shaderName) {
     return shaderName.starts_with("/") ? std::filesystem::path(shaderName) : getPathToShadersDirectory() / shaderName;
 }
@@ -53,8 +65,81 @@ std::filesystem::path getPathToModel(const std::string& modelName) {
     return modelName.starts_with("/") ? std::filesystem::path(modelName) : getPathToModelsDirectory() / modelName;
 }
 
+std::filesystem::path getPathToBenchmark(const std::string& benchmarkName) {
+    return benchmarkName.starts_with("/") ? std::filesystem::path(benchmarkName)
+                                          : getPathToBenchmarksDirectory() / benchmarkName;
+}
+
 bool isAbsolutePath(const std::string& path) {
     return path.starts_with("/");
 }
 
+namespace {
+
+// Mounted on first use, the initialization of the static is thread safe
+const ResourceArchive* getArchive() {
+    static const std::optional<ResourceArchive> archive = []() -> std::optional<ResourceArchive> {
+        const std::filesystem::path path = getPathToArchive();
+
+        std::error_code error;
+        if (!std::filesystem::exists(path, error)) {
+            return std::nullopt;
+        }
+
+        try {
+            std::optional<ResourceArchive> mounted(std::in_place, path);
+            std::cout << "fs_helpers | " << mounted->size() << " resources packed in " << path.string() << std::endl;
+            return mounted;
+        } catch (const std::runtime_error& error) {
+            std::cerr << "fs_helpers | Ignoring resource archive: " << error.what() << std::endl;
+            return std::nullopt;
+        }
+    }();
+    return archive.has_value() ? &archive.value() : nullptr;
+}
+
+std::optional<ResourceArchive::Entry> findPacked(const std::filesystem::path& path) {
+    const ResourceArchive* archive = getArchive();
+    if (archive == nullptr) {
+        return std::nullopt;
+    }
+
+    const std::filesystem::path relative = path.lexically_normal().lexically_relative(getPathToResourcesDirectory());
+    if (relative.empty() || *relative.begin() == "..") {
+        return std::nullopt;
+    }
+    return archive->find(relative.generic_string());
+}
+
+} // namespace
+
+std::filesystem::path getPathToArchive() {
+    return getPathToBinaryDirectory() / "resources.pak";
+}
+
+std::optional<Resource> openResource(const std::filesystem::path& path) {
+    if (auto entry = findPacked(path)) {
+        return Resource(getArchive()->contents(*entry));
+    }
+
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(path, error)) {
+        return std::nullopt;
+    }
+    return Resource(MappedFile(path));
+}
+
+bool resourceExists(const std::filesystem::path& path) {
+    std::error_code error;
+    return findPacked(path).has_value() || std::filesystem::is_regular_file(path, error);
+}
+
+ResourceStamp getResourceStamp(const std::filesystem::path& path) {
+    if (auto entry = findPacked(path)) {
+        return {entry->size, entry->modified};
+    }
+    return {std::filesystem::file_size(path),
+            static_cast<int64_t>(std::filesystem::last_write_time(path).time_since_epoch().count())};
+}
+
 } // namespace fs_helpers
\ No newline at end of file
@@ -1,7 +1,15 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <filesystem>
+#include <optional>
+#include <span>
+#include <utility>
+
+#include "MappedFile.hpp"
 
 namespace fs_helpers {
 std::filesystem::path getPathToBinary();
@@ -10,10 +18,49 @@ std::filesystem::path getPathToResourcesDirectory();
 std::filesystem::path getPathToShadersDirectory();
 std::filesystem::path getPathToTexturesDirectory();
 std::filesystem::path getPathToModelsDirectory();
+std::filesystem::path getPathToCacheDirectory();
+std::filesystem::path getPathToBenchmarksDirectory();
 
 std::filesystem::path getPathToShader(const std::string& shaderName);
 std::filesystem::path getPathToTexture(const std::string& textureName);
 std::filesystem::path getPathToModel(const std::string& modelName);
+std::filesystem::path getPathToBenchmark(const std::string& benchmarkName);
 
 bool isAbsolutePath(const std::string& path);
+
+// The archive built by packResources, resources.pak next to the binary. Files below the resources directory are looked
+// up in it first and read from disk when it is missing or doesn't have them, so loose files keep working while
+// developing.
+std::filesystem::path getPathToArchive();
+
+// Contents of a resource without copying them, a span into the mapped archive or a mapping of the loose file
+class Resource {
+    public:
+    explicit Resource(std::span<const std::byte> packed) : m_bytes(packed) {}
+    explicit Resource(MappedFile file) : m_file(std::move(file)), m_bytes(m_file.bytes()) {}
+
+    [[nodiscard]] std::span<const std::byte> bytes() const noexcept { return m_bytes; }
+    [[nodiscard]] size_t                     size() const noexcept { return m_bytes.size(); }
+
+    [[nodiscard]] std::string_view text() const noexcept {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        return {reinterpret_cast<const char*>(m_bytes.data()), m_bytes.size()};
+    }
+
+    private:
+    MappedFile                 m_file;
+    std::span<const std::byte> m_bytes;
+};
+
+// nullopt when neither the archive nor the disk has the file
+std::optional<Resource> openResource(const std::filesystem::path& path);
+bool                    resourceExists(const std::filesystem::path& path);
+
+// Size and last write time of a resource, for keying caches on it. Throws when it doesn't exist.
+struct ResourceStamp {
+    uint64_t size;
+    int64_t  modified; // ticks of std::filesystem::file_time_type
+};
+
+ResourceStamp getResourceStamp(const std::filesystem::path& path);
 } // namespace fs_helpers
\ No newline at end of file
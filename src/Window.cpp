@@ -5,11 +5,14 @@
 #include <string>
 #include <stdexcept>
 
-GLFWwindow* createMainWindow(int width, int height, const char* window_name) {
-    glfwInit();
+GLFWwindow* createMainWindow(int width, int height, const char* window_name, bool visible) {
+    if (glfwInit() != GLFW_TRUE) {
+        throw std::runtime_error("createMainWindow | Failed to initialize GLFW");
+    }
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
 
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
@@ -2,4 +2,5 @@
 
 #include <Utility/OpenGlHeaders.hpp>
 
-GLFWwindow* createMainWindow(int width, int height, const char* window_name);
\ No newline at end of file
+// A hidden window only provides the context, headless runs render into an OffscreenTarget
+GLFWwindow* createMainWindow(int width, int height, const char* window_name, bool visible = true);
\ No newline at end of file
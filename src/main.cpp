@@ -4,53 +4,224 @@
 #include <glm/glm.hpp>
 #include "glm/gtc/matrix_transform.hpp"
 
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <format>
 #include <iostream>
+#include <filesystem>
 #include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 #include <Camera.hpp>
+#include <FrameUniforms.hpp>
 #include <Shader.hpp>
+#include <ShaderVariants.hpp>
 #include <Window.hpp>
+#include <Benchmark/BenchmarkRecorder.hpp>
+#include <Benchmark/Benchmarks.hpp>
+#include <Benchmark/CameraPath.hpp>
+#include <Model/AssetStreamer.hpp>
+#include <Model/CompressedImage.hpp>
+#include <Model/GeometryArena.hpp>
+#include <Model/Material.hpp>
 #include <Model/Model.hpp>
+#include <Model/TextureManager.hpp>
+#include <Render/FrustumCuller.hpp>
+#include <Render/LightClusters.hpp>
+#include <Render/OcclusionCuller.hpp>
+#include <Render/OffscreenTarget.hpp>
+#include <Render/RenderQueue.hpp>
+#include <Render/StreamBuffer.hpp>
+#include <Scene/SceneGraph.hpp>
 #include <Utility/Input.hpp>
+#include <Utility/Profiler.hpp>
+#include <Utility/fs_helpers.hpp>
+
+// Value of the first --name=value argument with the given prefix
+std::optional<std::string_view> argumentValue(const std::vector<std::string_view> &arguments, std::string_view prefix) {
+    for (const auto argument : arguments) {
+        if (argument.starts_with(prefix)) {
+            return argument.substr(prefix.size());
+        }
+    }
+    return std::nullopt;
+}
+
+// Parses the first --name=N argument with the given prefix into value, which is left alone when it isn't given. Prints
+// the argument and returns false when it isn't a whole number.
+bool numericArgument(const std::vector<std::string_view> &arguments, std::string_view prefix, size_t &value) {
+    const auto argument = argumentValue(arguments, prefix);
+    if (!argument.has_value()) {
+        return true;
+    }
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    const char *end            = argument->data() + argument->size();
+    const auto [parsed, error] = std::from_chars(argument->data(), end, value);
+    if (error != std::errc() || parsed != end) {
+        std::cerr << "Error parsing arguments:\n" << prefix << *argument << " is not a whole number" << std::endl;
+        return false;
+    }
+    return true;
+}
 
 void framebuffer_size_callback([[maybe_unused]] GLFWwindow *window, int width, int height) {
     glViewport(0, 0, width, height);
 }
 
+// One line of the memory report, in MiB
+void printMemoryUsage(std::string_view name, const MemoryUsage &usage) {
+    std::cout << std::format("Memory | {} | CPU {:.2f} MiB | mapped {:.2f} MiB | buffers {:.2f} MiB | textures {:.2f} "
+                             "MiB | {} GL objects",
+                             name,
+                             static_cast<double>(usage.cpuBytes) / (1024.0 * 1024.0),
+                             static_cast<double>(usage.mappedBytes) / (1024.0 * 1024.0),
+                             static_cast<double>(usage.bufferBytes) / (1024.0 * 1024.0),
+                             static_cast<double>(usage.textureBytes) / (1024.0 * 1024.0),
+                             usage.glObjects)
+              << std::endl;
+}
+
 void processImput(GLFWwindow *window) {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
         glfwSetWindowShouldClose(window, GL_TRUE);
     }
 }
 
-int main() {
+int main(int argc, char **argv) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    const std::vector<std::string_view> arguments(argv + 1, argv + argc);
+    const bool syncLoad       = std::ranges::find(arguments, "--sync-load") != arguments.end();
+    const bool cullBenchmark  = std::ranges::find(arguments, "--cull-benchmark") != arguments.end();
+    const bool lightBenchmark = std::ranges::find(arguments, "--light-benchmark") != arguments.end();
+    const bool jobBenchmark   = std::ranges::find(arguments, "--job-benchmark") != arguments.end();
+
+    if (std::ranges::find(arguments, "--scene-benchmark") != arguments.end()) {
+        Benchmarks::runSceneGraph();
+    }
+
+    // --quantize stores 16 byte vertices with 10_10_10_2 normals, --quantize=octahedral with octahedral normals
+    Mesh::VertexFormat vertexFormat = Mesh::FLOAT32;
+    if (std::ranges::find(arguments, "--quantize") != arguments.end()) {
+        vertexFormat = Mesh::QUANTIZED;
+    } else if (std::ranges::find(arguments, "--quantize=octahedral") != arguments.end()) {
+        vertexFormat = Mesh::QUANTIZED_OCTAHEDRAL;
+    }
+
+    // the meshes only keep their occluders once uploaded, --keep-geometry also keeps a copy of the vertices and indices
+    uint32_t retention = Mesh::RETAIN_OCCLUDER;
+    if (std::ranges::find(arguments, "--keep-geometry") != arguments.end()) {
+        retention |= Mesh::RETAIN_GEOMETRY;
+    }
+
+    // per-frame uniforms and instances are written into persistently mapped buffers when the driver has
+    // ARB_buffer_storage, --no-persistent-buffers maps the written range of a plain buffer every frame instead
+    StreamBuffer::setPersistentMapping(std::ranges::find(arguments, "--no-persistent-buffers") == arguments.end());
+
+    // --instances=N draws N teapots on top of the scene, I switches between instanced and per-object draws
+    size_t instanceCount = 0;
+    if (!numericArgument(arguments, "--instances=", instanceCount)) {
+        return 1;
+    }
+
+    // --lights=N adds N point and spot lights circling the scene on top of the camera light
+    size_t lightCount = 0;
+    if (!numericArgument(arguments, "--lights=", lightCount)) {
+        return 1;
+    }
+
+    // --benchmark=<path> replays a camera path in a hidden window for --frames=N frames and writes a JSON report to
+    // --report=<file>, --dump-frames=<directory> also saves every frame as a PNG. The models are loaded up front.
+    const auto benchmarkArgument = argumentValue(arguments, "--benchmark=");
+    const bool headless          = benchmarkArgument.has_value();
+
+    size_t benchmarkFrames = 600;
+    if (!numericArgument(arguments, "--frames=", benchmarkFrames)) {
+        return 1;
+    }
+    const auto reportArgument = argumentValue(arguments, "--report=");
+    const auto reportPath     = std::filesystem::path(reportArgument.value_or("benchmark.json"));
+    const auto dumpArgument   = argumentValue(arguments, "--dump-frames=");
+
+    // T writes the profiler's trace of the last frames to --trace=<file>, which is also written on exit when given
+    const auto traceArgument = argumentValue(arguments, "--trace=");
+    const auto tracePath     = std::filesystem::path(traceArgument.value_or("trace.json"));
+    bool       traceKeyDown  = false;
+
+    // textures are block compressed and cached as KTX files next to the sources, --uncompressed-textures keeps the raw
+    // RGB(A)8 upload with generated mip levels to compare against
+    CompressedImage::setEnabled(std::ranges::find(arguments, "--uncompressed-textures") == arguments.end());
+
+    // --texture-budget=<MiB> caps the GPU memory of the textures, the finest levels are dropped to stay below it
+    size_t textureBudget = 0;
+    if (!numericArgument(arguments, "--texture-budget=", textureBudget)) {
+        return 1;
+    }
+    if (argumentValue(arguments, "--texture-budget=").has_value()) {
+        TextureManager::shared().setBudget(textureBudget * 1024 * 1024);
+    }
+
     GLFWwindow           *window     = nullptr;
     constexpr int         width      = 1280;
     constexpr int         height     = 720;
     constexpr const char *windowName = "LearnOpenGL";
 
+    std::optional<CameraPath>      cameraPath;
+    std::optional<OffscreenTarget> offscreen;
+
     try {
-        window = createMainWindow(width, height, windowName);
+        window = createMainWindow(width, height, windowName, !headless);
         glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
         glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
         // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-    } catch (const std::string &error) {
-        std::cerr << "Error creating window:\n" << error << std::endl;
+
+        if (headless) {
+            cameraPath = CameraPath::load(fs_helpers::getPathToBenchmark(std::string(*benchmarkArgument)));
+            offscreen.emplace(width, height);
+            offscreen->bind();
+
+            if (dumpArgument) {
+                std::filesystem::create_directories(*dumpArgument);
+            }
+        }
+    } catch (const std::runtime_error &error) {
+        std::cerr << "Error creating window:\n" << error.what() << std::endl;
         return 1;
     }
 
     glEnable(GL_DEPTH_TEST);
 
-    Model teapot("teapot/teapot.obj");
-    Model backpack("backpack/backpack.obj");
-    Model yoda("yoda/yoda.obj");
+    // the models are imported in the background and show up once their geometry is uploaded
+    constexpr size_t uploadBudget = 4 * 1024 * 1024; // texture bytes per frame
+    AssetStreamer    streamer(uploadBudget);
+    TextureManager::shared().setUploadBudget(uploadBudget);
+
+    const std::array models{streamer.request("backpack/backpack.obj", vertexFormat, retention),
+                            streamer.request("teapot/teapot.obj", vertexFormat, retention),
+                            streamer.request("yoda/yoda.obj", vertexFormat, retention)};
+
+    // --job-benchmark needs the teapot
+    if (syncLoad || headless || jobBenchmark) {
+        while (!streamer.isIdle()) {
+            streamer.update();
+            std::this_thread::yield();
+        }
+    }
 
-    Shader defaultShader;
+    // every material is drawn with the variant for the maps it has, the full one is built up front to catch errors
+    ShaderVariants defaultShaders("default.vert", "default.frag", [](const Shader &shader) {
+        FrameUniforms::attach(shader);
+        LightClusters::attach(shader);
+    });
 
     try {
-        defaultShader.add("default.vert", Shader::VERTEX);
-        defaultShader.add("default.frag", Shader::FRAGMENT);
-        defaultShader.link();
+        defaultShaders.get(ShaderVariants::ALL_FEATURES);
     } catch (const std::runtime_error &error) {
         std::cerr << "Error creating shaders:\n" << error.what() << std::endl;
         return 1;
@@ -58,53 +229,425 @@ int main() {
 
     glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
 
-    defaultShader.use();
+    FrameUniforms frameUniforms;
+
+    FrameUniforms::Data frameData{};
 
     glm::vec3 lightColor(1.0f, 1.0f, 1.0f);
-    defaultShader.setVec3("lightColor", lightColor);
+    frameData.lightColor = glm::vec4(lightColor, 1.0f);
 
     glm::vec3 ambientColor(0.2f, 0.2f, 0.2f);
-    defaultShader.setVec3("ambientColor", ambientColor);
+    frameData.ambientLightColor = glm::vec4(ambientColor, 1.0f);
 
     glm::mat4 model(1.0f);
     model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
     // model = glm::scale(model, glm::vec3(0.1f, 0.1f, 0.1f));
-    defaultShader.setMat4("model", model);
+
+    // every model hangs below its own root, the node hierarchy of the file is kept below it
+    SceneGraph                      scene;
+    std::vector<SceneGraph::NodeId> roots;
+    for (size_t i = 0; i < models.size(); i++) {
+        roots.push_back(scene.add(SceneGraph::NONE, model));
+    }
+
+    float spin = 0.0f;
+
+    const std::vector<Model::Instance> instances       = Benchmarks::createInstanceGrid(instanceCount, model);
+    bool                               instanceKeyDown = false;
+
+    LightClusters                           lightClusters;
+    const std::vector<LightClusters::Light> sceneLights =
+            Benchmarks::createLights(lightCount, glm::vec3(0.0f, 0.0f, -100.0f), glm::vec3(150.0f, 20.0f, 150.0f));
+    lightClusters.getLights() = sceneLights;
+    float lightAngle          = 0.0f;
+
+    // meshes hidden behind the large ones are culled on the CPU, --no-occlusion starts without it and O toggles it
+    OcclusionCuller occlusionCuller;
+    bool            occlusionEnabled = std::ranges::find(arguments, "--no-occlusion") == arguments.end();
+    bool            occlusionKeyDown = false;
+
+    // M prints what every model and every part of the renderer holds
+    bool memoryKeyDown = false;
 
     Input::Init(window);
     Camera camera(window);
 
+    if (cullBenchmark) {
+        Benchmarks::runCulling(camera.getFrustum(), camera.getPosition());
+    }
+    if (lightBenchmark) {
+        Benchmarks::runLightBinning(camera);
+    }
+    if (Model *teapot = streamer.get(models[1]); jobBenchmark && teapot != nullptr) {
+        Benchmarks::runJobSystem(*teapot, defaultShaders, camera, model);
+    }
+
+    // the per-second report of every system is off unless --stats is given, P toggles it
+    RenderQueue renderQueue;
+    bool        reportEnabled = std::ranges::find(arguments, "--stats") != arguments.end();
+    bool        reportKeyDown = false;
+    double      lastReport    = glfwGetTime();
+    double      cpuTime       = 0.0; // milliseconds spent building and submitting frames since the last report
+    size_t      frames        = 0;
+
+    BenchmarkRecorder recorder(headless ? benchmarkFrames : 0);
+    auto              endPhase = [&](BenchmarkRecorder::Phase phase) {
+        if (headless) {
+            recorder.endPhase(phase);
+        }
+    };
+
     try {
-        while (glfwWindowShouldClose(window) == GL_FALSE) {
-            processImput(window);
-            camera.update();
+        while (glfwWindowShouldClose(window) == GL_FALSE &&
+               (!headless || recorder.recordedFrames() < benchmarkFrames)) {
+            const auto frameStart = std::chrono::steady_clock::now();
+
+            if (headless) {
+                // fixed steps, so every run renders the same frames no matter how fast it goes
+                recorder.beginFrame();
+                const auto  steps = static_cast<float>(std::max<size_t>(benchmarkFrames, 2) - 1);
+                const float time  = static_cast<float>(recorder.recordedFrames()) * cameraPath->duration() / steps;
 
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // NOLINT(hicpp-signed-bitwise)
+                const CameraPath::Keyframe pose = cameraPath->sample(time);
+                camera.setPose(pose.position, pose.rotation);
+            } else {
+                processImput(window);
+                PROFILE_ZONE("Camera::update");
+                camera.update();
+            }
+
+            {
+                PROFILE_GPU_ZONE("clear");
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // NOLINT(hicpp-signed-bitwise)
+            }
 
             // if (Input::isKeyPressed(GLFW_KEY_P)) {
-            defaultShader.setVec3("lightPos", camera.getPosition());
+            frameData.lightPos = glm::vec4(camera.getPosition(), 1.0f);
             // }
 
-            defaultShader.setVec3("viewPos", camera.getPosition());
-            defaultShader.setMat4("view", camera.getView());
-            defaultShader.setMat4("projection", camera.getProjection());
+            // fixed steps like the camera path, so benchmark runs light the same frames
+            lightAngle += glm::radians(0.2f);
+            const glm::mat4 lightRotation = glm::rotate(glm::mat4(1.0f), lightAngle, glm::vec3(0.0f, 1.0f, 0.0f));
+            for (size_t i = 0; i < sceneLights.size(); i++) {
+                const glm::vec4 position              = lightRotation * glm::vec4(sceneLights[i].position, 1.0f);
+                lightClusters.getLights()[i].position = glm::vec3(position);
+            }
+
+            lightClusters.build(camera.getView(), camera.getProjection(), camera.getNear(), camera.getFar());
+            lightClusters.upload();
+
+            // the shader finds the froxel from gl_FragCoord, so the tiles follow the framebuffer through resizes
+            // and HiDPI scaling, the offscreen target of a benchmark keeps the requested size
+            int framebufferWidth  = width;
+            int framebufferHeight = height;
+            if (!headless) {
+                glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+            }
+
+            frameData.viewPos           = glm::vec4(camera.getPosition(), 1.0f);
+            frameData.view              = camera.getView();
+            frameData.projection        = camera.getProjection();
+            frameData.clusterParameters = lightClusters.getShaderParameters(framebufferWidth, framebufferHeight);
+            frameUniforms.upload(frameData);
+
+            streamer.update();
+
+            for (size_t i = 0; i < models.size(); i++) {
+                Model *loaded = streamer.get(models.at(i));
+                if (loaded != nullptr && !loaded->isAttached()) {
+                    loaded->attach(scene, roots.at(i));
+                }
+            }
+
+            // R spins the last model, only its subtree gets recomputed
+            if (Input::isKeyPressed(GLFW_KEY_R)) {
+                spin += glm::radians(1.0f);
+                scene.setLocal(roots.back(), glm::rotate(model, spin, glm::vec3(0.0f, 0.0f, 1.0f)));
+            }
+
+            if (Input::isKeyPressed(GLFW_KEY_I) && !instanceKeyDown) {
+                renderQueue.setInstancing(!renderQueue.isInstancing());
+            }
+            instanceKeyDown = Input::isKeyPressed(GLFW_KEY_I);
+
+            if (Input::isKeyPressed(GLFW_KEY_O) && !occlusionKeyDown) {
+                occlusionEnabled = !occlusionEnabled;
+            }
+            occlusionKeyDown = Input::isKeyPressed(GLFW_KEY_O);
+
+            if (Input::isKeyPressed(GLFW_KEY_P) && !reportKeyDown) {
+                // the first report after turning it on only averages the frames since then
+                reportEnabled = !reportEnabled;
+                lastReport    = glfwGetTime();
+                cpuTime       = 0.0;
+                frames        = 0;
+            }
+            reportKeyDown = Input::isKeyPressed(GLFW_KEY_P);
+
+            scene.update();
+            endPhase(BenchmarkRecorder::UPDATE_PHASE);
+
+            OcclusionCuller *occlusion = occlusionEnabled ? &occlusionCuller : nullptr;
+            if (occlusion != nullptr) {
+                occlusion->begin(camera.getProjection() * camera.getView());
+            }
+
+            for (const auto handle : models) {
+                if (Model *loaded = streamer.get(handle)) {
+                    loaded->submit(renderQueue, defaultShaders, scene, camera, occlusion);
+                }
+            }
+
+            if (Model *teapot = streamer.get(models[1]); teapot != nullptr && !instances.empty()) {
+                teapot->submitInstances(renderQueue, defaultShaders, instances, camera, occlusion);
+            }
+
+            if (occlusion != nullptr) {
+                occlusion->render();
+            }
 
-            backpack.Draw(defaultShader);
-            teapot.Draw(defaultShader);
-            yoda.Draw(defaultShader);
+            TextureManager::shared().update();
 
-            glfwSwapBuffers(window);
+            endPhase(BenchmarkRecorder::SUBMIT_PHASE);
+
+            {
+                PROFILE_GPU_ZONE("RenderQueue::execute");
+                renderQueue.execute(camera.getFrustum(), occlusion);
+            }
+            endPhase(BenchmarkRecorder::EXECUTE_PHASE);
+
+            if (headless) {
+                glFinish();
+                if (dumpArgument) {
+                    offscreen->savePng(std::filesystem::path(*dumpArgument) /
+                                       std::format("frame_{:05}.png", recorder.recordedFrames()));
+                }
+                recorder.endPhase(BenchmarkRecorder::FINISH_PHASE);
+                recorder.endFrame(renderQueue.getStats());
+            }
+
+            cpuTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+            frames++;
+
+            const double now = glfwGetTime();
+            if (reportEnabled && now - lastReport >= 1.0) {
+                const RenderQueue::Stats &stats = renderQueue.getStats();
+                std::cout << std::format("RenderQueue | {} | {} draws for {} instances | {:.2f} ms CPU/frame | {} "
+                                         "program switches | {} texture binds | {} VAO binds",
+                                         renderQueue.isInstancing() ? "instanced" : "per-object",
+                                         stats.draws,
+                                         stats.instances,
+                                         cpuTime / static_cast<double>(frames),
+                                         stats.programSwitches,
+                                         stats.textureBinds,
+                                         stats.vaoBinds)
+                          << std::endl;
+                cpuTime = 0.0;
+                frames  = 0;
+
+                std::cout << std::format("LOD | {} triangles submitted | {} at full detail | {:.1f}%",
+                                         stats.triangles,
+                                         stats.fullTriangles,
+                                         stats.fullTriangles == 0 ? 100.0
+                                                                  : 100.0 * static_cast<double>(stats.triangles) /
+                                                                            static_cast<double>(stats.fullTriangles))
+                          << std::endl;
+
+                const SceneGraph::Stats &sceneStats = scene.getStats();
+                std::cout << std::format("SceneGraph | {} nodes | {} updated in {} subtrees | {:.3f} ms",
+                                         sceneStats.nodes,
+                                         sceneStats.updatedNodes,
+                                         sceneStats.dirtyRoots,
+                                         sceneStats.milliseconds)
+                          << std::endl;
+
+                const FrustumCuller::Stats &culling = renderQueue.getCullStats();
+                std::cout << std::format("FrustumCuller | {} visible | {} culled | {:.3f} ms",
+                                         culling.visible,
+                                         culling.culled,
+                                         culling.milliseconds)
+                          << std::endl;
+
+                if (occlusionEnabled) {
+                    const OcclusionCuller::Stats &occlusionStats = occlusionCuller.getStats();
+                    std::cout << std::format("OcclusionCuller | {} occluders | {} triangles | {} of {} tested "
+                                             "occluded | raster {:.3f} ms | test {:.3f} ms",
+                                             occlusionStats.occluders,
+                                             occlusionStats.triangles,
+                                             occlusionStats.occluded,
+                                             occlusionStats.tested,
+                                             occlusionStats.rasterMilliseconds,
+                                             occlusionStats.testMilliseconds)
+                              << std::endl;
+                }
+
+                const GeometryArena::Stats arena = GeometryArena::forFormat(vertexFormat).getStats();
+                std::cout << std::format("GeometryArena | {} B/vertex | vertices {:.1f} / {:.1f} MiB | indices {:.1f} / "
+                                         "{:.1f} MiB | {} free blocks | {:.1f}% fragmented",
+                                         Mesh::vertexSize(vertexFormat),
+                                         static_cast<double>(arena.vertexBytesUsed) / (1024.0 * 1024.0),
+                                         static_cast<double>(arena.vertexBytesCapacity) / (1024.0 * 1024.0),
+                                         static_cast<double>(arena.indexBytesUsed) / (1024.0 * 1024.0),
+                                         static_cast<double>(arena.indexBytesCapacity) / (1024.0 * 1024.0),
+                                         arena.freeBlocks,
+                                         arena.fragmentation * 100.0f)
+                          << std::endl;
+
+                std::cout << std::format("ShaderVariants | default | {} of {} variants in use",
+                                         defaultShaders.size(),
+                                         ShaderVariants::ALL_FEATURES + 1)
+                          << std::endl;
+
+                const LightClusters::Stats &lights = lightClusters.getStats();
+                std::cout << std::format("LightClusters | {} lights | {} references in {} of {} froxels | at most {} "
+                                         "per froxel | {} dropped | {:.3f} ms",
+                                         lights.lights,
+                                         lights.references,
+                                         lights.occupied,
+                                         LightClusters::FROXEL_COUNT,
+                                         lights.maxPerFroxel,
+                                         lights.dropped,
+                                         lights.milliseconds)
+                          << std::endl;
+
+                const TextureManager::Stats textures = TextureManager::shared().getStats();
+                std::cout << std::format("TextureManager | {} textures | resident {:.1f} / {:.1f} MiB | requested "
+                                         "{:.1f} MiB | {} levels evicted",
+                                         textures.textures,
+                                         static_cast<double>(textures.residentBytes) / (1024.0 * 1024.0),
+                                         static_cast<double>(textures.budgetBytes) / (1024.0 * 1024.0),
+                                         static_cast<double>(textures.requestedBytes) / (1024.0 * 1024.0),
+                                         textures.evictions)
+                          << std::endl;
+
+                const std::array<std::pair<std::string_view, const StreamBuffer::Stats *>, 2> streams{{
+                        {"uniforms", &frameUniforms.getStreamStats()},
+                        {"instances", &renderQueue.getStreamStats()},
+                }};
+                for (const auto &[name, stream] : streams) {
+                    std::cout << std::format("StreamBuffer | {} | {} | {:.1f} KiB this frame | waited {:.3f} ms | {} "
+                                             "stalls, {:.3f} ms in total",
+                                             name,
+                                             stream->persistent ? "persistent" : "unsynchronized",
+                                             static_cast<double>(stream->frameBytes) / 1024.0,
+                                             stream->waitMilliseconds,
+                                             stream->stalls,
+                                             stream->totalWaitMilliseconds)
+                              << std::endl;
+                }
+
+                if (!streamer.isIdle()) {
+                    const AssetStreamer::Stats streaming = streamer.getStats();
+                    std::cout << std::format("AssetStreamer | uploaded {} / {} KiB this frame | {} KiB in {} "
+                                             "textures queued | {} models importing",
+                                             streaming.uploadedBytes / 1024,
+                                             streaming.budgetBytes / 1024,
+                                             streaming.queuedBytes / 1024,
+                                             streaming.queuedTextures,
+                                             streaming.pendingModels)
+                              << std::endl;
+                }
+                lastReport = now;
+            }
+
+            if (!headless) {
+                PROFILE_GPU_ZONE("swap");
+                glfwSwapBuffers(window);
+            }
+            PROFILE_FRAME();
             glfwPollEvents();
+
+            if (Input::isKeyPressed(GLFW_KEY_T) && !traceKeyDown) {
+                try {
+                    Profiler::shared().exportChromeTrace(tracePath);
+                    std::cout << "Profiler | trace written to " << tracePath.string() << std::endl;
+                } catch (const std::runtime_error &error) {
+                    std::cerr << error.what() << std::endl;
+                }
+            }
+            traceKeyDown = Input::isKeyPressed(GLFW_KEY_T);
+
+            if (Input::isKeyPressed(GLFW_KEY_M) && !memoryKeyDown) {
+                // the models share the arenas and textures, only their CPU side adds to the total
+                MemoryUsage total;
+                for (const auto handle : models) {
+                    if (const Model *loaded = streamer.get(handle)) {
+                        const MemoryUsage usage = loaded->getMemoryUsage();
+                        printMemoryUsage(loaded->getName(), usage);
+                        total.cpuBytes += usage.cpuBytes;
+                    }
+                }
+
+                for (uint32_t format = 0; format < Mesh::VERTEX_FORMAT_COUNT; format++) {
+                    const auto        arenaFormat = static_cast<Mesh::VertexFormat>(format);
+                    const MemoryUsage usage       = GeometryArena::forFormat(arenaFormat).getMemoryUsage();
+                    if (usage.glObjects > 0) {
+                        printMemoryUsage(std::format("GeometryArena {} B/vertex", Mesh::vertexSize(arenaFormat)),
+                                         usage);
+                    }
+                    total += usage;
+                }
+
+                const std::array<std::pair<std::string_view, MemoryUsage>, 8> parts{{
+                        {"TextureManager", TextureManager::shared().getMemoryUsage()},
+                        {"AssetStreamer", streamer.getMemoryUsage()},
+                        {"MaterialLibrary", MaterialLibrary::shared().getMemoryUsage()},
+                        {"ShaderVariants", defaultShaders.getMemoryUsage()},
+                        {"RenderQueue", renderQueue.getMemoryUsage()},
+                        {"LightClusters", lightClusters.getMemoryUsage()},
+                        {"OcclusionCuller", occlusionCuller.getMemoryUsage()},
+                        {"FrameUniforms", frameUniforms.getMemoryUsage()},
+                }};
+                for (const auto &[name, usage] : parts) {
+                    printMemoryUsage(name, usage);
+                    total += usage;
+                }
+                printMemoryUsage("total", total);
+            }
+            memoryKeyDown = Input::isKeyPressed(GLFW_KEY_M);
         }
     } catch (const std::runtime_error &error) {
         std::cerr << "Error running main loop:\n" << error.what() << std::endl;
         return 1;
     }
 
-    backpack.deleteModel();
-    teapot.deleteModel();
-    yoda.deleteModel();
-    defaultShader.deleteShader();
+    if (headless) {
+        try {
+            recorder.writeReport(reportPath,
+                                 {std::string(*benchmarkArgument),
+                                  width,
+                                  height,
+                                  vertexFormat == Mesh::FLOAT32 ? "float32"
+                                  : vertexFormat == Mesh::QUANTIZED ? "quantized"
+                                                                    : "quantized_octahedral",
+                                  instanceCount,
+                                  renderQueue.isInstancing()});
+            std::cout << std::format("Benchmark | {} frames | report written to {}",
+                                     recorder.recordedFrames(),
+                                     reportPath.string())
+                      << std::endl;
+        } catch (const std::runtime_error &error) {
+            std::cerr << "Error writing benchmark report:\n" << error.what() << std::endl;
+            return 1;
+        }
+        offscreen->deleteTarget();
+    }
+
+    if (traceArgument) {
+        Profiler::shared().exportChromeTrace(tracePath);
+    }
+    Profiler::shared().deleteQueries();
+
+    streamer.deleteAll();
+    TextureManager::shared().deleteTextures();
+    MaterialLibrary::shared().deleteFallbacks();
+    for (uint32_t format = 0; format < Mesh::VERTEX_FORMAT_COUNT; format++) {
+        GeometryArena::forFormat(static_cast<Mesh::VertexFormat>(format)).deleteBuffers();
+    }
+    renderQueue.deleteBuffers();
+    frameUniforms.deleteBuffer();
+    lightClusters.deleteBuffers();
+    defaultShaders.deleteShaders();
 
     glfwTerminate();
     return 0;
@@ -4,70 +4,119 @@ out vec4 FragColor;
 in vec2 TexCoords;
 in vec3 FragPos;
 in vec3 Normal;
+in vec4 Tint;
 
+// the maps a material has, see ShaderVariants. A missing map behaves like its fallback texture: white diffuse and
+// roughness, no specular highlight.
+#ifdef HAS_DIFFUSE_MAP
 uniform sampler2D texture_diffuse1;
+#endif
+#ifdef HAS_SPECULAR_MAP
 uniform sampler2D texture_specular1;
+#endif
+#ifdef HAS_ROUGHNESS_MAP
 uniform sampler2D texture_roughness1;
+#endif
 
 uniform float material_shininess;
 
-uniform vec3 ambientLightColor;
-uniform vec3 lightPos;
-uniform vec3 lightColor;
-uniform vec3 viewPos;
-
-struct attenuation_t {
-    float constant;
-    float linear;
-    float quadratic;
+// shared by all programs, see FrameUniforms
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+    vec4 lightPos;
+    vec4 lightColor;
+    vec4 ambientLightColor;
+    vec4 clusterParameters;
 };
 
-struct lightColor_t {
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
+// lights binned into froxels by LightClusters, the grid must match LightClusters::GRID_*
+const ivec3 CLUSTER_GRID = ivec3(16, 9, 24);
 
-struct directionalLight_t {
-    vec3 direction;
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
+uniform samplerBuffer clusterLightData;     // position and range, color and spot scale, direction and spot offset
+uniform usamplerBuffer clusterRanges;       // first index and light count per froxel
+uniform usamplerBuffer clusterLightIndices;
 
-struct pointLight_t {
-    vec3 position;
-    lightColor_t color;
-    attenuation_t attenuation;
+struct surface_t {
+    vec3 normal;
+    vec3 viewDir;
+    vec3 albedo;
+    float specular;
+    float exponent;
 };
 
-struct spotLight_t {
-    vec3 position;
-    lightColor_t color;
-    attenuation_t attenuation;
-    vec3 direction;
-    float cutOff;
-    float outerCutOff;
-};
+vec3 shade(surface_t surface, vec3 lightDir, vec3 radiance) {
+    float diffuse = max(dot(surface.normal, lightDir), 0.0);
+    vec3 result = diffuse * radiance * surface.albedo;
 
-void main() {
-    vec3 normal = normalize(Normal);
-    vec3 lightDir = normalize(lightPos - FragPos);
+#ifdef HAS_SPECULAR_MAP
+    vec3 reflectDir = reflect(-lightDir, surface.normal);
+    result += surface.specular * pow(max(dot(reflectDir, surface.viewDir), 0.0), surface.exponent) * radiance;
+#endif
 
-    vec3 viewDir = normalize(viewPos - FragPos);
-    vec3 reflectDir = reflect(-lightDir, normal);
+    return result;
+}
 
-    vec3 ambientColor = ambientLightColor * texture(texture_diffuse1, TexCoords).rgb;
+// index of the froxel the fragment lies in, the tile from the window position and the slice from the view depth
+int froxelIndex() {
+    float depth = -(view * vec4(FragPos, 1.0)).z;
+    int slice = int(log(max(depth, 1e-4)) * clusterParameters.z + clusterParameters.w);
+    ivec2 tile = ivec2(gl_FragCoord.xy / clusterParameters.xy);
 
-    float diffuse = max(dot(normal, lightDir), 0.0);
-    vec3 diffuseColor = diffuse * lightColor * texture(texture_diffuse1, TexCoords).rgb;
+    ivec3 froxel = clamp(ivec3(tile, slice), ivec3(0), CLUSTER_GRID - 1);
+    return froxel.x + froxel.y * CLUSTER_GRID.x + froxel.z * CLUSTER_GRID.x * CLUSTER_GRID.y;
+}
 
-    float exponent = texture(texture_roughness1, TexCoords).r * material_shininess;
+vec3 shadeClusteredLights(surface_t surface) {
+    vec3 result = vec3(0.0);
 
-    vec3 specular = pow(max(dot(reflectDir, viewDir), 0.0), exponent) * lightColor;
-    vec3 specularColor = texture(texture_specular1, TexCoords).r * specular;
+    uvec2 range = texelFetch(clusterRanges, froxelIndex()).xy;
+    for (uint i = 0u; i < range.y; i++) {
+        int light = int(texelFetch(clusterLightIndices, int(range.x + i)).r) * 3;
+        vec4 positionRange = texelFetch(clusterLightData, light);
+        vec4 colorSpotScale = texelFetch(clusterLightData, light + 1);
+        vec4 directionSpotOffset = texelFetch(clusterLightData, light + 2);
 
-    vec3 result = ambientColor + diffuseColor + specularColor;
+        vec3 toLight = positionRange.xyz - FragPos;
+        float distance2 = max(dot(toLight, toLight), 1e-8);
+        vec3 lightDir = toLight * inversesqrt(distance2);
 
-    FragColor = vec4(diffuseColor, 1.0);
-}
\ No newline at end of file
+        // inverse square falloff windowed to reach 0 at the range
+        float window = clamp(1.0 - pow(distance2 / (positionRange.w * positionRange.w), 2.0), 0.0, 1.0);
+        float attenuation = window * window / (distance2 + 1.0);
+
+        // point lights have a scale of 0 and an offset of 1
+        float spot = clamp(dot(-lightDir, directionSpotOffset.xyz) * colorSpotScale.w + directionSpotOffset.w, 0.0, 1.0);
+
+        result += shade(surface, lightDir, colorSpotScale.rgb * attenuation * spot * spot);
+    }
+
+    return result;
+}
+
+void main() {
+    surface_t surface;
+    surface.normal = normalize(Normal);
+    surface.viewDir = normalize(viewPos.xyz - FragPos);
+
+    surface.albedo = Tint.rgb;
+#ifdef HAS_DIFFUSE_MAP
+    surface.albedo *= texture(texture_diffuse1, TexCoords).rgb;
+#endif
+
+    surface.specular = 0.0;
+    surface.exponent = material_shininess;
+#ifdef HAS_SPECULAR_MAP
+    surface.specular = texture(texture_specular1, TexCoords).r;
+#ifdef HAS_ROUGHNESS_MAP
+    surface.exponent *= texture(texture_roughness1, TexCoords).r;
+#endif
+#endif
+
+    vec3 result = ambientLightColor.rgb * surface.albedo;
+    result += shade(surface, normalize(lightPos.xyz - FragPos), lightColor.rgb);
+    result += shadeClusteredLights(surface);
+
+    FragColor = vec4(result, 1.0);
+}
@@ -3,18 +3,49 @@ layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec2 aTexCoords;
 
+// per instance, see InstanceBuffer
+layout(location = 3) in mat4 aModel;
+layout(location = 7) in mat3 aNormalMatrix;
+layout(location = 10) in vec4 aTint;
+
 out vec2 TexCoords;
 out vec3 FragPos;
 out vec3 Normal;
+out vec4 Tint;
+
+// shared by all programs, see FrameUniforms
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+    vec4 lightPos;
+    vec4 lightColor;
+    vec4 ambientLightColor;
+    vec4 clusterParameters;
+};
+
+// per-mesh vertex decoding, see Mesh::bindUniforms. Float vertices keep the identity transform.
+uniform vec3 positionOffset = vec3(0.0);
+uniform vec3 positionScale = vec3(1.0);
+uniform bool octahedralNormals = false;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+vec3 decodeOctahedral(vec2 encoded) {
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-normal.z, 0.0);
+    normal.x += normal.x >= 0.0 ? -fold : fold;
+    normal.y += normal.y >= 0.0 ? -fold : fold;
+    return normalize(normal);
+}
 
 void main() {
-    // TODO: calculate the normal matrix on the CPU once and pass it to the shader as a uniform
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    vec3 position = positionOffset + aPos * positionScale;
+    vec3 normal = octahedralNormals ? decodeOctahedral(aNormal.xy) : aNormal;
+
+    vec4 worldPos = aModel * vec4(position, 1.0);
+
+    Normal = aNormalMatrix * normal;
     TexCoords = aTexCoords;
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
-    FragPos = vec3(model * vec4(aPos, 1.0));
+    Tint = aTint;
+    gl_Position = projection * view * worldPos;
+    FragPos = vec3(worldPos);
 }
\ No newline at end of file